@@ -0,0 +1,95 @@
+#ifndef INCLUDED_ARENA_HH
+#define INCLUDED_ARENA_HH 1
+
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "Board.hh"
+
+
+/**
+ * A stack of reusable objects allocated in cache-line-aligned chunks. Popped
+ * objects are not destroyed but kept for the next push, and chunks are never
+ * freed or moved until the stack is destroyed, so references to elements stay
+ * valid while the stack grows and a warmed-up stack never allocates.
+ */
+template <typename T, std::size_t chunkSize = 32>
+class ArenaStack {
+
+private:
+
+    struct Chunk {
+        T items[chunkSize];
+    };
+
+    std::vector<Chunk *> mChunks;
+    std::size_t mSize = 0;
+
+    static Chunk *allocateChunk() {
+        void *memory;
+        std::size_t alignment = alignof(Chunk) < cacheLineSize ?
+                cacheLineSize : alignof(Chunk);
+        if (posix_memalign(&memory, alignment, sizeof(Chunk)) != 0)
+            throw std::bad_alloc();
+        try {
+            return new (memory) Chunk();
+        } catch (...) {
+            std::free(memory);
+            throw;
+        }
+    }
+
+public:
+
+    ArenaStack() = default;
+    ArenaStack(const ArenaStack &stack) = delete;
+    ArenaStack &operator=(const ArenaStack &stack) = delete;
+
+    ~ArenaStack() {
+        for (Chunk *chunk : mChunks) {
+            chunk->~Chunk();
+            std::free(chunk);
+        }
+    }
+
+    std::size_t size() const noexcept {
+        return mSize;
+    }
+
+    T &operator[](std::size_t index) noexcept {
+        return mChunks[index / chunkSize]->items[index % chunkSize];
+    }
+
+    T &top() noexcept {
+        return (*this)[mSize - 1];
+    }
+
+    /**
+     * Returns the next object, which keeps whatever value it had when it was
+     * last popped.
+     */
+    T &push() {
+        if (mSize == mChunks.size() * chunkSize) {
+            mChunks.reserve(mChunks.size() + 1);
+            mChunks.push_back(allocateChunk());
+        }
+        return (*this)[mSize++];
+    }
+
+    void pop() noexcept {
+        mSize--;
+    }
+
+    /** Pops objects until the stack has the given size. */
+    void popTo(std::size_t size) noexcept {
+        mSize = size;
+    }
+
+};
+
+
+#endif // #ifndef INCLUDED_ARENA_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,52 @@
+#include <cstddef>
+#include <cstdint>
+#include "Arena.hh"
+#include "Tester.inl"
+
+
+static void testPushPop() {
+    ArenaStack<int, 4> stack;
+    test_assert(stack.size() == 0);
+
+    for (int i = 0; i < 10; i++)
+        stack.push() = i;
+    test_assert(stack.size() == 10);
+    test_assert(stack.top() == 9);
+    test_assert(stack[5] == 5);
+
+    stack.pop();
+    test_assert(stack.top() == 8);
+    stack.popTo(3);
+    test_assert(stack.size() == 3);
+    test_assert(stack.top() == 2);
+
+    // Popped objects keep their values and are reused.
+    test_assert(stack.push() == 3);
+}
+
+static void testStableReferences() {
+    ArenaStack<Board<PossibilitySet>, 2> stack;
+    Board<PossibilitySet> &first = stack.push();
+    first[Position(4, 4)] = PossibilitySet(7);
+
+    for (int i = 0; i < 20; i++) {
+        Board<PossibilitySet> &board = stack.push();
+        test_assert(reinterpret_cast<std::uintptr_t>(&board) %
+                cacheLineSize == 0);
+    }
+    test_assert(&stack[0] == &first);
+    test_assert(first[Position(4, 4)] == PossibilitySet(7));
+}
+
+static void testAll() {
+    testPushPop();
+    testStableReferences();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <fstream>
+#include "AutoTune.hh"
+#include "Rating.hh"
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+
+static const char *const propagationNames[] = {
+    "singles", "locked", "subsets",
+};
+
+const char *propagationName(Propagation propagation) noexcept {
+    return propagationNames[static_cast<size_t>(propagation)];
+}
+
+bool parsePropagation(const string &name, Propagation &propagation)
+        noexcept {
+    for (size_t i = 0;
+            i < sizeof propagationNames / sizeof *propagationNames; i++) {
+        if (name == propagationNames[i]) {
+            propagation = static_cast<Propagation>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Returns true if one of the techniques made a step on the board. */
+template <size_t count>
+static bool applyAny(
+        const Technique (&techniques)[count],
+        Board<PossibilitySet> &board) {
+    for (Technique technique : techniques)
+        if (applyTechnique(technique, board) > 0)
+            return true;
+    return false;
+}
+
+void setPropagation(SearchOptions &options, Propagation propagation) {
+    static const Technique locked[] = {
+        Technique::LOCKED_CANDIDATES,
+    };
+    static const Technique subsets[] = {
+        Technique::LOCKED_CANDIDATES,
+        Technique::NAKED_PAIR, Technique::HIDDEN_PAIR,
+        Technique::NAKED_TRIPLE, Technique::HIDDEN_TRIPLE,
+    };
+
+    switch (propagation) {
+    case Propagation::SINGLES:
+        options.deduce = nullptr;
+        break;
+    case Propagation::LOCKED:
+        options.deduce = [](Board<PossibilitySet> &board) {
+            return applyAny(locked, board);
+        };
+        break;
+    case Propagation::SUBSETS:
+        options.deduce = [](Board<PossibilitySet> &board) {
+            return applyAny(subsets, board);
+        };
+        break;
+    }
+}
+
+void TuningProfile::apply(SearchOptions &options) const {
+    setPropagation(options, propagation);
+    options.backend = backend;
+    options.tieBreak = tieBreak;
+}
+
+vector<TuningProfile> tuningCandidates() {
+    vector<TuningProfile> candidates;
+    for (Propagation propagation : {Propagation::SINGLES,
+                Propagation::LOCKED, Propagation::SUBSETS}) {
+        for (TieBreak tieBreak : {TieBreak::FIRST, TieBreak::DEGREE}) {
+            TuningProfile profile;
+            profile.propagation = propagation;
+            profile.tieBreak = tieBreak;
+            candidates.push_back(profile);
+        }
+    }
+    TuningProfile bitboard;
+    bitboard.backend = Backend::BITBOARD;
+    candidates.push_back(bitboard);
+    return candidates;
+}
+
+TuningProfile autoTune(
+        const vector<Board<Number>> &sample,
+        const SearchOptions &base,
+        size_t nodeLimit,
+        size_t rounds,
+        vector<BenchmarkResult> *results) {
+    vector<TuningProfile> candidates = tuningCandidates();
+    if (results != nullptr)
+        results->clear();
+
+    // Rounds of the candidates alternate so that a slow spell of the
+    // machine does not fall on one candidate only.
+    vector<BenchmarkResult> best(candidates.size());
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < candidates.size(); i++) {
+            SearchOptions options = base;
+            candidates[i].apply(options);
+            BenchmarkResult result = benchmark(sample, options, nodeLimit);
+            if (round == 0 || result.time < best[i].time)
+                best[i] = result;
+        }
+    }
+
+    size_t winner = 0;
+    for (size_t i = 1; i < candidates.size(); i++) {
+        if (best[i].aborted != best[winner].aborted) {
+            if (best[i].aborted < best[winner].aborted)
+                winner = i;
+            continue;
+        }
+        if (best[i].time < best[winner].time)
+            winner = i;
+    }
+    if (results != nullptr)
+        *results = best;
+    return candidates[winner];
+}
+
+static const char header[] = "sudoku-profile 1";
+
+std::ostream &operator<<(std::ostream &os, const TuningProfile &profile) {
+    return os << header << '\n'
+            << "propagation " << propagationName(profile.propagation) << '\n'
+            << "backend " << backendName(profile.backend) << '\n'
+            << "tie-break " << tieBreakName(profile.tieBreak) << '\n';
+}
+
+/** Reads a line that starts with the keyword and returns the rest of it. */
+static bool readField(std::istream &is, const char *keyword, string &rest) {
+    string line;
+    if (!std::getline(is, line))
+        return false;
+    string prefix = string(keyword) + ' ';
+    if (line.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    rest = line.substr(prefix.size());
+    return true;
+}
+
+std::istream &operator>>(std::istream &is, TuningProfile &profile) {
+    string line, propagation, backend, tieBreak;
+    bool valid = std::getline(is, line) && line == header &&
+            readField(is, "propagation", propagation) &&
+            parsePropagation(propagation, profile.propagation) &&
+            readField(is, "backend", backend) &&
+            parseBackend(backend, profile.backend) &&
+            readField(is, "tie-break", tieBreak) &&
+            parseTieBreak(tieBreak, profile.tieBreak);
+    if (!valid)
+        is.setstate(std::ios::failbit);
+    return is;
+}
+
+bool saveProfile(const string &path, const TuningProfile &profile) {
+    std::ofstream os(path);
+    return static_cast<bool>(os << profile) && os.flush();
+}
+
+bool loadProfile(const string &path, TuningProfile &profile) {
+    std::ifstream is(path);
+    return static_cast<bool>(is >> profile);
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,86 @@
+#ifndef INCLUDED_AUTOTUNE_HH
+#define INCLUDED_AUTOTUNE_HH 1
+
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Benchmark.hh"
+#include "Board.hh"
+#include "Solver.hh"
+
+
+/** How much deduction the search does before it branches. */
+enum class Propagation {
+    /** Naked and hidden singles only, which every backend does. */
+    SINGLES,
+    /** Singles and locked candidates. */
+    LOCKED,
+    /** Singles, locked candidates, and naked and hidden pairs and triples. */
+    SUBSETS,
+};
+
+extern const char *propagationName(Propagation propagation) noexcept;
+
+extern bool parsePropagation(
+        const std::string &name, Propagation &propagation) noexcept;
+
+/**
+ * Sets SearchOptions::deduce to apply the techniques of the propagation
+ * level with applyTechnique, or clears it for SINGLES.
+ */
+extern void setPropagation(SearchOptions &options, Propagation propagation);
+
+/** A search configuration chosen by autoTune. */
+struct TuningProfile {
+    Propagation propagation = Propagation::SINGLES;
+    Backend backend = Backend::CELLS;
+    TieBreak tieBreak = TieBreak::FIRST;
+
+    /** Sets the propagation, backend and tie-break of the options. */
+    void apply(SearchOptions &options) const;
+};
+
+/**
+ * The configurations that autoTune tries: every propagation level with the
+ * FIRST and DEGREE tie-breaks on the cells backend, and singles on the
+ * bitboard backend, which has no deduce hook.
+ */
+extern std::vector<TuningProfile> tuningCandidates();
+
+/**
+ * Solves the sample with every candidate configuration applied to the base
+ * options, "rounds" times each, and returns the configuration with the
+ * least total time in its best round. A configuration that aborts more
+ * problems than another never wins over it. If "results" is not null, the
+ * best round of each configuration is stored there in the order of
+ * tuningCandidates.
+ */
+extern TuningProfile autoTune(
+        const std::vector<Board<Number>> &sample,
+        const SearchOptions &base,
+        std::size_t nodeLimit = SearchBudget::unlimited,
+        std::size_t rounds = 3,
+        std::vector<BenchmarkResult> *results = nullptr);
+
+/**
+ * Writes the profile as text: a header line, then one line for each of the
+ * propagation level, the backend and the tie-break.
+ */
+extern std::ostream &operator<<(
+        std::ostream &os,
+        const TuningProfile &profile);
+
+/** Reads a profile written by operator<<, failing the stream if bad. */
+extern std::istream &operator>>(std::istream &is, TuningProfile &profile);
+
+extern bool saveProfile(const std::string &path, const TuningProfile &profile);
+
+/** Returns false if the file does not exist or is not a profile. */
+extern bool loadProfile(const std::string &path, TuningProfile &profile);
+
+
+#endif // #ifndef INCLUDED_AUTOTUNE_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
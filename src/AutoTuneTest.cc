@@ -0,0 +1,128 @@
+#include <sstream>
+#include <vector>
+#include "AutoTune.hh"
+#include "Board.hh"
+#include "Format.hh"
+#include "Solver.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+static void testNames() {
+    Propagation propagation = Propagation::SINGLES;
+    test_assert(parsePropagation("subsets", propagation));
+    test_assert(propagation == Propagation::SUBSETS);
+    test_assert(!parsePropagation("pairs", propagation));
+    test_assert(propagation == Propagation::SUBSETS);
+    test_assert(std::string(propagationName(Propagation::LOCKED)) ==
+            "locked");
+}
+
+static void testPropagation() {
+    Board<Number> problem, expected, solution;
+    parseLine(hardProblemLine, problem);
+    SearchBudget singlesBudget;
+    test_assert(solve(problem, expected, singlesBudget) ==
+            SolveResult::UNIQUE);
+
+    SearchOptions options;
+    for (Propagation propagation :
+            {Propagation::LOCKED, Propagation::SUBSETS}) {
+        setPropagation(options, propagation);
+        test_assert(static_cast<bool>(options.deduce));
+        SearchBudget budget;
+        test_assert(solve(problem, solution, budget, options) ==
+                SolveResult::UNIQUE);
+        test_assert(solution == expected);
+        test_assert(budget.nodes() <= singlesBudget.nodes());
+
+        // Deductions keep every solution.
+        parseLine(openProblemLine, problem);
+        Board<PossibilitySet> board;
+        convertToCandidates(problem, board);
+        std::size_t count = 0;
+        iterateSolutions(board, [&](const Board<Number> &) {
+            count++;
+        }, options);
+        test_assert(count == 120);
+        parseLine(hardProblemLine, problem);
+    }
+
+    setPropagation(options, Propagation::SINGLES);
+    test_assert(!options.deduce);
+}
+
+static void testAutoTune() {
+    std::vector<Board<Number>> sample(2);
+    parseLine(problemLine, sample[0]);
+    parseLine(hardProblemLine, sample[1]);
+
+    std::vector<BenchmarkResult> results;
+    TuningProfile profile = autoTune(
+            sample, SearchOptions(), SearchBudget::unlimited, 1, &results);
+    std::vector<TuningProfile> candidates = tuningCandidates();
+    test_assert(results.size() == candidates.size());
+    bool found = false;
+    for (const TuningProfile &candidate : candidates)
+        found = found || (candidate.propagation == profile.propagation &&
+                candidate.backend == profile.backend &&
+                candidate.tieBreak == profile.tieBreak);
+    test_assert(found);
+    for (const BenchmarkResult &result : results)
+        test_assert(result.solved == 2);
+
+    SearchOptions options;
+    profile.apply(options);
+    test_assert(options.backend == profile.backend);
+    test_assert(options.tieBreak == profile.tieBreak);
+    test_assert(static_cast<bool>(options.deduce) ==
+            (profile.propagation != Propagation::SINGLES));
+
+    // Only the configurations that abort fewest problems can win.
+    TuningProfile limited = autoTune(sample, SearchOptions(), 1, 1, &results);
+    for (std::size_t i = 0; i < candidates.size(); i++)
+        if (candidates[i].propagation == limited.propagation &&
+                candidates[i].backend == limited.backend &&
+                candidates[i].tieBreak == limited.tieBreak)
+            for (const BenchmarkResult &result : results)
+                test_assert(results[i].aborted <= result.aborted);
+}
+
+static void testProfileText() {
+    TuningProfile profile;
+    profile.propagation = Propagation::LOCKED;
+    profile.backend = Backend::BITBOARD;
+    profile.tieBreak = TieBreak::DEGREE;
+
+    std::stringstream stream;
+    stream << profile;
+    test_assert(stream.str() ==
+            "sudoku-profile 1\npropagation locked\nbackend bitboard\n"
+            "tie-break degree\n");
+
+    TuningProfile read;
+    test_assert(static_cast<bool>(stream >> read));
+    test_assert(read.propagation == profile.propagation);
+    test_assert(read.backend == profile.backend);
+    test_assert(read.tieBreak == profile.tieBreak);
+
+    std::istringstream bad(
+            "sudoku-profile 1\npropagation strong\nbackend cells\n"
+            "tie-break first\n");
+    test_assert(!(bad >> read));
+}
+
+static void testAll() {
+    testNames();
+    testPropagation();
+    testAutoTune();
+    testProfileText();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,60 @@
+#include <iomanip>
+#include "Benchmark.hh"
+
+using std::size_t;
+using std::vector;
+
+
+BenchmarkResult benchmark(
+        const vector<Board<Number>> &problems,
+        const SearchOptions &options,
+        size_t nodeLimit) {
+    using Clock = std::chrono::steady_clock;
+
+    BenchmarkResult result;
+    result.options = options;
+    result.problems = problems.size();
+
+    Board<Number> solution;
+    PerfCounters counters;
+    PerfSample startEvents = counters.read();
+    Clock::time_point start = Clock::now();
+    for (const Board<Number> &problem : problems) {
+        SearchBudget budget(nodeLimit);
+        switch (solve(problem, solution, budget, options)) {
+        case SolveResult::UNIQUE:
+        case SolveResult::MULTIPLE:
+            result.solved++;
+            break;
+        case SolveResult::ABORTED:
+            result.aborted++;
+            break;
+        case SolveResult::INSOLVABLE:
+            break;
+        }
+        result.nodes += budget.nodes();
+    }
+    result.time = Clock::now() - start;
+    result.events = counters.read() - startEvents;
+    return result;
+}
+
+std::ostream &operator<<(std::ostream &os, const BenchmarkResult &result) {
+    double perProblem = result.problems == 0 ? 0.0 :
+            result.time.count() * 1e6 / result.problems;
+    std::ios::fmtflags flags = os.flags();
+    os << std::left << std::setw(10) << backendName(result.options.backend) <<
+            std::right << " problems=" << result.problems <<
+            " solved=" << result.solved <<
+            " aborted=" << result.aborted <<
+            std::fixed << std::setprecision(3) <<
+            " time=" << result.time.count() << "s" <<
+            std::setprecision(1) <<
+            " per-problem=" << perProblem << "us" <<
+            " nodes=" << result.nodes << result.events;
+    os.flags(flags);
+    return os;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,49 @@
+#ifndef INCLUDED_BENCHMARK_HH
+#define INCLUDED_BENCHMARK_HH 1
+
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "Board.hh"
+#include "PerfCounters.hh"
+#include "Solver.hh"
+
+
+struct BenchmarkResult {
+    SearchOptions options;
+    std::size_t problems = 0;
+    /** Number of problems found to have one or more solutions. */
+    std::size_t solved = 0;
+    /** Number of problems whose budget ran out. */
+    std::size_t aborted = 0;
+    /** Total number of search nodes visited. */
+    std::size_t nodes = 0;
+    std::chrono::duration<double> time{0};
+    /** The hardware events counted while solving, where available. */
+    PerfSample events;
+};
+
+/**
+ * Solves every problem with the given options in the calling thread and
+ * measures the total time and hardware events.
+ */
+extern BenchmarkResult benchmark(
+        const std::vector<Board<Number>> &problems,
+        const SearchOptions &options,
+        std::size_t nodeLimit = SearchBudget::unlimited);
+
+/**
+ * Prints the result on one line: the backend, the number of problems, the
+ * total and per-problem time, the number of nodes and the available event
+ * counts.
+ */
+extern std::ostream &operator<<(
+        std::ostream &os,
+        const BenchmarkResult &result);
+
+
+#endif // #ifndef INCLUDED_BENCHMARK_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
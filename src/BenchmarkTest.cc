@@ -0,0 +1,63 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Benchmark.hh"
+#include "Format.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+
+static vector<Board<Number>> problems() {
+    const char *const lines[] = {
+        problemLine,
+        hardProblemLine,
+        "110000000000000000000000000000000000000000000"
+        "000000000000000000000000000000000000",
+    };
+    vector<Board<Number>> boards;
+    for (const char *line : lines) {
+        boards.emplace_back();
+        parseLine(line, boards.back());
+    }
+    return boards;
+}
+
+static void testBenchmark() {
+    for (Backend backend : { Backend::CELLS, Backend::BITBOARD }) {
+        SearchOptions options;
+        options.backend = backend;
+        BenchmarkResult result = benchmark(problems(), options);
+        test_assert(result.problems == 3);
+        test_assert(result.solved == 2);
+        test_assert(result.aborted == 0);
+        test_assert(result.nodes >= 3);
+
+        ostringstream os;
+        os << result;
+        string name = backendName(backend);
+        test_assert(os.str().compare(0, name.size(), name) == 0);
+        test_assert(os.str().find(" problems=3 solved=2 aborted=0 ") !=
+                string::npos);
+    }
+
+    SearchOptions options;
+    BenchmarkResult result = benchmark(problems(), options, 1);
+    test_assert(result.solved == 1);
+    test_assert(result.aborted == 1);
+}
+
+static void testAll() {
+    testBenchmark();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
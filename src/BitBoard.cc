@@ -0,0 +1,142 @@
+#include "BitBoard.hh"
+
+using std::array;
+
+
+namespace {
+
+/** The peers and unit positions of every position, computed once. */
+struct CellTables {
+
+    array<CellSet, N * N> peers;
+    array<CellSet, 3 * N> units;
+
+    CellTables() noexcept {
+        for (Number index = 0; index < N * N; index++) {
+            Position pos = CellSet::position(index);
+            units[pos.i()].add(index);
+            units[N + pos.j()].add(index);
+            units[2 * N + UnitMasks::blockIndex(pos)].add(index);
+        }
+        for (Number index = 0; index < N * N; index++) {
+            Position pos = CellSet::position(index);
+            peers[index] = units[pos.i()] | units[N + pos.j()] |
+                    units[2 * N + UnitMasks::blockIndex(pos)];
+            peers[index].remove(index);
+        }
+    }
+
+};
+
+const CellTables cellTables;
+
+} // namespace
+
+const CellSet &peerCells(Number index) noexcept {
+    return cellTables.peers[index];
+}
+
+const array<CellSet, 3 * N> &unitCells() noexcept {
+    return cellTables.units;
+}
+
+BitBoard::BitBoard(const Board<PossibilitySet> &board) noexcept {
+    const PossibilitySet *psets = board.data();
+    for (Number index = 0; index < N * N; index++) {
+        PossibilitySet::Bits bits = psets[index].bits();
+        for (Number n = 0; n < N; n++)
+            if ((bits >> n) & 1)
+                mNumbers[n].add(index);
+    }
+}
+
+void BitBoard::toBoard(Board<PossibilitySet> &board) const noexcept {
+    PossibilitySet *psets = board.data();
+    for (Number index = 0; index < N * N; index++)
+        psets[index] = candidates(index);
+}
+
+PossibilitySet BitBoard::candidates(Number index) const noexcept {
+    PossibilitySet pset;
+    for (Number n = 0; n < N; n++)
+        if (mNumbers[n].contains(index))
+            pset.add(n);
+    return pset;
+}
+
+void BitBoard::place(Number index, Number n) noexcept {
+    for (CellSet &positions : mNumbers)
+        positions.remove(index);
+    mNumbers[n] -= peerCells(index);
+    mNumbers[n].add(index);
+    mPlaced.add(index);
+}
+
+bool BitBoard::propagate() noexcept {
+    for (;;) {
+        // Count the candidates of all positions at once: "any" has the
+        // positions with at least one and "multiple" those with two or more.
+        CellSet any, multiple;
+        for (const CellSet &positions : mNumbers) {
+            multiple |= any & positions;
+            any |= positions;
+        }
+        if (any != CellSet::all())
+            return false;
+
+        bool changed = false;
+        for (CellSet singles = any - multiple - mPlaced;
+                !singles.isEmpty(); ) {
+            Number index = singles.first();
+            singles.remove(index);
+
+            // An earlier single may have removed the last candidate.
+            Number n = 0;
+            while (n < N && !mNumbers[n].contains(index))
+                n++;
+            if (n == N)
+                return false;
+
+            place(index, n);
+            changed = true;
+        }
+        if (changed)
+            continue;
+
+        for (Number n = 0; n < N; n++) {
+            for (const CellSet &unit : unitCells()) {
+                CellSet positions = mNumbers[n] & unit;
+                if (positions.isEmpty())
+                    return false;
+                if (positions.isUnique() &&
+                        !mPlaced.contains(positions.first())) {
+                    place(positions.first(), n);
+                    changed = true;
+                }
+            }
+        }
+        if (!changed)
+            return true;
+    }
+}
+
+Number BitBoard::findIndexWithLeastCandidates() const noexcept {
+    Number bestIndex = 0;
+    std::size_t leastCount = N + 1;
+    for (CellSet unplaced = CellSet::all() - mPlaced; !unplaced.isEmpty(); ) {
+        Number index = unplaced.first();
+        unplaced.remove(index);
+
+        std::size_t count = candidates(index).count();
+        if (count < leastCount) {
+            leastCount = count;
+            bestIndex = index;
+            if (count <= 2)
+                break;
+        }
+    }
+    return bestIndex;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,191 @@
+#ifndef INCLUDED_BITBOARD_HH
+#define INCLUDED_BITBOARD_HH 1
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "Board.hh"
+
+
+/**
+ * A set of the N * N positions of a board, indexed in row-major order and
+ * packed into two 64-bit words.
+ */
+class CellSet {
+
+private:
+
+    std::uint64_t mLow, mHigh;
+
+    static_assert(64 < N * N && N * N <= 128,
+            "cell sets must fill the high word partially");
+
+public:
+
+    constexpr CellSet() noexcept : mLow(0), mHigh(0) { }
+
+    constexpr CellSet(std::uint64_t low, std::uint64_t high) noexcept :
+            mLow(low), mHigh(high) { }
+
+    static constexpr CellSet of(Number index) noexcept {
+        return index < 64 ?
+                CellSet(std::uint64_t(1) << index, 0) :
+                CellSet(0, std::uint64_t(1) << (index - 64));
+    }
+
+    static constexpr CellSet all() noexcept {
+        return CellSet(
+                ~std::uint64_t(0), ~std::uint64_t(0) >> (128 - N * N));
+    }
+
+    static constexpr Number index(const Position &pos) noexcept {
+        return pos.i() * N + pos.j();
+    }
+
+    static constexpr Position position(Number index) noexcept {
+        return Position(index / N, index % N);
+    }
+
+    constexpr bool operator==(const CellSet &other) const noexcept {
+        return mLow == other.mLow && mHigh == other.mHigh;
+    }
+
+    constexpr bool operator!=(const CellSet &other) const noexcept {
+        return !(*this == other);
+    }
+
+    constexpr bool isEmpty() const noexcept {
+        return (mLow | mHigh) == 0;
+    }
+
+    /** Returns true if the set has exactly one position. */
+    constexpr bool isUnique() const noexcept {
+        return mLow == 0 ?
+                mHigh != 0 && (mHigh & (mHigh - 1)) == 0 :
+                mHigh == 0 && (mLow & (mLow - 1)) == 0;
+    }
+
+    constexpr bool contains(Number index) const noexcept {
+        return index < 64 ?
+                (mLow >> index) & 1 :
+                (mHigh >> (index - 64)) & 1;
+    }
+
+    std::size_t count() const noexcept {
+        return static_cast<std::size_t>(
+                __builtin_popcountll(mLow) + __builtin_popcountll(mHigh));
+    }
+
+    /** Returns the smallest index in the set, which must not be empty. */
+    Number first() const noexcept {
+        return mLow != 0 ?
+                static_cast<Number>(__builtin_ctzll(mLow)) :
+                static_cast<Number>(__builtin_ctzll(mHigh)) + 64;
+    }
+
+    CellSet &add(Number index) noexcept {
+        return *this |= of(index);
+    }
+
+    CellSet &remove(Number index) noexcept {
+        return *this -= of(index);
+    }
+
+    CellSet &operator|=(const CellSet &other) noexcept {
+        mLow |= other.mLow;
+        mHigh |= other.mHigh;
+        return *this;
+    }
+
+    CellSet &operator&=(const CellSet &other) noexcept {
+        mLow &= other.mLow;
+        mHigh &= other.mHigh;
+        return *this;
+    }
+
+    /** Removes all positions in the other set. */
+    CellSet &operator-=(const CellSet &other) noexcept {
+        mLow &= ~other.mLow;
+        mHigh &= ~other.mHigh;
+        return *this;
+    }
+
+};
+
+static inline CellSet operator|(CellSet set1, const CellSet &set2) noexcept {
+    return set1 |= set2;
+}
+
+static inline CellSet operator&(CellSet set1, const CellSet &set2) noexcept {
+    return set1 &= set2;
+}
+
+static inline CellSet operator-(CellSet set1, const CellSet &set2) noexcept {
+    return set1 -= set2;
+}
+
+/** Returns the other positions in the row, column and block of a position. */
+extern const CellSet &peerCells(Number index) noexcept;
+
+/** Returns the positions in the rows, then the columns, then the blocks. */
+extern const std::array<CellSet, 3 * N> &unitCells() noexcept;
+
+
+/**
+ * A digit-major board: for each number, the set of positions where it is
+ * still possible. Placing a number clears it from all peers with one
+ * AND-NOT, and questions like where a number can go in a unit become a mask
+ * and a population count.
+ */
+class BitBoard {
+
+private:
+
+    std::array<CellSet, N> mNumbers;
+    /** Positions whose number has been placed and cleared from the peers. */
+    CellSet mPlaced;
+
+public:
+
+    BitBoard() noexcept = default;
+
+    explicit BitBoard(const Board<PossibilitySet> &board) noexcept;
+
+    /** Converts back to a cell-major board. */
+    void toBoard(Board<PossibilitySet> &board) const noexcept;
+
+    /** Returns the positions where the number is possible. */
+    const CellSet &positions(Number n) const noexcept {
+        return mNumbers[n];
+    }
+
+    PossibilitySet candidates(Number index) const noexcept;
+
+    bool isSolved() const noexcept {
+        return mPlaced == CellSet::all();
+    }
+
+    /** Fixes the position to the number and clears it from the peers. */
+    void place(Number index, Number n) noexcept;
+
+    /**
+     * Places naked and hidden singles until none is left. Returns false if
+     * the board turns out to be insolvable: a position has no candidate or a
+     * number has no position in some unit.
+     */
+    bool propagate() noexcept;
+
+    /**
+     * Returns the index of an unplaced position with the fewest candidates,
+     * the first one in row-major order in case of a tie. The board must be
+     * propagated and not solved.
+     */
+    Number findIndexWithLeastCandidates() const noexcept;
+
+};
+
+
+#endif // #ifndef INCLUDED_BITBOARD_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
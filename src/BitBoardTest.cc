@@ -0,0 +1,140 @@
+#include "BitBoard.hh"
+#include "Tester.inl"
+
+
+static Board<PossibilitySet> fullBoard() {
+    Board<PossibilitySet> board;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board[pos] = PossibilitySet::full();
+        return true;
+    });
+    return board;
+}
+
+static void testCellSet() {
+    CellSet set;
+    test_assert(set.isEmpty());
+    test_assert(!set.isUnique());
+
+    set.add(3);
+    test_assert(set.isUnique());
+    test_assert(set.contains(3));
+    test_assert(set.first() == 3);
+
+    set.add(70);
+    test_assert(!set.isUnique());
+    test_assert(set.count() == 2);
+    set.remove(3);
+    test_assert(set == CellSet::of(70));
+    test_assert(set.first() == 70);
+
+    test_assert(CellSet::all().count() == N * N);
+    test_assert((CellSet::all() - CellSet::of(80)).count() == N * N - 1);
+    test_assert(CellSet::index(Position(7, 2)) == 65);
+    test_assert(CellSet::position(65) == Position(7, 2));
+}
+
+static void testTables() {
+    for (Number index = 0; index < N * N; index++) {
+        test_assert(peerCells(index).count() == 20);
+        test_assert(!peerCells(index).contains(index));
+    }
+    test_assert(peerCells(0).contains(8));
+    test_assert(peerCells(0).contains(72));
+    test_assert(peerCells(0).contains(20));
+    test_assert(!peerCells(0).contains(30));
+
+    for (const CellSet &unit : unitCells())
+        test_assert(unit.count() == N);
+    test_assert(unitCells()[2 * N + 4].contains(CellSet::index(
+            Position(4, 4))));
+}
+
+static void testConversion() {
+    Board<PossibilitySet> board = fullBoard(), board2;
+    board[Position(2, 3)] = PossibilitySet(1).add(6);
+    board[Position(8, 8)] = PossibilitySet();
+
+    BitBoard bitBoard(board);
+    test_assert(bitBoard.positions(6).count() == N * N - 1);
+    test_assert(bitBoard.positions(2).count() == N * N - 2);
+    test_assert(bitBoard.candidates(CellSet::index(Position(2, 3))) ==
+            PossibilitySet(1).add(6));
+
+    bitBoard.toBoard(board2);
+    test_assert(board2 == board);
+}
+
+static void testPlace() {
+    BitBoard board(fullBoard());
+    Number index = CellSet::index(Position(4, 4));
+    board.place(index, 5);
+
+    test_assert(board.candidates(index) == PossibilitySet(5));
+    test_assert(board.positions(5).count() == N * N - 20);
+    for (Number peer = 0; peer < N * N; peer++)
+        if (peerCells(index).contains(peer))
+            test_assert(board.candidates(peer) ==
+                    PossibilitySet::full().remove(5));
+    test_assert(!board.isSolved());
+}
+
+static void testPropagate() {
+    // Only one blank position: a naked single.
+    Board<PossibilitySet> board;
+    const Number solution[N][N] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8},
+        {3, 4, 5, 6, 7, 8, 0, 1, 2},
+        {6, 7, 8, 0, 1, 2, 3, 4, 5},
+        {1, 2, 0, 4, 5, 3, 7, 8, 6},
+        {4, 5, 3, 7, 8, 6, 1, 2, 0},
+        {7, 8, 6, 1, 2, 0, 4, 5, 3},
+        {2, 0, 1, 5, 3, 4, 8, 6, 7},
+        {5, 3, 4, 8, 6, 7, 2, 0, 1},
+        {8, 6, 7, 2, 0, 1, 5, 3, 4},
+    };
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board[pos] = PossibilitySet(solution[pos.i()][pos.j()]);
+        return true;
+    });
+    board[Position(3, 3)] = PossibilitySet::full();
+    board[Position(6, 7)] = PossibilitySet::full();
+
+    BitBoard bitBoard(board);
+    test_assert(bitBoard.propagate());
+    test_assert(bitBoard.isSolved());
+    test_assert(bitBoard.candidates(CellSet::index(Position(3, 3))) ==
+            PossibilitySet(4));
+
+    // Two equal numbers in a row.
+    board[Position(3, 3)] = PossibilitySet(0);
+    BitBoard bitBoard2(board);
+    test_assert(!bitBoard2.propagate());
+
+    // A hidden single: number 0 can only go to (0, 0) in the first row.
+    Board<PossibilitySet> board3 = fullBoard();
+    for (Number j = 1; j < N; j++)
+        board3[Position(0, j)].remove(0);
+    BitBoard bitBoard3(board3);
+    test_assert(bitBoard3.propagate());
+    test_assert(bitBoard3.candidates(0) == PossibilitySet(0));
+    test_assert(!bitBoard3.positions(0).contains(CellSet::index(
+            Position(5, 0))));
+    test_assert(bitBoard3.findIndexWithLeastCandidates() == 1);
+}
+
+static void testAll() {
+    testCellSet();
+    testTables();
+    testConversion();
+    testPlace();
+    testPropagate();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
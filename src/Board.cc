@@ -1,10 +1,13 @@
-#include <cstdlib>
+#include <cstdint>
 #include <ios>
 #include <limits>
 #include <stdexcept>
 #include "Board.hh"
 
-using std::abort;
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using std::logic_error;
 using std::numeric_limits;
 using std::size_t;
@@ -15,17 +18,13 @@ Number PossibilitySet::uniqueValue() const {
     if (!isUnique())
         throw logic_error("multiple possibilities");
 
-    for (Number n = 0; n < N; n++)
-        if (mNumbers[n])
-            return n;
-
-    abort();
+    return first();
 }
 
 bool PossibilitySet::forAllPossibleNumbers(std::function<bool(Number)> f)
         const noexcept(noexcept(f(0))) {
     for (Number n = 0; n < N; n++)
-        if (mNumbers[n])
+        if (contains(n))
             if (!f(n))
                 return false;
     return true;
@@ -47,12 +46,6 @@ bool Area::forAllPositions(std::function<bool(Position)> f)
     return true;
 }
 
-Area blockArea(const Position &pos) {
-    Position topLeft(pos.i() / Nsub * Nsub, pos.j() / Nsub * Nsub);
-    Position bottomRight = Position(topLeft).down(Nsub).right(Nsub);
-    return Area(topLeft, bottomRight);
-}
-
 bool forAllBlockAreas(std::function<bool(const Area&)> f)
         noexcept(noexcept(f(Area()))) {
     for (Position pi; pi.i() < N; pi.down(Nsub))
@@ -126,43 +119,180 @@ std::istream &operator>>(std::istream &is, Board<Number> &board) {
     return is;
 }
 
+namespace {
+
 /**
- * Computes the state of the given board. Only considers the number of possible
- * numbers in every position.
+ * The result of scanning all positions of a board once: whether some
+ * position is empty, whether all are unique, and the first position with the
+ * fewest possibilities among those with more than one.
  */
-BoardState classify(const Board<PossibilitySet> &board) noexcept {
-    BoardState state = BoardState::SOLVED;
+struct Scan {
+    bool hasEmpty = false;
+    bool allUnique = true;
+    Position branch;
+};
 
-    wholeArea.forAllPositions([&](Position pos) -> bool {
-        const PossibilitySet &pset = board[pos];
-        if (pset.isEmpty()) {
-            state = BoardState::INSOLVABLE;
-            return false;
+/*
+ * Branch candidates are ranked by a 15-bit key, the count of possibilities
+ * above the position index, so that the minimum key is the first position in
+ * row-major order with the fewest possibilities. Positions that cannot be
+ * branched on get the largest key.
+ */
+constexpr unsigned indexBits = 7;
+constexpr unsigned noBranchKey = 0x7fff;
+
+static_assert(N * N <= 1u << indexBits, "position index must fit in the key");
+
+void scanScalar(
+        const PossibilitySet *psets,
+        Number begin,
+        Scan &scan,
+        unsigned &minKey) noexcept {
+    for (Number index = begin; index < N * N; index++) {
+        unsigned count = static_cast<unsigned>(psets[index].count());
+        if (count == 0)
+            scan.hasEmpty = true;
+        if (count != 1)
+            scan.allUnique = false;
+        if (count > 1) {
+            unsigned key = count << indexBits | static_cast<unsigned>(index);
+            if (key < minKey)
+                minKey = key;
         }
-        if (!pset.isUnique())
-            state = BoardState::UNSOLVED;
-        return true;
-    });
+    }
+}
+
+#ifdef __SSE2__
+
+/** Counts the bits of each 16-bit lane. */
+inline __m128i popcount16(__m128i x) noexcept {
+    const __m128i m1 = _mm_set1_epi16(0x5555);
+    const __m128i m2 = _mm_set1_epi16(0x3333);
+    const __m128i m4 = _mm_set1_epi16(0x0f0f);
+    x = _mm_sub_epi16(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+    x = _mm_add_epi16(
+            _mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2));
+    x = _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(x, 4)), m4);
+    return _mm_and_si128(
+            _mm_add_epi16(x, _mm_srli_epi16(x, 8)), _mm_set1_epi16(0x1f));
+}
+
+/** Loads eight possibility sets. */
+inline __m128i load8(const PossibilitySet *psets) noexcept {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(psets));
+}
+
+/** Returns the minimum of the eight signed 16-bit lanes. */
+inline int horizontalMin16(__m128i x) noexcept {
+    x = _mm_min_epi16(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_min_epi16(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    x = _mm_min_epi16(x, _mm_srli_epi32(x, 16));
+    return static_cast<std::int16_t>(_mm_cvtsi128_si32(x));
+}
+
+#endif // #ifdef __SSE2__
+
+/**
+ * Scans the board eight positions at a time where SSE2 is available, and
+ * the remaining positions one by one.
+ */
+Scan scanBoard(const Board<PossibilitySet> &board) noexcept {
+    static_assert(sizeof(PossibilitySet) == 2,
+            "possibility sets must be packed into 16-bit lanes");
+
+    const PossibilitySet *psets = board.data();
+    Scan scan;
+    unsigned minKey = noBranchKey;
+    Number index = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i step = _mm_set1_epi16(8);
+    __m128i indices = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+    __m128i empty = zero, notUnique = zero;
+    __m128i minKeys = _mm_set1_epi16(noBranchKey);
+
+    for (; index + 8 <= N * N; index += 8) {
+        __m128i counts = popcount16(load8(psets + index));
+        __m128i isUnique = _mm_cmpeq_epi16(counts, one);
+        __m128i isEmpty = _mm_cmpeq_epi16(counts, zero);
+        empty = _mm_or_si128(empty, isEmpty);
+        notUnique = _mm_or_si128(notUnique, _mm_andnot_si128(isUnique,
+                _mm_cmpeq_epi16(zero, zero)));
+
+        __m128i keys = _mm_or_si128(
+                _mm_slli_epi16(counts, indexBits), indices);
+        __m128i noBranch = _mm_or_si128(isUnique, isEmpty);
+        keys = _mm_or_si128(_mm_andnot_si128(noBranch, keys),
+                _mm_and_si128(noBranch, _mm_set1_epi16(noBranchKey)));
+        minKeys = _mm_min_epi16(minKeys, keys);
+        indices = _mm_add_epi16(indices, step);
+    }
+
+    scan.hasEmpty = _mm_movemask_epi8(empty) != 0;
+    scan.allUnique = _mm_movemask_epi8(notUnique) == 0;
+    minKey = static_cast<unsigned>(horizontalMin16(minKeys));
+#endif // #ifdef __SSE2__
+
+    scanScalar(psets, index, scan, minKey);
 
-    return state;
+    if (minKey != noBranchKey) {
+        Number branchIndex = minKey & ((1u << indexBits) - 1);
+        scan.branch = Position(branchIndex / N, branchIndex % N);
+    }
+    return scan;
+}
+
+} // namespace
+
+/**
+ * Computes the state of the given board. Only considers the number of possible
+ * numbers in every position.
+ */
+BoardState classify(const Board<PossibilitySet> &board) noexcept {
+    Position branch;
+    return classifyAndFindBranch(board, branch);
 }
 
 Position findPositionWithLeastPossibilities(
         const Board<PossibilitySet> &board) noexcept {
-    Position positionWithLeastPossibilities;
-    size_t leastCount = N + 1;
-
-    wholeArea.forAllPositions([&](Position pos) -> bool {
-        size_t count = board[pos].count();
-        if (1 < count && count < leastCount) {
-            leastCount = count;
-            positionWithLeastPossibilities = pos;
-        }
-        return true;
-    });
+    return scanBoard(board).branch;
+}
 
-    return positionWithLeastPossibilities;
+BoardState classifyAndFindBranch(
+        const Board<PossibilitySet> &board,
+        Position &branch) noexcept {
+    Scan scan = scanBoard(board);
+    branch = scan.branch;
+    if (scan.hasEmpty)
+        return BoardState::INSOLVABLE;
+    if (scan.allUnique)
+        return BoardState::SOLVED;
+    return BoardState::UNSOLVED;
 }
 
+bool operator==(
+        const Board<PossibilitySet> &b1,
+        const Board<PossibilitySet> &b2)
+        noexcept {
+    const PossibilitySet *p1 = b1.data(), *p2 = b2.data();
+    Number index = 0;
+
+#ifdef __SSE2__
+    __m128i differ = _mm_setzero_si128();
+    for (; index + 8 <= N * N; index += 8)
+        differ = _mm_or_si128(differ,
+                _mm_xor_si128(load8(p1 + index), load8(p2 + index)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(differ, _mm_setzero_si128())) !=
+            0xffff)
+        return false;
+#endif // #ifdef __SSE2__
+
+    for (; index < N * N; index++)
+        if (p1[index] != p2[index])
+            return false;
+    return true;
+}
 
 /* vim: set et sw=4 sts=4 tw=79: */
@@ -2,11 +2,14 @@
 #define INCLUDED_BOARD_HH 1
 
 
+#include <algorithm>
 #include <array>
 #include <bitset>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 #include <utility>
 
 
@@ -16,65 +19,142 @@ static constexpr Number Nsub = 3;
 static constexpr Number N = Nsub * Nsub;
 
 
+/** The size of a cache line, to which boards are aligned. */
+static constexpr std::size_t cacheLineSize = 64;
+
+
+/**
+ * A set of numbers, packed into the low N bits of a 16-bit word so that a
+ * whole board fits in a few cache lines.
+ */
 class PossibilitySet {
 
+public:
+
+    using Bits = std::uint16_t;
+
 private:
 
-    std::bitset<N> mNumbers;
+    Bits mBits;
+
+    static constexpr Bits allBits = (1u << N) - 1;
+
+    static_assert(N <= 16, "possibility sets have only 16 bits");
 
 public:
 
-    constexpr PossibilitySet() = default;
+    constexpr PossibilitySet() noexcept : mBits(0) { }
     constexpr PossibilitySet(const PossibilitySet &pset) = default;
     constexpr PossibilitySet(PossibilitySet &&pset) = default;
     ~PossibilitySet() = default;
     PossibilitySet &operator=(const PossibilitySet &pset) = default;
     PossibilitySet &operator=(PossibilitySet &&pset) = default;
 
-    explicit /*constexpr*/ PossibilitySet(Number n) : mNumbers() {
-        mNumbers.set(n);
+    explicit constexpr PossibilitySet(Number n) noexcept :
+            mBits(static_cast<Bits>(1u << n)) { }
+
+    static constexpr PossibilitySet fromBits(Bits bits) noexcept {
+        return PossibilitySet(bits, 0);
     }
 
 private:
 
-    explicit constexpr PossibilitySet(const std::bitset<N> &numbers) noexcept :
-            mNumbers(numbers) { }
+    constexpr PossibilitySet(Bits bits, int) noexcept : mBits(bits) { }
 
 public:
 
     static constexpr PossibilitySet full() noexcept {
-        return PossibilitySet(std::bitset<N>((1u << N) - 1));
+        return fromBits(allBits);
+    }
+
+    /** Returns the set as a bit mask where bit n stands for number n. */
+    constexpr Bits bits() const noexcept {
+        return mBits;
     }
 
-    bool operator==(const PossibilitySet &other) const {
-        return mNumbers == other.mNumbers;
+    constexpr bool operator==(const PossibilitySet &other) const noexcept {
+        return mBits == other.mBits;
     }
 
-    bool operator!=(const PossibilitySet &other) const {
+    constexpr bool operator!=(const PossibilitySet &other) const noexcept {
         return !(*this == other);
     }
 
-    std::size_t count() const {
-        return mNumbers.count();
+    constexpr std::size_t count() const noexcept {
+#ifdef __GNUC__
+        return static_cast<std::size_t>(__builtin_popcount(mBits));
+#else
+        std::size_t count = 0;
+        for (Bits bits = mBits; bits != 0; bits &= bits - 1)
+            count++;
+        return count;
+#endif
     }
 
-    bool isEmpty() const noexcept {
-        return mNumbers.none();
+    constexpr bool isEmpty() const noexcept {
+        return mBits == 0;
     }
 
-    bool isUnique() const noexcept {
-        return count() == 1;
+    constexpr bool isUnique() const noexcept {
+        return mBits != 0 && (mBits & (mBits - 1)) == 0;
     }
 
     Number uniqueValue() const;
 
-    PossibilitySet &add(Number n) {
-        mNumbers.set(n);
+    /** Returns the smallest number in the set, which must not be empty. */
+    constexpr Number first() const noexcept {
+#ifdef __GNUC__
+        return static_cast<Number>(__builtin_ctz(mBits));
+#else
+        Number n = 0;
+        while (!contains(n))
+            n++;
+        return n;
+#endif
+    }
+
+    /** Returns the largest number in the set, which must not be empty. */
+    constexpr Number last() const noexcept {
+#ifdef __GNUC__
+        return static_cast<Number>(31 - __builtin_clz(mBits));
+#else
+        Number n = N - 1;
+        while (!contains(n))
+            n--;
+        return n;
+#endif
+    }
+
+    constexpr PossibilitySet &add(Number n) noexcept {
+        mBits |= static_cast<Bits>(1u << n);
+        return *this;
+    }
+
+    constexpr PossibilitySet &remove(Number n) noexcept {
+        mBits &= static_cast<Bits>(~(1u << n));
+        return *this;
+    }
+
+    constexpr bool contains(Number n) const noexcept {
+        return (mBits >> n) & 1u;
+    }
+
+    constexpr PossibilitySet &operator|=(const PossibilitySet &other)
+            noexcept {
+        mBits |= other.mBits;
+        return *this;
+    }
+
+    constexpr PossibilitySet &operator&=(const PossibilitySet &other)
+            noexcept {
+        mBits &= other.mBits;
         return *this;
     }
 
-    PossibilitySet &remove(Number n) noexcept {
-        mNumbers.reset(n);
+    /** Removes all numbers in the other set. */
+    constexpr PossibilitySet &operator-=(const PossibilitySet &other)
+            noexcept {
+        mBits &= static_cast<Bits>(~other.mBits);
         return *this;
     }
 
@@ -84,6 +164,22 @@ public:
 };
 
 
+static constexpr PossibilitySet operator|(
+        PossibilitySet pset1, const PossibilitySet &pset2) noexcept {
+    return pset1 |= pset2;
+}
+
+static constexpr PossibilitySet operator&(
+        PossibilitySet pset1, const PossibilitySet &pset2) noexcept {
+    return pset1 &= pset2;
+}
+
+static constexpr PossibilitySet operator-(
+        PossibilitySet pset1, const PossibilitySet &pset2) noexcept {
+    return pset1 -= pset2;
+}
+
+
 class Position {
 
 private:
@@ -102,31 +198,33 @@ public:
     Position &operator=(Position &&pos) = default;
 
     constexpr Number i() const noexcept { return mI; }
-    Number &i() noexcept { return mI; }
+    constexpr Number &i() noexcept { return mI; }
     constexpr Number j() const noexcept { return mJ; }
-    Number &j() noexcept { return mJ; }
+    constexpr Number &j() noexcept { return mJ; }
 
     constexpr bool isValid() const noexcept {
         return mI < N && mJ < N;
     }
 
-    Position &down(Number n = 1) noexcept {
+    constexpr Position &down(Number n = 1) noexcept {
         mI += n;
         return *this;
     }
 
-    Position &right(Number n = 1) noexcept {
+    constexpr Position &right(Number n = 1) noexcept {
         mJ += n;
         return *this;
     }
 
 };
 
-static inline bool operator==(const Position &pos1, const Position &pos2) {
+static constexpr bool operator==(
+        const Position &pos1, const Position &pos2) {
     return pos1.i() == pos2.i() && pos1.j() == pos2.j();
 }
 
-static inline bool operator!=(const Position &pos1, const Position &pos2) {
+static constexpr bool operator!=(
+        const Position &pos1, const Position &pos2) {
     return !(pos1 == pos2);
 }
 
@@ -183,30 +281,39 @@ static inline bool operator!=(const Area &area1, const Area &area2) {
 
 constexpr Area wholeArea = Area(Position(), Position(N, N));
 
-static inline Area rowArea(Number i) {
+static constexpr Area rowArea(Number i) {
     return Area(Position(i, 0), Position(i, N).down());
 }
 
-static inline Area rowArea(const Position &pos) {
+static constexpr Area rowArea(const Position &pos) {
     return rowArea(pos.i());
 }
 
-static inline Area columnArea(Number j) {
+static constexpr Area columnArea(Number j) {
     return Area(Position(0, j), Position(N, j).right());
 }
 
-static inline Area columnArea(const Position &pos) {
+static constexpr Area columnArea(const Position &pos) {
     return columnArea(pos.j());
 }
 
-extern Area blockArea(const Position &pos);
+static constexpr Area blockArea(const Position &pos) {
+    Position topLeft(pos.i() / Nsub * Nsub, pos.j() / Nsub * Nsub);
+    Position bottomRight = Position(topLeft).down(Nsub).right(Nsub);
+    return Area(topLeft, bottomRight);
+}
 
 extern bool forAllBlockAreas(std::function<bool(const Area&)> f)
         noexcept(noexcept(f(Area())));
 
 
+/**
+ * A square board of values. Boards are aligned to cache lines so that boards
+ * used by different threads never share a line and a board of possibility
+ * sets spans as few lines as possible.
+ */
 template <typename T>
-class Board {
+class alignas(cacheLineSize) Board {
 
 public:
 
@@ -216,7 +323,11 @@ public:
 
 private:
 
-    std::array<value_type, N * N> mValues;
+    /**
+     * A built-in array, which unlike std::array can be modified in constant
+     * expressions before C++17.
+     */
+    value_type mValues[N * N];
 
     constexpr Number index(const Position &pos) const {
         return pos.i() * N + pos.j();
@@ -232,31 +343,48 @@ public:
     Board &operator=(Board &&board) = default;
 
     const_reference at(const Position &pos) const {
-        return mValues.at(index(pos));
+        if (!pos.isValid())
+            throw std::out_of_range("Board::at");
+        return mValues[index(pos)];
     }
 
     reference at(const Position &pos) {
-        return mValues.at(index(pos));
+        if (!pos.isValid())
+            throw std::out_of_range("Board::at");
+        return mValues[index(pos)];
     }
 
     constexpr const_reference operator[](const Position &pos) const noexcept {
         return mValues[index(pos)];
     }
 
-    reference operator[](const Position &pos) noexcept {
+    constexpr reference operator[](const Position &pos) noexcept {
         return mValues[index(pos)];
     }
 
+    /** Returns the values in row-major order. */
+    constexpr const value_type *data() const noexcept {
+        return mValues;
+    }
+
+    constexpr value_type *data() noexcept {
+        return mValues;
+    }
+
 };
 
 template <typename T>
 bool operator==(const Board<T> &b1, const Board<T> &b2)
         noexcept(noexcept(b1[Position()] == b2[Position()])) {
-    return wholeArea.forAllPositions([&](Position pos) -> bool {
-        return b1[pos] == b2[pos];
-    });
+    return std::equal(b1.data(), b1.data() + N * N, b2.data());
 }
 
+/** Compares the packed possibility sets of two boards with SIMD. */
+extern bool operator==(
+        const Board<PossibilitySet> &b1,
+        const Board<PossibilitySet> &b2)
+        noexcept;
+
 template <typename T>
 bool operator!=(const Board<T> &b1, const Board<T> &b2)
         noexcept(noexcept(b1[Position()] == b2[Position()])) {
@@ -272,6 +400,96 @@ extern void convert(
         Board<Number> &destBoard)
         noexcept;
 
+/**
+ * The numbers placed in each row, column and block of a board. The candidates
+ * of a position are the numbers placed in none of its three units, so they
+ * can be computed with a few bitwise operations instead of scanning the 20
+ * peers of the position.
+ */
+class UnitMasks {
+
+private:
+
+    PossibilitySet mRows[N], mColumns[N], mBlocks[N];
+
+public:
+
+    static constexpr Number blockIndex(const Position &pos) noexcept {
+        return pos.i() / Nsub * Nsub + pos.j() / Nsub;
+    }
+
+    /** Constructs masks where nothing is placed. */
+    constexpr UnitMasks() noexcept = default;
+
+    /** Constructs masks of the numbers in the board, ignoring blanks. */
+    explicit constexpr UnitMasks(const Board<Number> &board) noexcept :
+            UnitMasks() {
+        for (Position pi; pi.isValid(); pi.down()) {
+            for (Position pj = pi; pj.isValid(); pj.right()) {
+                Number n = board[pj];
+                if (n < N)
+                    place(pj, n);
+            }
+        }
+    }
+
+    constexpr const PossibilitySet &row(Number i) const noexcept {
+        return mRows[i];
+    }
+
+    constexpr const PossibilitySet &column(Number j) const noexcept {
+        return mColumns[j];
+    }
+
+    constexpr const PossibilitySet &block(Number b) const noexcept {
+        return mBlocks[b];
+    }
+
+    /** Returns the numbers placed in any unit of the position. */
+    constexpr PossibilitySet used(const Position &pos) const noexcept {
+        return mRows[pos.i()] | mColumns[pos.j()] | mBlocks[blockIndex(pos)];
+    }
+
+    constexpr PossibilitySet candidates(const Position &pos) const noexcept {
+        return PossibilitySet::full() - used(pos);
+    }
+
+    constexpr bool canPlace(const Position &pos, Number n) const noexcept {
+        return !used(pos).contains(n);
+    }
+
+    constexpr void place(const Position &pos, Number n) noexcept {
+        mRows[pos.i()].add(n);
+        mColumns[pos.j()].add(n);
+        mBlocks[blockIndex(pos)].add(n);
+    }
+
+    constexpr void unplace(const Position &pos, Number n) noexcept {
+        mRows[pos.i()].remove(n);
+        mColumns[pos.j()].remove(n);
+        mBlocks[blockIndex(pos)].remove(n);
+    }
+
+};
+
+/**
+ * Like convert, but gives every blank position only the numbers that are
+ * not placed in its units. Numbers placed twice in a unit are left for
+ * eliminateImpossibilities to detect.
+ */
+constexpr void convertToCandidates(
+        const Board<Number> &srcBoard,
+        Board<PossibilitySet> &destBoard)
+        noexcept {
+    UnitMasks masks(srcBoard);
+    for (Position pi; pi.isValid(); pi.down()) {
+        for (Position pj = pi; pj.isValid(); pj.right()) {
+            Number n = srcBoard[pj];
+            destBoard[pj] = n < N ? PossibilitySet(n) : masks.candidates(pj);
+        }
+    }
+}
+
 extern std::ostream &operator<<(
         std::ostream &os,
         const Board<Number> &board);
@@ -287,9 +505,23 @@ enum class BoardState {
 
 extern BoardState classify(const Board<PossibilitySet> &board) noexcept;
 
+/**
+ * Returns the first position in row-major order with the fewest
+ * possibilities among the positions with more than one, or the top-left
+ * position if there is none.
+ */
 extern Position findPositionWithLeastPossibilities(
         const Board<PossibilitySet> &board) noexcept;
 
+/**
+ * Combines classify and findPositionWithLeastPossibilities in one pass over
+ * the board. The branch position is meaningful only if the board is
+ * UNSOLVED.
+ */
+extern BoardState classifyAndFindBranch(
+        const Board<PossibilitySet> &board,
+        Position &branch) noexcept;
+
 
 #endif // #ifndef INCLUDED_BOARD_HH
 
@@ -1,5 +1,6 @@
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -68,7 +69,9 @@ static void testPossibilitySetNumbers(
         const PossibilitySet &pset,
         const string expected) {
     ostringstream os;
-    pset.forAllPossibleNumbers([&](Number n) -> bool { return os << n; });
+    pset.forAllPossibleNumbers([&](Number n) -> bool {
+        return static_cast<bool>(os << n);
+    });
     test_assert(os.str() == expected);
 }
 
@@ -94,6 +97,37 @@ static void testPossibilitySet3() {
     testPossibilitySetNumbers(pset, "023678");
 }
 
+static void testPossibilitySet4() {
+    PossibilitySet pset1, pset2;
+    pset1.add(1).add(4).add(6);
+    pset2.add(4).add(6).add(8);
+
+    test_assert(pset1.contains(1));
+    test_assert(!pset1.contains(2));
+    test_assert((pset1 | pset2).count() == 4);
+    test_assert((pset1 & pset2) == PossibilitySet(4).add(6));
+    test_assert(pset1 - pset2 == PossibilitySet(1));
+    test_assert(pset2 - pset1 == PossibilitySet(8));
+    test_assert((pset1 - PossibilitySet::full()).isEmpty());
+
+    pset1 -= pset2;
+    test_assert(pset1 == PossibilitySet(1));
+    pset1 |= pset2;
+    test_assert(pset1.count() == 4);
+    pset1 &= PossibilitySet(8);
+    test_assert(pset1 == PossibilitySet(8));
+}
+
+static void testPossibilitySet5() {
+    PossibilitySet pset = PossibilitySet::fromBits(0x0a4);
+    test_assert(pset == PossibilitySet(2).add(5).add(7));
+    test_assert(pset.bits() == 0x0a4);
+    test_assert(pset.first() == 2);
+    test_assert(PossibilitySet(8).first() == 8);
+    test_assert(PossibilitySet::full().bits() == (1u << N) - 1);
+    test_assert(sizeof(PossibilitySet) == 2);
+}
+
 static void testPosition1() {
     test_assert(Position().i() == 0);
     test_assert(Position().j() == 0);
@@ -440,10 +474,116 @@ static void testBoard6() {
     test_assert(findPositionWithLeastPossibilities(board) == pos3);
 }
 
+static void testBoard7() {
+    test_assert(alignof(Board<PossibilitySet>) == cacheLineSize);
+    test_assert(sizeof(Board<PossibilitySet>) % cacheLineSize == 0);
+    test_assert(sizeof(Board<PossibilitySet>) <=
+            (N * N * sizeof(PossibilitySet) / cacheLineSize + 1) *
+            cacheLineSize);
+
+    Board<PossibilitySet> boards[2];
+    test_assert(reinterpret_cast<std::uintptr_t>(&boards[1]) %
+            cacheLineSize == 0);
+
+    boards[0][Position(1, 2)] = PossibilitySet(4);
+    test_assert(boards[0].data()[N + 2] == PossibilitySet(4));
+}
+
+static void testUnitMasks() {
+    UnitMasks masks;
+    const Position pos1(4, 7), pos2(3, 8);
+    test_assert(UnitMasks::blockIndex(pos1) == 5);
+    test_assert(masks.candidates(pos1) == PossibilitySet::full());
+
+    masks.place(pos1, 2);
+    test_assert(masks.row(4) == PossibilitySet(2));
+    test_assert(masks.column(7) == PossibilitySet(2));
+    test_assert(masks.block(5) == PossibilitySet(2));
+    test_assert(!masks.canPlace(pos2, 2));
+    test_assert(masks.canPlace(Position(0, 0), 2));
+
+    masks.place(Position(3, 0), 6);
+    test_assert(masks.used(pos2) == PossibilitySet(2).add(6));
+    test_assert(masks.candidates(pos2) ==
+            PossibilitySet::full().remove(2).remove(6));
+
+    masks.unplace(pos1, 2);
+    test_assert(masks.used(pos2) == PossibilitySet(6));
+    test_assert(masks.block(5).isEmpty());
+}
+
+static void testConvertToCandidates() {
+    Board<Number> problem;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        problem[pos] = N;
+        return true;
+    });
+    problem[Position(0, 0)] = 0;
+    problem[Position(0, 8)] = 1;
+    problem[Position(8, 1)] = 2;
+    problem[Position(2, 2)] = 3;
+
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+    test_assert(board[Position(0, 0)] == PossibilitySet(0));
+    test_assert(board[Position(0, 1)] ==
+            PossibilitySet::full() - PossibilitySet(0).add(1).add(2).add(3));
+    test_assert(board[Position(5, 5)] == PossibilitySet::full());
+    test_assert(board[Position(4, 8)] == PossibilitySet::full().remove(1));
+}
+
+static void testClassifyAndFindBranch() {
+    Board<PossibilitySet> board;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board[pos] = PossibilitySet(pos.j());
+        return true;
+    });
+    Position branch;
+    test_assert(classifyAndFindBranch(board, branch) == BoardState::SOLVED);
+
+    // The last position is outside the vectorized part of the scan.
+    board[Position(8, 8)].add(0).add(1);
+    test_assert(classifyAndFindBranch(board, branch) ==
+            BoardState::UNSOLVED);
+    test_assert(branch == Position(8, 8));
+
+    board[Position(6, 3)].add(4).add(5).add(6);
+    test_assert(classifyAndFindBranch(board, branch) ==
+            BoardState::UNSOLVED);
+    test_assert(branch == Position(8, 8));
+    board[Position(6, 3)].remove(4);
+    test_assert(classifyAndFindBranch(board, branch) ==
+            BoardState::UNSOLVED);
+    test_assert(branch == Position(6, 3));
+    board[Position(7, 0)].add(2);
+    test_assert(findPositionWithLeastPossibilities(board) == Position(7, 0));
+
+    board[Position(8, 8)] = PossibilitySet();
+    test_assert(classifyAndFindBranch(board, branch) ==
+            BoardState::INSOLVABLE);
+}
+
+static void testBoardEquality() {
+    Board<PossibilitySet> board1, board2;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board1[pos] = board2[pos] = PossibilitySet(pos.i()).add(pos.j());
+        return true;
+    });
+    test_assert(board1 == board2);
+
+    board2[Position(8, 8)].add(0);
+    test_assert(board1 != board2);
+    board2 = board1;
+    board2[Position(3, 4)].remove(3);
+    test_assert(board1 != board2);
+}
+
 static void testAll() {
     testPossibilitySet1();
     testPossibilitySet2();
     testPossibilitySet3();
+    testPossibilitySet4();
+    testPossibilitySet5();
     testPosition1();
     testArea1();
     testArea2();
@@ -453,6 +593,11 @@ static void testAll() {
     testBoard4();
     testBoard5();
     testBoard6();
+    testBoard7();
+    testUnitMasks();
+    testConvertToCandidates();
+    testClassifyAndFindBranch();
+    testBoardEquality();
 }
 
 int main() {
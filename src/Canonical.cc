@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "Canonical.hh"
+
+using std::array;
+using std::vector;
+
+
+Transform::Transform() noexcept : mTransposed(false) {
+    for (Number n = 0; n < N; n++)
+        mRows[n] = mColumns[n] = mNumbers[n] = n;
+}
+
+/** The source and result boards must not be the same object. */
+void Transform::apply(const Board<Number> &source, Board<Number> &result)
+        const noexcept {
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        Position from(mRows[pos.i()], mColumns[pos.j()]);
+        if (mTransposed)
+            from = Position(from.j(), from.i());
+        Number n = source[from];
+        result[pos] = n < N ? mNumbers[n] : N;
+        return true;
+    });
+}
+
+Transform Transform::inverse() const noexcept {
+    array<Number, N> rows, columns, numbers;
+    for (Number n = 0; n < N; n++) {
+        rows[mRows[n]] = n;
+        columns[mColumns[n]] = n;
+        numbers[mNumbers[n]] = n;
+    }
+
+    // Undoing "transpose, then permute" is "permute, then transpose", which
+    // is the same as transposing first with the permutations swapped.
+    if (mTransposed)
+        return Transform(true, columns, rows, numbers);
+    return Transform(false, rows, columns, numbers);
+}
+
+namespace {
+
+using Order = array<Number, N>;
+using Keys = array<unsigned, N>;
+using Cells = array<Number, N * N>;
+
+/** The labelling of numbers after the first rows of a candidate. */
+struct Prefix {
+    Order labels;
+    Number nextLabel;
+    /** Whether the rows so far are smaller than those of the best. */
+    bool smaller;
+};
+
+} // namespace
+
+/**
+ * Computes a key for every row and column that does not change when rows,
+ * columns or numbers are permuted: the number of clues in the line and the
+ * total number of clues in the crossing lines through those clues.
+ */
+static void computeKeys(const Cells &cells, Keys &rowKeys, Keys &columnKeys) {
+    Keys rowCounts = Keys(), columnCounts = Keys();
+    for (Number i = 0; i < N; i++) {
+        for (Number j = 0; j < N; j++) {
+            if (cells[i * N + j] < N) {
+                rowCounts[i]++;
+                columnCounts[j]++;
+            }
+        }
+    }
+
+    for (Number k = 0; k < N; k++) {
+        rowKeys[k] = rowCounts[k] * (N * N + 1);
+        columnKeys[k] = columnCounts[k] * (N * N + 1);
+    }
+    for (Number i = 0; i < N; i++) {
+        for (Number j = 0; j < N; j++) {
+            if (cells[i * N + j] < N) {
+                rowKeys[i] += columnCounts[j];
+                columnKeys[j] += rowCounts[i];
+            }
+        }
+    }
+}
+
+/**
+ * Lists the orders of rows (or columns) that keep bands (or stacks) together,
+ * sort the lines in each band by descending key, and sort the bands by the
+ * descending sequences of their keys.
+ */
+static vector<Order> sortedOrders(const Keys &keys) {
+    array<vector<unsigned>, Nsub> groupKeys;
+    array<vector<array<Number, Nsub>>, Nsub> memberOrders;
+
+    for (Number g = 0; g < Nsub; g++) {
+        array<Number, Nsub> members;
+        for (Number m = 0; m < Nsub; m++)
+            members[m] = g * Nsub + m;
+
+        do {
+            bool sorted = true;
+            for (Number m = 1; m < Nsub; m++)
+                if (keys[members[m - 1]] < keys[members[m]])
+                    sorted = false;
+            if (sorted)
+                memberOrders[g].push_back(members);
+        } while (std::next_permutation(members.begin(), members.end()));
+
+        for (Number m : memberOrders[g].front())
+            groupKeys[g].push_back(keys[m]);
+    }
+
+    vector<Order> orders;
+    array<Number, Nsub> groups;
+    for (Number g = 0; g < Nsub; g++)
+        groups[g] = g;
+
+    do {
+        bool sorted = true;
+        for (Number g = 1; g < Nsub; g++)
+            if (groupKeys[groups[g - 1]] < groupKeys[groups[g]])
+                sorted = false;
+        if (!sorted)
+            continue;
+
+        Order order;
+        std::function<void(Number)> combine = [&](Number g) {
+            if (g == Nsub) {
+                orders.push_back(order);
+                return;
+            }
+            for (const array<Number, Nsub> &members :
+                    memberOrders[groups[g]]) {
+                std::copy(members.begin(), members.end(),
+                        order.begin() + g * Nsub);
+                combine(g + 1);
+            }
+        };
+        combine(0);
+    } while (std::next_permutation(groups.begin(), groups.end()));
+
+    return orders;
+}
+
+bool canonicalize(
+        const Board<Number> &board,
+        Board<Number> &canonicalBoard,
+        Transform &transform,
+        std::size_t rowLimit)
+        noexcept {
+    // Cell values of the best candidate: 0 for a blank and 1 + label for a
+    // number, where labels are assigned in the order of first appearance.
+    Cells best, candidate;
+    bool found = false;
+    std::size_t rowCount = 0;
+
+    for (int t = 0; t < 2; t++) {
+        bool transposed = t != 0;
+        Cells cells;
+        wholeArea.forAllPositions([&](Position pos) -> bool {
+            Number n = transposed ? board[Position(pos.j(), pos.i())] :
+                    board[pos];
+            cells[pos.i() * N + pos.j()] = n < N ? n : N;
+            return true;
+        });
+
+        Keys rowKeys, columnKeys;
+        computeKeys(cells, rowKeys, columnKeys);
+        vector<Order> rowOrders = sortedOrders(rowKeys);
+        vector<Order> columnOrders = sortedOrders(columnKeys);
+        std::sort(rowOrders.begin(), rowOrders.end());
+
+        // The row orders are sorted, so an order shares its first rows with
+        // the one before it and starts from the prefix left by that one. A
+        // row larger than the same row of the best rejects every order with
+        // the same rows up to it.
+        for (const Order &columns : columnOrders) {
+            array<Prefix, N + 1> prefixes;
+            prefixes[0].labels.fill(N);
+            prefixes[0].nextLabel = 0;
+            prefixes[0].smaller = !found;
+            const Order *previous = nullptr;
+            Number valid = 0, rejectedRow = N;
+
+            for (const Order &rows : rowOrders) {
+                Number shared = 0;
+                if (previous != nullptr)
+                    while (shared < N && rows[shared] == (*previous)[shared])
+                        shared++;
+                previous = &rows;
+                if (shared > rejectedRow)
+                    continue;
+                rejectedRow = N;
+
+                Number i = std::min(shared, valid);
+                for (; i < N; i++) {
+                    if (++rowCount > rowLimit)
+                        return false;
+                    Prefix prefix = prefixes[i];
+                    const Number *row = &cells[rows[i] * N];
+                    bool rejected = false;
+                    for (Number j = 0; j < N; j++) {
+                        Number n = row[columns[j]], value = 0;
+                        if (n < N) {
+                            if (prefix.labels[n] == N)
+                                prefix.labels[n] = prefix.nextLabel++;
+                            value = prefix.labels[n] + 1;
+                        }
+
+                        Number index = i * N + j;
+                        if (!prefix.smaller) {
+                            if (value > best[index]) {
+                                rejected = true;
+                                break;
+                            }
+                            prefix.smaller = value < best[index];
+                        }
+                        candidate[index] = value;
+                    }
+                    if (rejected)
+                        break;
+                    prefixes[i + 1] = prefix;
+                }
+                valid = i;
+                if (i < N) {
+                    rejectedRow = i;
+                    continue;
+                }
+                if (!prefixes[N].smaller)
+                    continue;
+
+                Order labels = prefixes[N].labels;
+                Number nextLabel = prefixes[N].nextLabel;
+                for (Number n = 0; n < N; n++)
+                    if (labels[n] == N)
+                        labels[n] = nextLabel++;
+                best = candidate;
+                transform = Transform(transposed, rows, columns, labels);
+                found = true;
+                // The rows of the order are now those of the best.
+                for (Prefix &prefix : prefixes)
+                    prefix.smaller = false;
+            }
+        }
+    }
+
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        Number value = best[pos.i() * N + pos.j()];
+        canonicalBoard[pos] = value == 0 ? N : value - 1;
+        return true;
+    });
+    return true;
+}
+
+Transform canonicalize(
+        const Board<Number> &board,
+        Board<Number> &canonicalBoard)
+        noexcept {
+    Transform transform;
+    canonicalize(board, canonicalBoard, transform,
+            std::numeric_limits<std::size_t>::max());
+    return transform;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,81 @@
+#ifndef INCLUDED_CANONICAL_HH
+#define INCLUDED_CANONICAL_HH 1
+
+
+#include <array>
+#include <cstddef>
+#include "Board.hh"
+
+
+/**
+ * A validity-preserving symmetry of the board: an optional transposition,
+ * followed by a permutation of rows and columns that keeps bands and stacks
+ * together, followed by a relabelling of numbers. Blanks (numbers not less
+ * than N) are mapped to N.
+ */
+class Transform {
+
+private:
+
+    bool mTransposed;
+    /** Row i of the result is taken from row mRows[i] of the source. */
+    std::array<Number, N> mRows;
+    /** Column j of the result is taken from column mColumns[j]. */
+    std::array<Number, N> mColumns;
+    /** Number n of the source becomes mNumbers[n] in the result. */
+    std::array<Number, N> mNumbers;
+
+public:
+
+    /** Constructs the identity transform. */
+    Transform() noexcept;
+
+    Transform(
+            bool transposed,
+            const std::array<Number, N> &rows,
+            const std::array<Number, N> &columns,
+            const std::array<Number, N> &numbers) noexcept :
+            mTransposed(transposed),
+            mRows(rows),
+            mColumns(columns),
+            mNumbers(numbers) { }
+
+    bool isTransposed() const noexcept { return mTransposed; }
+
+    void apply(const Board<Number> &source, Board<Number> &result)
+            const noexcept;
+
+    Transform inverse() const noexcept;
+
+};
+
+/**
+ * Computes the canonical form of the given board: the lexicographically
+ * smallest (in row-major order, blanks first) of the transformed boards that
+ * have their rows and columns ordered by clue statistics that are invariant
+ * under all transforms. Boards that are transforms of each other have the
+ * same canonical form. Returns the transform that maps the board to the
+ * canonical form.
+ */
+extern Transform canonicalize(
+        const Board<Number> &board,
+        Board<Number> &canonicalBoard)
+        noexcept;
+
+/**
+ * Like the above, but gives up and returns false once more than rowLimit
+ * rows of transformed boards have been compared. Boards with many
+ * symmetries, like a blank board or a full grid, tie in every row and take
+ * the longest.
+ */
+extern bool canonicalize(
+        const Board<Number> &board,
+        Board<Number> &canonicalBoard,
+        Transform &transform,
+        std::size_t rowLimit)
+        noexcept;
+
+
+#endif // #ifndef INCLUDED_CANONICAL_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
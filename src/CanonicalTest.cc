@@ -0,0 +1,132 @@
+#include <array>
+#include <string>
+#include "Canonical.hh"
+#include "Format.hh"
+#include "SolutionCache.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+using std::array;
+using std::string;
+
+
+static const string otherProblemLine =
+        "000000010400000000020000000000050407008000300"
+        "001090000300400200050100000000806000";
+
+static Board<Number> lineBoard(const string &line) {
+    Board<Number> board;
+    parseLine(line, board);
+    return board;
+}
+
+static Transform someTransform(bool transposed) {
+    array<Number, N> rows = {{ 7, 6, 8, 0, 2, 1, 3, 4, 5 }};
+    array<Number, N> columns = {{ 3, 5, 4, 6, 7, 8, 1, 0, 2 }};
+    array<Number, N> numbers = {{ 4, 8, 0, 3, 7, 1, 2, 6, 5 }};
+    return Transform(transposed, rows, columns, numbers);
+}
+
+static void testTransform() {
+    Board<Number> board = lineBoard(problemLine), result1, result2;
+
+    Transform().apply(board, result1);
+    test_assert(formatLine(result1) == problemLine);
+
+    for (bool transposed : { false, true }) {
+        Transform transform = someTransform(transposed);
+        transform.apply(board, result1);
+        test_assert(formatLine(result1) != problemLine);
+        test_assert(result1[Position(0, 0)] == N);
+        transform.inverse().apply(result1, result2);
+        test_assert(formatLine(result2) == problemLine);
+    }
+}
+
+static void testCanonicalize() {
+    Board<Number> board = lineBoard(problemLine);
+    Board<Number> canonical1, canonical2, canonical3, transformed;
+
+    Transform transform1 = canonicalize(board, canonical1);
+    transform1.apply(board, transformed);
+    test_assert(formatLine(transformed) == formatLine(canonical1));
+
+    for (bool transposed : { false, true }) {
+        someTransform(transposed).apply(board, transformed);
+        Transform transform2 = canonicalize(transformed, canonical2);
+        test_assert(formatLine(canonical2) == formatLine(canonical1));
+
+        Board<Number> restored;
+        transform2.inverse().apply(canonical2, restored);
+        test_assert(formatLine(restored) == formatLine(transformed));
+    }
+
+    canonicalize(canonical1, canonical3);
+    test_assert(formatLine(canonical3) == formatLine(canonical1));
+
+    canonicalize(lineBoard(otherProblemLine), canonical2);
+    test_assert(formatLine(canonical2) != formatLine(canonical1));
+
+    Transform limited;
+    test_assert(canonicalize(board, canonical2, limited, 1000));
+    test_assert(formatLine(canonical2) == formatLine(canonical1));
+    test_assert(!canonicalize(
+            lineBoard(string(N * N, '0')), canonical2, limited, 1000));
+}
+
+static void testSolutionCache() {
+    SolutionCache cache(1);
+    Board<Number> problem = lineBoard(problemLine), transformed, solution;
+
+    SearchBudget budget1;
+    test_assert(cache.solve(problem, solution, budget1) ==
+            SolveResult::UNIQUE);
+    test_assert(formatLine(solution) == solutionLine);
+    test_assert(cache.misses() == 1);
+    test_assert(cache.hits() == 0);
+
+    Transform transform = someTransform(true);
+    transform.apply(problem, transformed);
+    SearchBudget budget2;
+    test_assert(cache.solve(transformed, solution, budget2) ==
+            SolveResult::UNIQUE);
+    test_assert(budget2.nodes() == 0);
+    test_assert(cache.hits() == 1);
+
+    Board<Number> expectedSolution;
+    transform.apply(lineBoard(solutionLine), expectedSolution);
+    test_assert(formatLine(solution) == formatLine(expectedSolution));
+
+    SearchBudget budget3;
+    cache.solve(lineBoard(otherProblemLine), solution, budget3);
+    test_assert(cache.size() == 1);
+    SearchBudget budget4;
+    cache.solve(problem, solution, budget4);
+    test_assert(cache.misses() == 3);
+    test_assert(formatLine(solution) == solutionLine);
+
+    SearchBudget budget5(1);
+    Board<Number> emptyProblem = lineBoard(string(N * N, '0'));
+    test_assert(cache.solve(emptyProblem, solution, budget5) ==
+            SolveResult::ABORTED);
+    SearchBudget budget6(1);
+    test_assert(cache.solve(emptyProblem, solution, budget6) ==
+            SolveResult::ABORTED);
+    test_assert(cache.hits() == 1);
+    // The blank board skips the cache.
+    test_assert(cache.misses() == 3);
+}
+
+static void testAll() {
+    testTransform();
+    testCanonicalize();
+    testSolutionCache();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <fstream>
+#include <ios>
+#include <sstream>
+#include "Checkpoint.hh"
+#include "Format.hh"
+
+using std::istringstream;
+using std::size_t;
+using std::string;
+
+
+static const char header[] = "sudoku-checkpoint 2";
+
+void CheckpointFile::setOptions(const SearchOptions &options) noexcept {
+    backend = options.backend;
+    valueOrder = options.valueOrder;
+    tieBreak = options.tieBreak;
+    seed = options.seed;
+    shard = options.shard;
+}
+
+bool CheckpointFile::hasOptions(const SearchOptions &options) const noexcept {
+    return backend == options.backend && valueOrder == options.valueOrder &&
+            tieBreak == options.tieBreak && seed == options.seed &&
+            shard.index == options.shard.index &&
+            shard.count == options.shard.count &&
+            shard.depth == options.shard.depth;
+}
+
+std::ostream &operator<<(std::ostream &os, const CheckpointFile &checkpoint) {
+    const SearchCheckpoint &search = checkpoint.search;
+    os << header << '\n'
+            << "problem " << formatLine(checkpoint.problem) << '\n'
+            << "search " << backendName(checkpoint.backend) << ' ' <<
+                    valueOrderName(checkpoint.valueOrder) << ' ' <<
+                    tieBreakName(checkpoint.tieBreak) << ' ' <<
+                    checkpoint.seed << ' ' << checkpoint.shard.index <<
+                    '/' << checkpoint.shard.count << ' ' <<
+                    checkpoint.shard.depth << '\n'
+            << "output " << checkpoint.outputSize << '\n'
+            << "count " << search.count << '\n'
+            << "units " << search.unit << ' ' << search.firstUnit << ' ' <<
+                    search.lastUnit << '\n'
+            << "frames " << search.frames.size() << '\n';
+    for (const SearchCheckpoint::Frame &frame : search.frames)
+        os << "frame " << frame.position.i() + 1 << ' ' <<
+                frame.position.j() + 1 << ' ' <<
+                formatCellCandidates(frame.untried) << ' ' <<
+                frame.solutions <<
+                ' ' << formatCandidates(frame.board) << '\n';
+    return os;
+}
+
+/** Reads a line that starts with the keyword and returns the rest of it. */
+static bool readField(std::istream &is, const char *keyword, string &rest) {
+    string line;
+    if (!std::getline(is, line))
+        return false;
+    string prefix = string(keyword) + ' ';
+    if (line.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    rest = line.substr(prefix.size());
+    return true;
+}
+
+static bool readFrame(std::istream &is, SearchCheckpoint::Frame &frame) {
+    string rest, untried;
+    size_t i, j;
+    if (!readField(is, "frame", rest))
+        return false;
+
+    istringstream fields(rest);
+    if (!(fields >> i >> j >> untried >> frame.solutions) ||
+            i < 1 || i > N || j < 1 || j > N ||
+            !parseCellCandidates(untried, frame.untried) ||
+            fields.get() != ' ')
+        return false;
+    frame.position = Position(i - 1, j - 1);
+
+    string marks;
+    std::getline(fields, marks);
+    return parseCandidates(marks, frame.board);
+}
+
+/** Reads the options of the search from the "search" line. */
+static bool parseOptions(const string &text, CheckpointFile &checkpoint) {
+    istringstream fields(text);
+    string backend, valueOrder, tieBreak, shard;
+    return fields >> backend >> valueOrder >> tieBreak >> checkpoint.seed >>
+                    shard >> checkpoint.shard.depth &&
+            fields.get() == EOF &&
+            parseBackend(backend, checkpoint.backend) &&
+            parseValueOrder(valueOrder, checkpoint.valueOrder) &&
+            parseTieBreak(tieBreak, checkpoint.tieBreak) &&
+            parseShard(shard, checkpoint.shard);
+}
+
+std::istream &operator>>(std::istream &is, CheckpointFile &checkpoint) {
+    SearchCheckpoint &search = checkpoint.search;
+    string line, problem, options, output, count, units, frames;
+    size_t frameCount;
+    bool valid = std::getline(is, line) && line == header &&
+            readField(is, "problem", problem) &&
+            parseLine(problem, checkpoint.problem) &&
+            readField(is, "search", options) &&
+            parseOptions(options, checkpoint) &&
+            readField(is, "output", output) &&
+            istringstream(output) >> checkpoint.outputSize &&
+            readField(is, "count", count) &&
+            istringstream(count) >> search.count &&
+            readField(is, "units", units) &&
+            istringstream(units) >> search.unit >> search.firstUnit >>
+                    search.lastUnit &&
+            readField(is, "frames", frames) &&
+            istringstream(frames) >> frameCount && frameCount <= N * N;
+
+    if (valid) {
+        search.frames.clear();
+        search.frames.resize(frameCount);
+        for (SearchCheckpoint::Frame &frame : search.frames)
+            valid = valid && readFrame(is, frame);
+    }
+    if (!valid)
+        is.setstate(std::ios::failbit);
+    return is;
+}
+
+bool saveCheckpoint(const string &path, const CheckpointFile &checkpoint) {
+    string temporary = path + ".tmp";
+    {
+        std::ofstream os(temporary);
+        if (!(os << checkpoint) || !os.flush())
+            return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+LoadResult loadCheckpoint(const string &path, CheckpointFile &checkpoint) {
+    std::ifstream is(path);
+    if (!is.is_open())
+        return LoadResult::MISSING;
+    return is >> checkpoint ? LoadResult::LOADED : LoadResult::MALFORMED;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
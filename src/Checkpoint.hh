@@ -0,0 +1,73 @@
+#ifndef INCLUDED_CHECKPOINT_HH
+#define INCLUDED_CHECKPOINT_HH 1
+
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "Board.hh"
+#include "Solver.hh"
+
+
+/**
+ * Everything needed to resume printing the solutions of a problem: the
+ * problem, the options that shape the search tree, the search checkpoint,
+ * and the size the output had when the checkpoint was taken, or -1 if the
+ * output is not a regular file.
+ */
+struct CheckpointFile {
+    Board<Number> problem;
+    Backend backend = Backend::CELLS;
+    ValueOrder valueOrder = ValueOrder::ASCENDING;
+    TieBreak tieBreak = TieBreak::FIRST;
+    std::uint64_t seed = 0;
+    Shard shard;
+    SearchCheckpoint search;
+    std::int64_t outputSize = -1;
+
+    /** Records the options of the search that takes the checkpoints. */
+    void setOptions(const SearchOptions &options) noexcept;
+
+    /** Returns true if a search with the options can resume from here. */
+    bool hasOptions(const SearchOptions &options) const noexcept;
+};
+
+/**
+ * Writes the checkpoint as text: a header line, then one line for each of
+ * the problem, the search options (backend, value order, tie-break, seed and
+ * shard), the output size, the solution count and the shard units, then one
+ * line per frame with the branch position (from 1), the untried numbers,
+ * the solutions found below it and its pencil marks (see formatCandidates).
+ */
+extern std::ostream &operator<<(
+        std::ostream &os,
+        const CheckpointFile &checkpoint);
+
+/** Reads a checkpoint written by operator<<, failing the stream if bad. */
+extern std::istream &operator>>(std::istream &is, CheckpointFile &checkpoint);
+
+/**
+ * Writes the checkpoint to a temporary file next to the path and renames it
+ * over the path, so a job killed while saving leaves the previous checkpoint.
+ */
+extern bool saveCheckpoint(
+        const std::string &path,
+        const CheckpointFile &checkpoint);
+
+/** The outcome of loadCheckpoint. */
+enum class LoadResult {
+    LOADED,
+    /** The file cannot be opened. */
+    MISSING,
+    /** The file is not a checkpoint. */
+    MALFORMED,
+};
+
+extern LoadResult loadCheckpoint(
+        const std::string &path,
+        CheckpointFile &checkpoint);
+
+
+#endif // #ifndef INCLUDED_CHECKPOINT_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
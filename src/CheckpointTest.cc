@@ -0,0 +1,178 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Board.hh"
+#include "Checkpoint.hh"
+#include "Format.hh"
+#include "Solver.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+static std::string toString(const CheckpointFile &checkpoint) {
+    std::ostringstream os;
+    os << checkpoint;
+    return os.str();
+}
+
+static void testResume(
+        Backend backend, ValueOrder valueOrder = ValueOrder::ASCENDING) {
+    CheckpointFile file;
+    parseLine(openProblemLine, file.problem);
+    Board<PossibilitySet> board;
+    convertToCandidates(file.problem, board);
+
+    SearchOptions options;
+    options.backend = backend;
+    options.valueOrder = valueOrder;
+    options.seed = 7;
+    file.setOptions(options);
+    std::vector<Board<Number>> all;
+    iterateSolutions(board, [&](const Board<Number> &solution) {
+        all.push_back(solution);
+    }, options);
+    test_assert(all.size() == 120);
+
+    // Stop at every checkpoint and resume from its saved text.
+    std::vector<Board<Number>> resumed;
+    std::string saved;
+    options.checkpointInterval = 7;
+    options.checkpoint = [&](const SearchCheckpoint &checkpoint) {
+        file.search = checkpoint;
+        saved = toString(file);
+        return false;
+    };
+    std::size_t runs = 0;
+    for (;;) {
+        saved.clear();
+        iterateSolutions(board, [&](const Board<Number> &solution) {
+            resumed.push_back(solution);
+        }, options);
+        runs++;
+        if (saved.empty())
+            break;
+
+        CheckpointFile loaded;
+        std::istringstream is(saved);
+        test_assert(is >> loaded);
+        test_assert(toString(loaded) == saved);
+        test_assert(loaded.search.count == resumed.size());
+        test_assert(loaded.hasOptions(options));
+        file = loaded;
+        options.resume = &file.search;
+    }
+    test_assert(runs > 10);
+    test_assert(resumed == all);
+
+    // Counting resumes with the solutions counted before the checkpoint.
+    options.resume = nullptr;
+    options.checkpointInterval = 50;
+    SearchBudget budget1;
+    std::size_t count;
+    test_assert(!countSolutions(board, count, budget1, options));
+    test_assert(!saved.empty());
+    std::istringstream is(saved);
+    test_assert(is >> file);
+    options.resume = &file.search;
+    options.checkpoint = nullptr;
+    SearchBudget budget2;
+    test_assert(countSolutions(board, count, budget2, options));
+    test_assert(count == all.size());
+}
+
+static void testMalformed() {
+    CheckpointFile file;
+    parseLine(openProblemLine, file.problem);
+    file.search.frames.resize(1);
+    convertToCandidates(file.problem, file.search.frames[0].board);
+    file.search.frames[0].untried = PossibilitySet(2).add(5);
+    std::string text = toString(file);
+    test_assert(text.find("\nframe 1 1 36 0 ") != std::string::npos);
+
+    CheckpointFile loaded;
+    std::istringstream is1(text);
+    test_assert(is1 >> loaded);
+    test_assert(loaded.search.frames.size() == 1);
+    test_assert(loaded.search.frames[0].untried ==
+            file.search.frames[0].untried);
+
+    std::istringstream is2(text.substr(0, text.size() - 5));
+    test_assert(!(is2 >> loaded));
+    std::istringstream is3("sudoku-checkpoint 1\n" +
+            text.substr(text.find('\n') + 1));
+    test_assert(!(is3 >> loaded));
+}
+
+static void testOptions() {
+    CheckpointFile file;
+    parseLine(openProblemLine, file.problem);
+    SearchOptions options;
+    options.backend = Backend::BITBOARD;
+    options.valueOrder = ValueOrder::RANDOM;
+    options.tieBreak = TieBreak::DEGREE;
+    options.seed = 12345678901234ull;
+    test_assert(parseShard("2/5", options.shard));
+    options.shard.depth = 3;
+    file.setOptions(options);
+    std::string text = toString(file);
+    test_assert(text.find("\nsearch bitboard random degree 12345678901234 "
+                "2/5 3\n") != std::string::npos);
+
+    CheckpointFile loaded;
+    std::istringstream is(text);
+    test_assert(is >> loaded);
+    test_assert(loaded.hasOptions(options));
+
+    // A search that would visit another tree cannot resume.
+    SearchOptions other = options;
+    other.backend = Backend::CELLS;
+    test_assert(!loaded.hasOptions(other));
+    other = options;
+    other.valueOrder = ValueOrder::DESCENDING;
+    test_assert(!loaded.hasOptions(other));
+    other = options;
+    other.tieBreak = TieBreak::FIRST;
+    test_assert(!loaded.hasOptions(other));
+    other = options;
+    other.seed++;
+    test_assert(!loaded.hasOptions(other));
+    other = options;
+    other.shard.index = 1;
+    test_assert(!loaded.hasOptions(other));
+}
+
+static void testLoad() {
+    const std::string path = "CheckpointTest.tmp";
+    std::remove(path.c_str());
+    CheckpointFile file, loaded;
+    parseLine(openProblemLine, file.problem);
+    test_assert(loadCheckpoint(path, loaded) == LoadResult::MISSING);
+
+    test_assert(saveCheckpoint(path, file));
+    test_assert(loadCheckpoint(path, loaded) == LoadResult::LOADED);
+    test_assert(loaded.problem == file.problem);
+
+    std::ofstream(path) << "sudoku-checkpoint 2\nproblem 123\n";
+    test_assert(loadCheckpoint(path, loaded) == LoadResult::MALFORMED);
+    std::remove(path.c_str());
+}
+
+static void testAll() {
+    testResume(Backend::CELLS);
+    testResume(Backend::BITBOARD);
+    // Random orders resume alike since they follow from the boards.
+    testResume(Backend::CELLS, ValueOrder::RANDOM);
+    testMalformed();
+    testOptions();
+    testLoad();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,342 @@
+#include <stdexcept>
+#include "ConstraintGraph.hh"
+
+using std::array;
+using std::invalid_argument;
+using std::vector;
+
+
+namespace {
+
+constexpr unsigned maxSum = N * (N + 1) / 2;
+
+/** The sets of numbers of every size and sum, computed once. */
+struct CombinationTable {
+
+    array<array<vector<PossibilitySet::Bits>, maxSum + 1>, N + 1> masks;
+
+    CombinationTable() {
+        for (unsigned bits = 0; bits <= PossibilitySet::full().bits();
+                bits++) {
+            PossibilitySet set = PossibilitySet::fromBits(
+                    static_cast<PossibilitySet::Bits>(bits));
+            unsigned sum = 0;
+            for (Number n = 0; n < N; n++)
+                if (set.contains(n))
+                    sum += n + 1;
+            masks[set.count()][sum].push_back(set.bits());
+        }
+    }
+
+};
+
+const CombinationTable combinationTable;
+
+const vector<PossibilitySet::Bits> noCombinations;
+
+/**
+ * Removes the numbers placed in the unit from its other positions. Returns
+ * false if a number is placed twice or a position runs out of candidates.
+ */
+bool eliminate(
+        const ConstraintGraph::Unit &unit,
+        PossibilitySet *cells,
+        CellSet &changed) noexcept {
+    PossibilitySet placed;
+    for (std::size_t k = 0; k < unit.size; k++) {
+        const PossibilitySet &pset = cells[unit.cells[k]];
+        if (!pset.isUnique())
+            continue;
+        if (!(placed & pset).isEmpty())
+            return false;
+        placed |= pset;
+    }
+    if (placed.isEmpty())
+        return true;
+
+    for (std::size_t k = 0; k < unit.size; k++) {
+        PossibilitySet &pset = cells[unit.cells[k]];
+        if (pset.isUnique() || (pset & placed).isEmpty())
+            continue;
+        pset -= placed;
+        if (pset.isEmpty())
+            return false;
+        changed.add(unit.cells[k]);
+    }
+    return true;
+}
+
+/**
+ * Places the numbers that have a single position left in a unit of N
+ * positions. Returns false if a number has no position left or a position
+ * is the only one of two numbers.
+ */
+bool fixUniquePossibilities(
+        const ConstraintGraph::Unit &unit,
+        PossibilitySet *cells,
+        CellSet &changed) noexcept {
+    PossibilitySet once, twice;
+    for (std::size_t k = 0; k < unit.size; k++) {
+        const PossibilitySet &pset = cells[unit.cells[k]];
+        twice |= once & pset;
+        once |= pset;
+    }
+    if (once != PossibilitySet::full())
+        return false;
+
+    PossibilitySet unique = once - twice;
+    if (unique.isEmpty())
+        return true;
+
+    for (std::size_t k = 0; k < unit.size; k++) {
+        PossibilitySet &pset = cells[unit.cells[k]];
+        PossibilitySet found = pset & unique;
+        if (found.isEmpty() || found == pset)
+            continue;
+        if (!found.isUnique())
+            return false;
+        pset = found;
+        changed.add(unit.cells[k]);
+    }
+    return true;
+}
+
+/**
+ * Leaves the open positions of the cage only the numbers of the
+ * combinations that add up to what is left of the sum, avoid the placed
+ * numbers and can be placed in the open positions. Returns false if no
+ * combination is left.
+ */
+bool pruneCage(
+        const ConstraintGraph::Cage &cage,
+        PossibilitySet *cells,
+        CellSet &changed) noexcept {
+    const ConstraintGraph::Unit &unit = cage.unit;
+    PossibilitySet placed, open;
+    std::size_t openCount = 0;
+    unsigned placedSum = 0;
+    for (std::size_t k = 0; k < unit.size; k++) {
+        const PossibilitySet &pset = cells[unit.cells[k]];
+        if (pset.isUnique()) {
+            placed |= pset;
+            placedSum += pset.first() + 1;
+        } else {
+            open |= pset;
+            openCount++;
+        }
+    }
+    if (placedSum > cage.sum)
+        return false;
+    if (openCount == 0)
+        return placedSum == cage.sum;
+
+    PossibilitySet::Bits allowed = 0;
+    for (PossibilitySet::Bits mask :
+            combinations(openCount, cage.sum - placedSum))
+        if ((mask & placed.bits()) == 0 && (mask & ~open.bits()) == 0)
+            allowed |= mask;
+    if (allowed == 0)
+        return false;
+
+    PossibilitySet numbers = PossibilitySet::fromBits(allowed);
+    for (std::size_t k = 0; k < unit.size; k++) {
+        PossibilitySet &pset = cells[unit.cells[k]];
+        if (pset.isUnique() || (pset - numbers).isEmpty())
+            continue;
+        pset &= numbers;
+        if (pset.isEmpty())
+            return false;
+        changed.add(unit.cells[k]);
+    }
+    return true;
+}
+
+} // namespace
+
+const vector<PossibilitySet::Bits> &combinations(
+        std::size_t k, unsigned sum) noexcept {
+    if (k > N || sum > maxSum)
+        return noCombinations;
+    return combinationTable.masks[k][sum];
+}
+
+ConstraintGraph::ConstraintGraph() noexcept : mPeers() { }
+
+ConstraintGraph::Unit ConstraintGraph::makeUnit(
+        const vector<Position> &positions) {
+    if (positions.size() > N)
+        throw invalid_argument("a unit has more than N positions");
+
+    Unit unit;
+    unit.size = 0;
+    for (const Position &pos : positions) {
+        if (!pos.isValid())
+            throw invalid_argument("a unit has an invalid position");
+        Number index = CellSet::index(pos);
+        if (unit.positions.contains(index))
+            throw invalid_argument("a unit has a position twice");
+        unit.positions.add(index);
+        unit.cells[unit.size++] = index;
+    }
+    return unit;
+}
+
+void ConstraintGraph::addPeers(const Unit &unit) noexcept {
+    for (std::size_t k = 0; k < unit.size; k++)
+        mPeers[unit.cells[k]] |= unit.positions - CellSet::of(unit.cells[k]);
+}
+
+void ConstraintGraph::addUnit(const vector<Position> &positions) {
+    Unit unit = makeUnit(positions);
+    addPeers(unit);
+    mUnits.push_back(unit);
+}
+
+void ConstraintGraph::addCage(
+        const vector<Position> &positions, unsigned sum) {
+    Cage cage;
+    cage.unit = makeUnit(positions);
+    cage.sum = sum;
+    PossibilitySet::Bits numbers = 0;
+    for (PossibilitySet::Bits mask : combinations(cage.unit.size, sum))
+        numbers |= mask;
+    cage.numbers = PossibilitySet::fromBits(numbers);
+    addPeers(cage.unit);
+    mCages.push_back(cage);
+}
+
+ConstraintGraph ConstraintGraph::classic() {
+    ConstraintGraph graph;
+    for (const CellSet &unitCellSet : unitCells()) {
+        vector<Position> positions;
+        for (CellSet cells = unitCellSet; !cells.isEmpty(); ) {
+            Number index = cells.first();
+            cells.remove(index);
+            positions.push_back(CellSet::position(index));
+        }
+        graph.addUnit(positions);
+    }
+    return graph;
+}
+
+ConstraintGraph ConstraintGraph::diagonal() {
+    ConstraintGraph graph = classic();
+    vector<Position> main, anti;
+    for (Number k = 0; k < N; k++) {
+        main.push_back(Position(k, k));
+        anti.push_back(Position(k, N - 1 - k));
+    }
+    graph.addUnit(main);
+    graph.addUnit(anti);
+    return graph;
+}
+
+ConstraintGraph ConstraintGraph::jigsaw(const Board<Number> &regions) {
+    ConstraintGraph graph;
+    array<vector<Position>, N> rows, columns, areas;
+    for (Number i = 0; i < N; i++) {
+        for (Number j = 0; j < N; j++) {
+            Number region = regions[Position(i, j)];
+            if (region >= N)
+                throw invalid_argument("a region index is out of range");
+            rows[i].push_back(Position(i, j));
+            columns[j].push_back(Position(i, j));
+            areas[region].push_back(Position(i, j));
+        }
+    }
+    for (const vector<Position> &area : areas)
+        if (area.size() != N)
+            throw invalid_argument("a region does not have N positions");
+
+    for (const vector<Position> &row : rows)
+        graph.addUnit(row);
+    for (const vector<Position> &column : columns)
+        graph.addUnit(column);
+    for (const vector<Position> &area : areas)
+        graph.addUnit(area);
+    return graph;
+}
+
+bool ConstraintGraph::propagate(Board<PossibilitySet> &board) const noexcept {
+    return propagate(board, CellSet::all());
+}
+
+bool ConstraintGraph::propagate(
+        Board<PossibilitySet> &board, CellSet changed) const noexcept {
+    PossibilitySet *cells = board.data();
+    for (const Cage &cage : mCages) {
+        for (std::size_t k = 0; k < cage.unit.size; k++) {
+            PossibilitySet &pset = cells[cage.unit.cells[k]];
+            if (!(pset - cage.numbers).isEmpty()) {
+                pset &= cage.numbers;
+                changed.add(cage.unit.cells[k]);
+            }
+        }
+    }
+
+    // A constraint is checked again only if one of its positions changed
+    // since it was last checked. The hidden singles wait until the
+    // eliminations settle, and then look at the units of every position
+    // changed since they last ran.
+    CellSet unsettled = changed;
+    while (!changed.isEmpty()) {
+        CellSet dirty = changed;
+        changed = CellSet();
+        for (const Unit &unit : mUnits)
+            if (!(unit.positions & dirty).isEmpty() &&
+                    !eliminate(unit, cells, changed))
+                return false;
+        for (const Cage &cage : mCages)
+            if (!(cage.unit.positions & dirty).isEmpty() &&
+                    (!eliminate(cage.unit, cells, changed) ||
+                        !pruneCage(cage, cells, changed)))
+                return false;
+        unsettled |= changed;
+        if (!changed.isEmpty())
+            continue;
+
+        dirty = unsettled;
+        for (const Unit &unit : mUnits)
+            if (unit.size == N && !(unit.positions & dirty).isEmpty() &&
+                    !fixUniquePossibilities(unit, cells, changed))
+                return false;
+        unsettled = changed;
+    }
+
+    for (Number index = 0; index < N * N; index++)
+        if (cells[index].isEmpty())
+            return false;
+    return true;
+}
+
+bool ConstraintGraph::isSolution(const Board<Number> &board) const noexcept {
+    const Number *numbers = board.data();
+    for (Number index = 0; index < N * N; index++)
+        if (numbers[index] >= N)
+            return false;
+
+    auto isDistinct = [&](const Unit &unit) {
+        PossibilitySet seen;
+        for (std::size_t k = 0; k < unit.size; k++) {
+            Number n = numbers[unit.cells[k]];
+            if (seen.contains(n))
+                return false;
+            seen.add(n);
+        }
+        return true;
+    };
+    for (const Unit &unit : mUnits)
+        if (!isDistinct(unit))
+            return false;
+    for (const Cage &cage : mCages) {
+        unsigned sum = 0;
+        for (std::size_t k = 0; k < cage.unit.size; k++)
+            sum += numbers[cage.unit.cells[k]] + 1;
+        if (!isDistinct(cage.unit) || sum != cage.sum)
+            return false;
+    }
+    return true;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "Board.hh"
+#include "ConstraintGraph.hh"
+#include "Format.hh"
+#include "Solver.hh"
+#include "TranspositionTable.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+static std::vector<Board<Number>> allSolutions(
+        const char *line, const ConstraintGraph *graph) {
+    Board<Number> problem;
+    parseLine(line, problem);
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+    SearchOptions options;
+    options.graph = graph;
+    std::vector<Board<Number>> solutions;
+    iterateSolutions(board, [&](const Board<Number> &solution) {
+        solutions.push_back(solution);
+    }, options);
+    return solutions;
+}
+
+/**
+ * Checks that the graph finds exactly the classic solutions of the open
+ * problem that meet its constraints.
+ */
+static void testAgainstClassic(const ConstraintGraph &graph) {
+    std::vector<Board<Number>> classic =
+            allSolutions(openProblemLine, nullptr);
+    std::vector<Board<Number>> found = allSolutions(openProblemLine, &graph);
+    std::size_t expected = 0;
+    for (const Board<Number> &solution : classic) {
+        if (!graph.isSolution(solution))
+            continue;
+        expected++;
+        test_assert(std::find(found.begin(), found.end(), solution) !=
+                found.end());
+    }
+    test_assert(found.size() == expected);
+    for (const Board<Number> &solution : found)
+        test_assert(graph.isSolution(solution));
+}
+
+static void testCombinations() {
+    test_assert(combinations(2, 3) ==
+            std::vector<PossibilitySet::Bits>{0x003});
+    test_assert(combinations(3, 6) ==
+            std::vector<PossibilitySet::Bits>{0x007});
+    test_assert(combinations(9, 45) ==
+            std::vector<PossibilitySet::Bits>{0x1FF});
+    test_assert(combinations(2, 10).size() == 4);
+    test_assert(combinations(2, 18).empty());
+    test_assert(combinations(10, 45).empty());
+    test_assert(combinations(1, 100).empty());
+}
+
+static void testClassic() {
+    ConstraintGraph graph = ConstraintGraph::classic();
+    test_assert(graph.units().size() == 3 * N);
+    test_assert(graph.peers(0) == peerCells(0));
+    test_assert(allSolutions(openProblemLine, &graph).size() == 120);
+    testAgainstClassic(graph);
+
+    Board<Number> problem, solution, expected;
+    parseLine(problemLine, problem);
+    parseLine(solutionLine, expected);
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+    SearchOptions options;
+    options.graph = &graph;
+    SearchBudget budget;
+    test_assert(solve(board, solution, budget, options) ==
+            SolveResult::UNIQUE);
+    test_assert(solution == expected);
+
+    TranspositionTable table(1 << 12);
+    options.table = &table;
+    parseLine(openProblemLine, problem);
+    convertToCandidates(problem, board);
+    std::size_t count;
+    test_assert(countSolutions(board, count, budget, options));
+    test_assert(count == 120);
+}
+
+/**
+ * Checks that propagating only from an assumed position narrows the board
+ * like propagating from every position.
+ */
+static void testPropagateChanged() {
+    ConstraintGraph graph = ConstraintGraph::classic();
+    Board<Number> problem;
+    parseLine(hardProblemLine, problem);
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+    test_assert(graph.propagate(board));
+
+    std::size_t assumed = 0;
+    for (Number index = 0; index < N * N; index++) {
+        PossibilitySet pset = board.data()[index];
+        if (pset.isUnique())
+            continue;
+        for (Number n = 0; n < N; n++) {
+            if (!pset.contains(n))
+                continue;
+            Board<PossibilitySet> some = board, all;
+            some.data()[index] = PossibilitySet(n);
+            all = some;
+            bool consistent = graph.propagate(all);
+            test_assert(graph.propagate(some, CellSet::of(index)) ==
+                    consistent);
+            if (consistent)
+                test_assert(some == all);
+            assumed++;
+        }
+    }
+    test_assert(assumed > 0);
+}
+
+static void testDiagonal() {
+    ConstraintGraph graph = ConstraintGraph::diagonal();
+    test_assert(graph.units().size() == 3 * N + 2);
+    test_assert(graph.peers(0).count() == 20 + N - Nsub);
+    testAgainstClassic(graph);
+
+    Board<PossibilitySet> board;
+    for (Number i = 0; i < N; i++)
+        for (Number j = 0; j < N; j++)
+            board[Position(i, j)] = PossibilitySet::full();
+    SearchOptions options;
+    options.graph = &graph;
+    SearchBudget budget;
+    Board<Number> solution;
+    test_assert(solve(board, solution, budget, options) ==
+            SolveResult::MULTIPLE);
+    test_assert(graph.isSolution(solution));
+}
+
+static void testJigsaw() {
+    Board<Number> regions;
+    for (Number i = 0; i < N; i++)
+        for (Number j = 0; j < N; j++)
+            regions[Position(i, j)] = UnitMasks::blockIndex(Position(i, j));
+    ConstraintGraph graph = ConstraintGraph::jigsaw(regions);
+    test_assert(allSolutions(openProblemLine, &graph).size() == 120);
+
+    regions[Position(0, 0)] = 1;
+    bool thrown = false;
+    try {
+        ConstraintGraph::jigsaw(regions);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    test_assert(thrown);
+}
+
+static void testKiller() {
+    Board<Number> expected;
+    parseLine(solutionLine, expected);
+
+    // Pairs of horizontally adjacent positions with the sums of the README
+    // solution.
+    ConstraintGraph graph = ConstraintGraph::classic();
+    for (Number i = 0; i < N; i++) {
+        for (Number j = 0; j + 1 < N; j += 2) {
+            Position left(i, j), right(i, j + 1);
+            graph.addCage({left, right},
+                    expected[left] + expected[right] + 2);
+        }
+    }
+    test_assert(graph.cages().size() == N * (N / 2));
+    test_assert(graph.isSolution(expected));
+    testAgainstClassic(graph);
+    test_assert(!allSolutions(openProblemLine, &graph).empty());
+
+    graph.addCage({Position(0, 0)}, 10);
+    test_assert(allSolutions(openProblemLine, &graph).empty());
+
+    bool thrown = false;
+    try {
+        graph.addCage({Position(0, 0), Position(0, 0)}, 3);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    test_assert(thrown);
+}
+
+static void testAll() {
+    testCombinations();
+    testClassic();
+    testPropagateChanged();
+    testDiagonal();
+    testJigsaw();
+    testKiller();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
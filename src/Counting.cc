@@ -0,0 +1,316 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Counting.hh"
+
+using std::size_t;
+using std::vector;
+
+
+namespace {
+
+/**
+ * A choice among alternative restrictions of some positions. Every part of a
+ * count takes one alternative of every split.
+ */
+struct Split {
+    vector<Position> positions;
+    /** For each alternative, the candidates kept at each position. */
+    vector<vector<PossibilitySet>> alternatives;
+};
+
+} // namespace
+
+static bool isBlank(Number n) noexcept {
+    return n >= N;
+}
+
+static void transpose(const Board<Number> &src, Board<Number> &dest)
+        noexcept {
+    for (Number i = 0; i < N; i++)
+        for (Number j = 0; j < N; j++)
+            dest[Position(j, i)] = src[Position(i, j)];
+}
+
+static size_t factorial(size_t n) noexcept {
+    size_t result = 1;
+    for (size_t k = 2; k <= n; k++)
+        result *= k;
+    return result;
+}
+
+/** Returns the rows without givens, grouped by band. */
+static vector<vector<Number>> blankRowsByBand(const Board<Number> &problem) {
+    vector<vector<Number>> bands(Nsub);
+    for (Number i = 0; i < N; i++) {
+        bool blank = true;
+        for (Number j = 0; j < N; j++)
+            blank = blank && isBlank(problem[Position(i, j)]);
+        if (blank)
+            bands[i / Nsub].push_back(i);
+    }
+    return bands;
+}
+
+static size_t rowSymmetry(const vector<vector<Number>> &bands) noexcept {
+    size_t symmetry = 1;
+    for (const vector<Number> &rows : bands)
+        symmetry *= factorial(rows.size());
+    return symmetry;
+}
+
+/**
+ * Keeps the alternatives where the numbers of "numbers" occur in ascending
+ * order at the given positions, one number per position.
+ */
+static void addAscendingAlternatives(
+        const Board<PossibilitySet> &board,
+        const vector<Position> &positions,
+        const vector<Number> &numbers,
+        bool chooseNumbers,
+        Split &split) {
+    // Either some of the positions get all the numbers, or all the
+    // positions get some of the numbers.
+    size_t choices = chooseNumbers ? numbers.size() : positions.size();
+    size_t chosen = chooseNumbers ? positions.size() : numbers.size();
+    PossibilitySet all;
+    for (Number n : numbers)
+        all.add(n);
+
+    split.positions = positions;
+    for (size_t mask = 0; mask < (size_t(1) << choices); mask++) {
+        if (static_cast<size_t>(__builtin_popcountll(mask)) != chosen)
+            continue;
+
+        vector<PossibilitySet> alternative;
+        size_t numberIndex = 0;
+        bool possible = true;
+        for (size_t k = 0; k < positions.size() && possible; k++) {
+            PossibilitySet pset = board[positions[k]];
+            if (chooseNumbers) {
+                while (!((mask >> numberIndex) & 1))
+                    numberIndex++;
+                pset &= PossibilitySet(numbers[numberIndex++]);
+            } else if ((mask >> k) & 1) {
+                pset &= PossibilitySet(numbers[numberIndex++]);
+            } else {
+                pset -= all;
+            }
+            possible = !pset.isEmpty();
+            alternative.push_back(pset);
+        }
+        if (possible)
+            split.alternatives.push_back(std::move(alternative));
+    }
+}
+
+/**
+ * Adds splits on the positions with the fewest candidates that are not in
+ * another split until there are at least "parts" parts.
+ */
+static void addPositionSplits(
+        const Board<PossibilitySet> &board,
+        size_t parts,
+        vector<Split> &splits) {
+    vector<bool> used(N * N);
+    size_t current = 1;
+    for (const Split &split : splits) {
+        current *= split.alternatives.size();
+        for (const Position &pos : split.positions)
+            used[pos.i() * N + pos.j()] = true;
+    }
+
+    while (current > 0 && current < parts) {
+        Position best;
+        size_t leastCount = N + 1;
+        for (Number i = 0; i < N; i++) {
+            for (Number j = 0; j < N; j++) {
+                Position pos(i, j);
+                size_t count = board[pos].count();
+                if (!used[i * N + j] && count >= 2 && count < leastCount) {
+                    best = pos;
+                    leastCount = count;
+                }
+            }
+        }
+        if (leastCount > N)
+            return;
+
+        Split split;
+        split.positions.push_back(best);
+        PossibilitySet pset = board[best];
+        for (Number n = 0; n < N; n++)
+            if (pset.contains(n))
+                split.alternatives.push_back({PossibilitySet(n)});
+        used[best.i() * N + best.j()] = true;
+        current *= split.alternatives.size();
+        splits.push_back(std::move(split));
+    }
+}
+
+/**
+ * Returns the shard of a part. Counts add up in any order, so parts are
+ * spread over the shards by a hash of their index; taking every count-th
+ * part would give all live parts to one shard whenever the number of
+ * alternatives of a split is a multiple of the number of shards.
+ */
+static size_t shardOfPart(size_t part, size_t shardCount) noexcept {
+    std::uint64_t x = part;
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return static_cast<size_t>(x % shardCount);
+}
+
+/** Restricts the board to the index-th combination of alternatives. */
+static bool applySplits(
+        const vector<Split> &splits,
+        size_t index,
+        Board<PossibilitySet> &board) noexcept {
+    for (const Split &split : splits) {
+        size_t size = split.alternatives.size();
+        const vector<PossibilitySet> &alternative =
+                split.alternatives[index % size];
+        index /= size;
+        for (size_t k = 0; k < split.positions.size(); k++) {
+            PossibilitySet &pset = board[split.positions[k]];
+            pset &= alternative[k];
+            if (pset.isEmpty())
+                return false;
+        }
+    }
+    return true;
+}
+
+CountResult countProblemSolutions(
+        const Board<Number> &problem,
+        ThreadPool &pool,
+        size_t nodeLimit,
+        const SearchOptions &options) {
+    CountResult result;
+
+    // Blank rows and columns are reordered alike by transposing.
+    Board<Number> transposed;
+    transpose(problem, transposed);
+    vector<vector<Number>> bands = blankRowsByBand(problem);
+    vector<vector<Number>> stacks = blankRowsByBand(transposed);
+    bool useColumns = rowSymmetry(stacks) > rowSymmetry(bands);
+    const Board<Number> &board = useColumns ? transposed : problem;
+    if (useColumns)
+        bands = stacks;
+
+    Board<PossibilitySet> candidates;
+    convertToCandidates(board, candidates);
+
+    // The row with givens and the fewest blanks orders the free numbers.
+    PossibilitySet given;
+    Number orderRow = 0;
+    size_t leastBlanks = N + 1;
+    for (Number i = 0; i < N; i++) {
+        size_t blanks = 0;
+        for (Number j = 0; j < N; j++) {
+            Number n = board[Position(i, j)];
+            if (isBlank(n))
+                blanks++;
+            else
+                given.add(n);
+        }
+        if (blanks < N && blanks < leastBlanks) {
+            orderRow = i;
+            leastBlanks = blanks;
+        }
+    }
+
+    vector<Split> splits;
+    vector<Number> free;
+    for (Number n = 0; n < N; n++)
+        if (!given.contains(n))
+            free.push_back(n);
+    if (free.size() >= 2) {
+        vector<Position> blanks;
+        for (Number j = 0; j < N; j++)
+            if (isBlank(board[Position(orderRow, j)]))
+                blanks.push_back(Position(orderRow, j));
+
+        Split split;
+        addAscendingAlternatives(candidates, blanks, free, false, split);
+        splits.push_back(std::move(split));
+        result.symmetry *= factorial(free.size());
+    }
+
+    // Reordering blank rows together with relabeling numbers maps every
+    // solution to a distinct one only if some number is given.
+    if (!given.isEmpty()) {
+        vector<Number> numbers;
+        for (Number n = 0; n < N; n++)
+            numbers.push_back(n);
+        for (const vector<Number> &rows : bands) {
+            if (rows.size() < 2)
+                continue;
+
+            vector<Position> firsts;
+            for (Number i : rows)
+                firsts.push_back(Position(i, 0));
+
+            Split split;
+            addAscendingAlternatives(candidates, firsts, numbers, true, split);
+            splits.push_back(std::move(split));
+            result.symmetry *= factorial(rows.size());
+        }
+    }
+
+    // Shards must split alike whatever their number of threads.
+    const Shard &shard = options.shard;
+    size_t parts = shard.count > 1 ? shard.count * 64 :
+            pool.size() > 1 ? pool.size() * 64 : 1;
+    addPositionSplits(candidates, parts, splits);
+    parts = 1;
+    for (const Split &split : splits)
+        parts *= split.alternatives.size();
+
+    SearchOptions partOptions = options;
+    partOptions.table = nullptr;
+    partOptions.shard = Shard();
+    std::atomic<size_t> nextPart(0);
+    std::atomic<bool> aborted(false);
+    std::mutex mutex;
+    pool.run(pool.size(), [&](size_t) {
+        size_t solutions = 0, nodes = 0, counted = 0;
+        bool overflowed = false;
+        Board<PossibilitySet> partBoard;
+        for (size_t part; !aborted && (part = nextPart++) < parts; ) {
+            if (shard.count > 1 &&
+                    shardOfPart(part, shard.count) != shard.index)
+                continue;
+
+            counted++;
+            partBoard = candidates;
+            if (!applySplits(splits, part, partBoard))
+                continue;
+
+            SearchBudget budget(nodeLimit);
+            size_t count;
+            if (!countSolutions(partBoard, count, budget, partOptions))
+                aborted = true;
+            overflowed = overflowed ||
+                    __builtin_add_overflow(solutions, count, &solutions);
+            nodes += budget.nodes();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        result.overflowed = result.overflowed || overflowed ||
+                __builtin_add_overflow(
+                        result.solutions, solutions, &result.solutions);
+        result.nodes += nodes;
+        result.parts += counted;
+    });
+
+    result.complete = !aborted;
+    result.overflowed = result.overflowed || __builtin_mul_overflow(
+            result.solutions, result.symmetry, &result.solutions);
+    return result;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
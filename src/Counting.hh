@@ -0,0 +1,59 @@
+#ifndef INCLUDED_COUNTING_HH
+#define INCLUDED_COUNTING_HH 1
+
+
+#include <cstddef>
+#include "Board.hh"
+#include "Solver.hh"
+#include "ThreadPool.hh"
+
+
+struct CountResult {
+    /** False if the budget ran out for some part of the count. */
+    bool complete = true;
+    /** True if the number of solutions does not fit in std::size_t. */
+    bool overflowed = false;
+    /** The number of solutions, valid if complete and not overflowed. */
+    std::size_t solutions = 0;
+    /**
+     * The number of solutions each counted solution stands for: the order
+     * of the symmetry group whose orbits were counted once.
+     */
+    std::size_t symmetry = 1;
+    /** The number of independent parts counted. */
+    std::size_t parts = 0;
+    /** The search nodes of all parts. */
+    std::size_t nodes = 0;
+};
+
+/**
+ * Counts the solutions of the problem without building solution boards.
+ *
+ * Numbers that are not given can be relabeled among themselves, and blank
+ * rows of a band (or blank columns of a stack, whichever gives the larger
+ * group) can be reordered, without changing the givens. Both map solutions
+ * to distinct solutions, so only the solutions where the free numbers occur
+ * in ascending order in a row with givens and the blank rows are ordered by
+ * their first number are counted, and the count is multiplied by the order
+ * of the group.
+ *
+ * The remaining count is split into parts by the alternatives of those
+ * orderings and, with more than one thread, of a few more positions, and the
+ * parts are counted in parallel. The node limit applies to each part, and
+ * the transposition table of the options is not used since parts run
+ * concurrently.
+ *
+ * With more than one shard in the options, the number of parts depends only
+ * on the number of shards, and each shard counts the parts whose index hashes
+ * to it, so the counts of all shards add up to the whole count.
+ */
+extern CountResult countProblemSolutions(
+        const Board<Number> &problem,
+        ThreadPool &pool,
+        std::size_t nodeLimit = SearchBudget::unlimited,
+        const SearchOptions &options = SearchOptions());
+
+
+#endif // #ifndef INCLUDED_COUNTING_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
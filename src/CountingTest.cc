@@ -0,0 +1,118 @@
+#include <string>
+#include "Board.hh"
+#include "Counting.hh"
+#include "Format.hh"
+#include "Solver.hh"
+#include "Tester.inl"
+#include "ThreadPool.hh"
+
+
+static Board<Number> lineBoard(const std::string &line) {
+    Board<Number> board;
+    parseLine(line, board);
+    return board;
+}
+
+/**
+ * The README problem without its first two rows and without its 8s and 9s,
+ * which has 2940 solutions.
+ */
+static const char *const sparseLine =
+        "000000000000000000700023006300600000640070012"
+        "000002045230504000060000030007001064";
+
+/** The same problem transposed, so that its first two columns are blank. */
+static const char *const transposedLine =
+        "007360200000040360000000007000600500002070000"
+        "003002401000000000000014036006025004";
+
+/** A 17-clue puzzle with one clue moved, which has 1058 solutions. */
+static const char *const openLine =
+        "000000010400000000020000000000050407008000300"
+        "001090000300400200050100000000800006";
+
+static std::size_t countWithoutSymmetry(const Board<Number> &problem) {
+    Board<PossibilitySet> board;
+    convert(problem, board);
+    SearchBudget budget;
+    std::size_t count;
+    countSolutions(board, count, budget);
+    return count;
+}
+
+static void testCount(std::size_t threads) {
+    ThreadPool pool(threads);
+
+    CountResult result = countProblemSolutions(lineBoard(sparseLine), pool);
+    test_assert(result.complete);
+    test_assert(!result.overflowed);
+    test_assert(result.solutions == 2940);
+    // 8 and 9 can be swapped, and so can the first two rows.
+    test_assert(result.symmetry == 2 * 2);
+    test_assert(result.parts >= threads);
+
+    result = countProblemSolutions(lineBoard(transposedLine), pool);
+    test_assert(result.complete);
+    test_assert(result.solutions == 2940);
+    test_assert(result.symmetry == 2 * 2);
+
+    SearchOptions options;
+    options.backend = Backend::BITBOARD;
+    result = countProblemSolutions(
+            lineBoard(openLine), pool, SearchBudget::unlimited, options);
+    test_assert(result.complete);
+    test_assert(result.solutions == 1058);
+    test_assert(result.solutions == countWithoutSymmetry(lineBoard(openLine)));
+}
+
+static void testShards() {
+    // Shards split alike whatever their number of threads.
+    ThreadPool pool1(1), pool3(3);
+    SearchOptions options;
+    options.shard.count = 4;
+    std::size_t solutions = 0, parts = 0;
+    for (options.shard.index = 0; options.shard.index < 4;
+            options.shard.index++) {
+        CountResult result = countProblemSolutions(lineBoard(sparseLine),
+                options.shard.index % 2 == 0 ? pool1 : pool3,
+                SearchBudget::unlimited, options);
+        test_assert(result.complete);
+        test_assert(result.symmetry == 2 * 2);
+        solutions += result.solutions;
+        parts += result.parts;
+    }
+    test_assert(solutions == 2940);
+    test_assert(parts >= 4 * 64);
+}
+
+static void testNoSolution() {
+    ThreadPool pool(2);
+    Board<Number> problem = lineBoard(sparseLine);
+    problem[Position(0, 0)] = 6;
+    CountResult result = countProblemSolutions(problem, pool);
+    test_assert(result.complete);
+    test_assert(result.solutions == 0);
+}
+
+static void testBudget() {
+    ThreadPool pool(1);
+    CountResult result =
+            countProblemSolutions(lineBoard(sparseLine), pool, 3);
+    test_assert(!result.complete);
+}
+
+static void testAll() {
+    testCount(1);
+    testCount(3);
+    testShards();
+    testNoSolution();
+    testBudget();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
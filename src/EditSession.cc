@@ -0,0 +1,219 @@
+#include "EditSession.hh"
+
+using std::array;
+
+
+namespace {
+
+/** Returns the row, column and block of a position as unit indices. */
+array<Number, 3> unitsOf(Number index) noexcept {
+    Position pos = CellSet::position(index);
+    return {{
+        pos.i(),
+        static_cast<Number>(N + pos.j()),
+        static_cast<Number>(2 * N + UnitMasks::blockIndex(pos)),
+    }};
+}
+
+Hint unitHint(Hint::Kind kind, Number unit, Number n) noexcept {
+    Hint hint;
+    hint.kind = kind;
+    hint.number = n;
+    hint.unitKind = static_cast<UnitKind>(unit / N);
+    hint.unit = unit % N;
+    return hint;
+}
+
+} // namespace
+
+EditSession::EditSession() noexcept :
+        mBlanks(CellSet::all()), mNakedSingles(), mDeadCells() {
+    for (Number i = 0; i < N; i++) {
+        for (Number j = 0; j < N; j++) {
+            mNumbers[Position(i, j)] = N;
+            mBoard[Position(i, j)] = PossibilitySet::full();
+        }
+    }
+    for (auto &counts : mCounts)
+        counts.fill(0);
+    for (auto &places : mPlaces)
+        places.fill(N);
+}
+
+EditSession::EditSession(const Board<Number> &board) noexcept :
+        EditSession() {
+    for (Number i = 0; i < N; i++)
+        for (Number j = 0; j < N; j++)
+            if (board[Position(i, j)] < N)
+                place(Position(i, j), board[Position(i, j)]);
+}
+
+void EditSession::count(Number unit, Number n, int delta) noexcept {
+    unsigned char &count = mCounts[unit][n];
+    count = static_cast<unsigned char>(count + delta);
+    if (count == 0)
+        mUsed[unit].remove(n);
+    else
+        mUsed[unit].add(n);
+    if (count > 1)
+        mConflicts[unit].add(n);
+    else
+        mConflicts[unit].remove(n);
+    updateFlags(unit, n);
+}
+
+void EditSession::countPlaces(
+        Number index, PossibilitySet numbers, int delta) noexcept {
+    for (Number unit : unitsOf(index)) {
+        for (PossibilitySet rest = numbers; !rest.isEmpty(); ) {
+            Number n = rest.first();
+            rest.remove(n);
+            unsigned char &places = mPlaces[unit][n];
+            places = static_cast<unsigned char>(places + delta);
+            updateFlags(unit, n);
+        }
+    }
+}
+
+void EditSession::updateFlags(Number unit, Number n) noexcept {
+    bool open = !mUsed[unit].contains(n);
+    if (open && mPlaces[unit][n] == 1)
+        mHiddenSingles[unit].add(n);
+    else
+        mHiddenSingles[unit].remove(n);
+    if (open && mPlaces[unit][n] == 0)
+        mMissing[unit].add(n);
+    else
+        mMissing[unit].remove(n);
+}
+
+/** Recomputes the candidates of a blank after its units have changed. */
+void EditSession::refresh(Number index) noexcept {
+    if (!mBlanks.contains(index))
+        return;
+
+    array<Number, 3> units = unitsOf(index);
+    PossibilitySet next = PossibilitySet::full() -
+            (mUsed[units[0]] | mUsed[units[1]] | mUsed[units[2]]);
+    PossibilitySet &candidates = mBoard[CellSet::position(index)];
+    if (next == candidates)
+        return;
+
+    countPlaces(index, candidates - next, -1);
+    countPlaces(index, next - candidates, 1);
+    candidates = next;
+
+    mNakedSingles.remove(index);
+    mDeadCells.remove(index);
+    if (next.isUnique())
+        mNakedSingles.add(index);
+    else if (next.isEmpty())
+        mDeadCells.add(index);
+}
+
+void EditSession::place(const Position &pos, Number n) noexcept {
+    Number old = mNumbers[pos];
+    if (n == old || (n >= N && old >= N))
+        return;
+
+    Number index = CellSet::index(pos);
+    if (old < N) {
+        for (Number unit : unitsOf(index))
+            count(unit, old, -1);
+    } else {
+        countPlaces(index, mBoard[pos], -1);
+        mBlanks.remove(index);
+        mNakedSingles.remove(index);
+        mDeadCells.remove(index);
+    }
+
+    if (n < N) {
+        mNumbers[pos] = n;
+        mBoard[pos] = PossibilitySet(n);
+        for (Number unit : unitsOf(index))
+            count(unit, n, 1);
+    } else {
+        // Refreshing the new blank counts all of its candidates as new.
+        mNumbers[pos] = N;
+        mBoard[pos] = PossibilitySet();
+        mBlanks.add(index);
+        mDeadCells.add(index);
+        refresh(index);
+    }
+
+    for (CellSet peers = peerCells(index); !peers.isEmpty(); ) {
+        Number peer = peers.first();
+        peers.remove(peer);
+        refresh(peer);
+    }
+}
+
+bool EditSession::hasConflict() const noexcept {
+    for (const PossibilitySet &conflicts : mConflicts)
+        if (!conflicts.isEmpty())
+            return true;
+    return false;
+}
+
+bool EditSession::isConflicting(const Position &pos) const noexcept {
+    Number n = mNumbers[pos];
+    if (n >= N)
+        return false;
+    for (Number unit : unitsOf(CellSet::index(pos)))
+        if (mConflicts[unit].contains(n))
+            return true;
+    return false;
+}
+
+Hint EditSession::hint() const noexcept {
+    for (Number unit = 0; unit < 3 * N; unit++) {
+        if (mConflicts[unit].isEmpty())
+            continue;
+        Hint hint = unitHint(
+                Hint::Kind::CONFLICT, unit, mConflicts[unit].first());
+        for (CellSet cells = unitCells()[unit]; ; ) {
+            Number index = cells.first();
+            cells.remove(index);
+            hint.position = CellSet::position(index);
+            if (mNumbers[hint.position] == hint.number)
+                return hint;
+        }
+    }
+
+    if (!mDeadCells.isEmpty()) {
+        Hint hint;
+        hint.kind = Hint::Kind::DEAD_END;
+        hint.position = CellSet::position(mDeadCells.first());
+        return hint;
+    }
+    for (Number unit = 0; unit < 3 * N; unit++)
+        if (!mMissing[unit].isEmpty())
+            return unitHint(
+                    Hint::Kind::DEAD_END, unit, mMissing[unit].first());
+
+    if (!mNakedSingles.isEmpty()) {
+        Hint hint;
+        hint.kind = Hint::Kind::NAKED_SINGLE;
+        hint.position = CellSet::position(mNakedSingles.first());
+        hint.number = mBoard[hint.position].first();
+        return hint;
+    }
+    for (Number unit = 0; unit < 3 * N; unit++) {
+        if (mHiddenSingles[unit].isEmpty())
+            continue;
+        Hint hint = unitHint(
+                Hint::Kind::HIDDEN_SINGLE, unit, mHiddenSingles[unit].first());
+        for (CellSet cells = unitCells()[unit] & mBlanks; ; ) {
+            Number index = cells.first();
+            cells.remove(index);
+            hint.position = CellSet::position(index);
+            if (mBoard[hint.position].contains(hint.number))
+                return hint;
+        }
+    }
+
+    return Hint();
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
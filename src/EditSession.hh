@@ -0,0 +1,158 @@
+#ifndef INCLUDED_EDITSESSION_HH
+#define INCLUDED_EDITSESSION_HH 1
+
+
+#include <array>
+#include <cstddef>
+#include "BitBoard.hh"
+#include "Board.hh"
+#include "Solver.hh"
+#include "Validation.hh"
+
+
+/** The next logical step of an edited board, as told by EditSession::hint. */
+struct Hint {
+
+    enum class Kind {
+        /** No single is left: the board is complete or needs a guess. */
+        NONE,
+        /** A number occurs twice in the unit. */
+        CONFLICT,
+        /**
+         * The position has no candidate left or, if the position is not
+         * valid, the number has no place left in the unit.
+         */
+        DEAD_END,
+        /** The number is the only candidate of the position. */
+        NAKED_SINGLE,
+        /** The position is the only place of the number in the unit. */
+        HIDDEN_SINGLE,
+    };
+
+    Kind kind = Kind::NONE;
+    /**
+     * The position to place the number at, the first position of a conflict
+     * or the position without candidates.
+     */
+    Position position = Position(N, N);
+    Number number = N;
+    /** The unit of a conflict, a hidden single or a missing number. */
+    UnitKind unitKind = UnitKind::ROW;
+    Number unit = 0;
+
+};
+
+/**
+ * A board being edited one placement at a time, such as in an interactive
+ * editor. The candidates of every position, the conflicts and the next step
+ * of the propagation in Solver.cc are kept up to date as numbers are placed
+ * and retracted, and each placement only revisits the peers of the position
+ * instead of converting the whole board again.
+ *
+ * Unlike Board<Number>, the edited board may place a number twice in a unit.
+ * The candidates of a blank position are the numbers placed in none of its
+ * units, as convertToCandidates computes them.
+ */
+class EditSession {
+
+private:
+
+    Board<Number> mNumbers;
+    /** The numbers, as singletons, and the candidates of the blanks. */
+    Board<PossibilitySet> mBoard;
+    /** How many times each number is placed in each unit. */
+    std::array<std::array<unsigned char, N>, 3 * N> mCounts;
+    /** How many blanks of each unit have each number as a candidate. */
+    std::array<std::array<unsigned char, N>, 3 * N> mPlaces;
+    /** The numbers placed in each unit. */
+    std::array<PossibilitySet, 3 * N> mUsed;
+    /** The numbers placed more than once in each unit. */
+    std::array<PossibilitySet, 3 * N> mConflicts;
+    /** The numbers not placed in each unit that have a single place left. */
+    std::array<PossibilitySet, 3 * N> mHiddenSingles;
+    /** The numbers not placed in each unit that have no place left. */
+    std::array<PossibilitySet, 3 * N> mMissing;
+    CellSet mBlanks;
+    /** The blanks with a single candidate. */
+    CellSet mNakedSingles;
+    /** The blanks without a candidate. */
+    CellSet mDeadCells;
+
+    void count(Number unit, Number n, int delta) noexcept;
+    void countPlaces(Number index, PossibilitySet numbers, int delta)
+            noexcept;
+    void updateFlags(Number unit, Number n) noexcept;
+    void refresh(Number index) noexcept;
+
+public:
+
+    /** Starts with a blank board. */
+    EditSession() noexcept;
+
+    /** Starts with the numbers of the board, ignoring blanks. */
+    explicit EditSession(const Board<Number> &board) noexcept;
+
+    /** The placed numbers. Blanks are N. */
+    const Board<Number> &numbers() const noexcept {
+        return mNumbers;
+    }
+
+    /**
+     * The board to search: the placed numbers as singletons and the
+     * candidates of the blanks.
+     */
+    const Board<PossibilitySet> &board() const noexcept {
+        return mBoard;
+    }
+
+    /** Returns the candidates of a blank, or the placed number. */
+    const PossibilitySet &candidates(const Position &pos) const noexcept {
+        return mBoard[pos];
+    }
+
+    bool isComplete() const noexcept {
+        return mBlanks.isEmpty();
+    }
+
+    /**
+     * Places the number at the position, replacing the number placed there
+     * if any. A number N retracts the placement instead.
+     */
+    void place(const Position &pos, Number n) noexcept;
+
+    /** Makes the position blank. */
+    void retract(const Position &pos) noexcept {
+        place(pos, N);
+    }
+
+    /** Returns true if some number is placed twice in a unit. */
+    bool hasConflict() const noexcept;
+
+    /**
+     * Returns true if the number placed at the position is placed again in
+     * one of its units.
+     */
+    bool isConflicting(const Position &pos) const noexcept;
+
+    /**
+     * Returns the first applicable of: a conflict, a dead end, a naked single
+     * and a hidden single. Positions and units are tried in row-major order,
+     * rows before columns before blocks.
+     */
+    Hint hint() const noexcept;
+
+    /** Solves the edited board as it is, without converting it again. */
+    SolveResult solve(
+            Board<Number> &solution,
+            SearchBudget &budget,
+            const SearchOptions &options = SearchOptions())
+            const noexcept {
+        return ::solve(mBoard, solution, budget, options);
+    }
+
+};
+
+
+#endif // #ifndef INCLUDED_EDITSESSION_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,162 @@
+#include <cstdint>
+#include "BitBoard.hh"
+#include "Board.hh"
+#include "EditSession.hh"
+#include "Format.hh"
+#include "Solver.hh"
+#include "Validation.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+/** Returns the blanks of the unit where the number is a candidate. */
+static std::size_t countPlaces(
+        const EditSession &session, const Hint &hint) {
+    Number unit = static_cast<Number>(hint.unitKind) * N + hint.unit;
+    std::size_t places = 0;
+    for (CellSet cells = unitCells()[unit]; !cells.isEmpty(); ) {
+        Position pos = CellSet::position(cells.first());
+        cells.remove(cells.first());
+        if (session.numbers()[pos] >= N &&
+                session.candidates(pos).contains(hint.number))
+            places++;
+    }
+    return places;
+}
+
+/** Checks the session against the numbers converted from scratch. */
+static void check(const EditSession &session) {
+    Board<PossibilitySet> expected;
+    convertToCandidates(session.numbers(), expected);
+    test_assert(session.board() == expected);
+
+    Validation validation = validatePuzzle(session.numbers());
+    test_assert(session.hasConflict() == !validation.isValid());
+
+    Hint hint = session.hint();
+    switch (hint.kind) {
+    case Hint::Kind::CONFLICT:
+        test_assert(hint.unitKind == validation.unitKind);
+        test_assert(hint.unit == validation.unit);
+        test_assert(hint.number == validation.number);
+        test_assert(session.isConflicting(hint.position));
+        break;
+    case Hint::Kind::DEAD_END:
+        test_assert(!session.hasConflict());
+        if (hint.position.isValid())
+            test_assert(session.candidates(hint.position).isEmpty());
+        else
+            test_assert(countPlaces(session, hint) == 0);
+        break;
+    case Hint::Kind::NAKED_SINGLE:
+        test_assert(session.numbers()[hint.position] >= N);
+        test_assert(session.candidates(hint.position) ==
+                PossibilitySet(hint.number));
+        break;
+    case Hint::Kind::HIDDEN_SINGLE:
+        test_assert(session.numbers()[hint.position] >= N);
+        test_assert(session.candidates(hint.position).contains(hint.number));
+        test_assert(countPlaces(session, hint) == 1);
+        break;
+    case Hint::Kind::NONE:
+        test_assert(!session.hasConflict());
+        for (Number i = 0; i < N; i++)
+            for (Number j = 0; j < N; j++)
+                test_assert(session.numbers()[Position(i, j)] < N ||
+                        session.candidates(Position(i, j)).count() > 1);
+        break;
+    }
+}
+
+static void testFollowHints() {
+    Board<Number> problem, expected;
+    parseLine(problemLine, problem);
+    parseLine(solutionLine, expected);
+
+    // The README problem is solved by singles alone.
+    EditSession session(problem);
+    check(session);
+    while (!session.isComplete()) {
+        Hint hint = session.hint();
+        test_assert(hint.kind == Hint::Kind::NAKED_SINGLE ||
+                hint.kind == Hint::Kind::HIDDEN_SINGLE);
+        if (hint.kind == Hint::Kind::NONE)
+            return;
+        test_assert(expected[hint.position] == hint.number);
+        session.place(hint.position, hint.number);
+    }
+    test_assert(session.numbers() == expected);
+    test_assert(session.hint().kind == Hint::Kind::NONE);
+}
+
+static void testConflict() {
+    Board<Number> problem;
+    parseLine(problemLine, problem);
+    EditSession session(problem);
+
+    // A second 1 in the first row and the first block.
+    session.place(Position(0, 1), 0);
+    check(session);
+    test_assert(session.isConflicting(Position(0, 0)));
+    test_assert(session.isConflicting(Position(0, 1)));
+    test_assert(!session.isConflicting(Position(0, 3)));
+    Hint hint = session.hint();
+    test_assert(hint.kind == Hint::Kind::CONFLICT);
+    test_assert(hint.position == Position(0, 0));
+
+    session.retract(Position(0, 0));
+    check(session);
+    test_assert(!session.hasConflict());
+    session.place(Position(0, 0), 0);
+    session.retract(Position(0, 1));
+    check(session);
+    test_assert(session.board() == EditSession(problem).board());
+}
+
+static void testRandomEdits() {
+    EditSession session;
+    check(session);
+    std::uint64_t state = 1;
+    for (int k = 0; k < 3000; k++) {
+        state = state * UINT64_C(6364136223846793005) +
+                UINT64_C(1442695040888963407);
+        Number i = static_cast<Number>((state >> 33) % N);
+        Number j = static_cast<Number>((state >> 41) % N);
+        // Retract about a third of the time.
+        Number n = static_cast<Number>((state >> 49) % (N + N / 2));
+        session.place(Position(i, j), n < N ? n : N);
+        check(session);
+    }
+}
+
+static void testSolve() {
+    Board<Number> problem, expected, solution;
+    parseLine(problemLine, problem);
+    parseLine(solutionLine, expected);
+    EditSession session(problem);
+
+    SearchBudget budget;
+    test_assert(session.solve(solution, budget) == SolveResult::UNIQUE);
+    test_assert(solution == expected);
+
+    session.retract(Position(0, 0));
+    session.retract(Position(0, 3));
+    session.retract(Position(0, 6));
+    session.place(Position(8, 8), 0);
+    test_assert(session.solve(solution, budget) == SolveResult::INSOLVABLE);
+}
+
+static void testAll() {
+    testFollowHints();
+    testConflict();
+    testRandomEdits();
+    testSolve();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
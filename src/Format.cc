@@ -0,0 +1,172 @@
+#include <ios>
+#include <istream>
+#include <limits>
+#include <string>
+#include "Format.hh"
+
+using std::string;
+
+
+bool parseBoardFormat(const string &name, BoardFormat &format) noexcept {
+    if (name == "grid")
+        format = BoardFormat::GRID;
+    else if (name == "line")
+        format = BoardFormat::LINE;
+    else
+        return false;
+    return true;
+}
+
+bool parseLine(const string &line, Board<Number> &board) noexcept {
+    if (line.size() != N * N)
+        return false;
+
+    // Validating large files is bound by parsing, so this loops over the
+    // cells directly rather than through Area::forAllPositions.
+    Number *numbers = board.data();
+    for (Number index = 0; index < N * N; index++) {
+        char c = line[index];
+        if (c == '0' || c == '.')
+            numbers[index] = N;
+        else if ('1' <= c && c <= '0' + static_cast<char>(N))
+            numbers[index] = static_cast<Number>(c - '1');
+        else
+            return false;
+    }
+    return true;
+}
+
+string formatLine(const Board<Number> &board) {
+    string line;
+    line.reserve(N * N);
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        Number n = board[pos];
+        line += n < N ? static_cast<char>('1' + n) : '0';
+        return true;
+    });
+    return line;
+}
+
+/**
+ * Parses the candidates of the cell that starts at i in the line, up to the
+ * next space or the end, and moves i past them.
+ */
+static bool parseCell(
+        const string &line, string::size_type &i, PossibilitySet &pset)
+        noexcept {
+    pset = PossibilitySet();
+    if (i < line.size() && line[i] == '-') {
+        i++;
+        return true;
+    }
+    string::size_type begin = i;
+    for (; i < line.size() && line[i] != ' '; i++) {
+        char c = line[i];
+        if (c < '1' || c > '0' + static_cast<char>(N))
+            return false;
+        Number n = static_cast<Number>(c - '1');
+        // Digits must ascend, so each appears once.
+        if (pset.bits() >> n != 0)
+            return false;
+        pset.add(n);
+    }
+    return i != begin;
+}
+
+static void appendCell(string &line, const PossibilitySet &pset) {
+    if (pset.isEmpty())
+        line += '-';
+    for (Number n = 0; n < N; n++)
+        if (pset.contains(n))
+            line += static_cast<char>('1' + n);
+}
+
+bool parseCandidates(const string &line, Board<PossibilitySet> &board)
+        noexcept {
+    PossibilitySet *psets = board.data();
+    string::size_type i = 0;
+    for (Number index = 0; index < N * N; index++) {
+        if (index > 0) {
+            if (i >= line.size() || line[i] != ' ')
+                return false;
+            i++;
+        }
+        if (!parseCell(line, i, psets[index]))
+            return false;
+    }
+    return i == line.size();
+}
+
+string formatCandidates(const Board<PossibilitySet> &board) {
+    string line;
+    const PossibilitySet *psets = board.data();
+    for (Number index = 0; index < N * N; index++) {
+        if (index > 0)
+            line += ' ';
+        appendCell(line, psets[index]);
+    }
+    return line;
+}
+
+bool parseCellCandidates(const string &text, PossibilitySet &pset) noexcept {
+    string::size_type i = 0;
+    return parseCell(text, i, pset) && i == text.size();
+}
+
+string formatCellCandidates(const PossibilitySet &pset) {
+    string text;
+    appendCell(text, pset);
+    return text;
+}
+
+ReadResult readNextBoard(
+        std::istream &is,
+        Board<Number> &board,
+        BoardFormat format) {
+    switch (format) {
+    case BoardFormat::GRID:
+        if (!(is >> std::ws) || is.eof())
+            return ReadResult::END;
+        if (!(is >> board)) {
+            if (is.eof())
+                return ReadResult::MALFORMED;
+            is.clear();
+            is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            return ReadResult::MALFORMED;
+        }
+        return ReadResult::BOARD;
+    case BoardFormat::LINE:
+        string line;
+        if (!(is >> line))
+            return ReadResult::END;
+        return parseLine(line, board) ?
+                ReadResult::BOARD : ReadResult::MALFORMED;
+    }
+    return ReadResult::END;
+}
+
+std::istream &readBoard(
+        std::istream &is,
+        Board<Number> &board,
+        BoardFormat format) {
+    ReadResult result = readNextBoard(is, board, format);
+    if (result != ReadResult::BOARD)
+        is.setstate(std::ios::failbit);
+    return is;
+}
+
+std::ostream &writeBoard(
+        std::ostream &os,
+        const Board<Number> &board,
+        BoardFormat format) {
+    switch (format) {
+    case BoardFormat::GRID:
+        return os << board;
+    case BoardFormat::LINE:
+        return os << formatLine(board) << '\n';
+    }
+    return os;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
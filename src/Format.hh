@@ -0,0 +1,78 @@
+#ifndef INCLUDED_FORMAT_HH
+#define INCLUDED_FORMAT_HH 1
+
+
+#include <iostream>
+#include <string>
+#include "Board.hh"
+
+
+/**
+ * Textual representations of number boards. GRID is the format used by the
+ * stream operators in Board.hh: nine lines of nine space-separated numbers.
+ * LINE packs a board into a single line of 81 characters, where a blank is
+ * written as '0' (and may also be read as '.').
+ */
+enum class BoardFormat {
+    GRID, LINE,
+};
+
+extern bool parseBoardFormat(const std::string &name, BoardFormat &format)
+        noexcept;
+
+extern bool parseLine(const std::string &line, Board<Number> &board)
+        noexcept;
+
+extern std::string formatLine(const Board<Number> &board);
+
+/**
+ * Pencil marks: a candidate board on one line of 81 space-separated cells,
+ * each the digits of its numbers in ascending order, or '-' for a cell
+ * without numbers. Unlike the stream operators, this keeps every candidate.
+ */
+extern bool parseCandidates(
+        const std::string &line,
+        Board<PossibilitySet> &board)
+        noexcept;
+
+extern std::string formatCandidates(const Board<PossibilitySet> &board);
+
+/** The pencil marks of one cell, as in a line of formatCandidates. */
+extern bool parseCellCandidates(
+        const std::string &text,
+        PossibilitySet &pset)
+        noexcept;
+
+extern std::string formatCellCandidates(const PossibilitySet &pset);
+
+/** The outcome of readNextBoard. */
+enum class ReadResult {
+    BOARD, MALFORMED, END,
+};
+
+/**
+ * Reads a board, telling a malformed board from the end of the input. After
+ * a malformed board, the stream is left at the next one (the next line of
+ * the GRID format), so that reading can go on. A board cut off by the end
+ * of the input is malformed, and the next read returns END.
+ */
+extern ReadResult readNextBoard(
+        std::istream &is,
+        Board<Number> &board,
+        BoardFormat format);
+
+/** Reads a board like readNextBoard, failing the stream unless a BOARD. */
+extern std::istream &readBoard(
+        std::istream &is,
+        Board<Number> &board,
+        BoardFormat format);
+
+extern std::ostream &writeBoard(
+        std::ostream &os,
+        const Board<Number> &board,
+        BoardFormat format);
+
+
+#endif // #ifndef INCLUDED_FORMAT_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,143 @@
+#include <sstream>
+#include <string>
+#include "Format.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+using std::istringstream;
+using std::ostringstream;
+using std::string;
+
+
+static const string problemGrid =
+        "1 0 0 4 0 0 7 0 9\n"
+        "0 5 0 7 8 0 0 2 0\n"
+        "7 0 9 0 2 3 0 0 6\n"
+        "3 0 0 6 0 0 0 0 0\n"
+        "6 4 0 0 7 0 0 1 2\n"
+        "9 0 8 0 0 2 0 4 5\n"
+        "2 3 0 5 0 4 8 0 0\n"
+        "0 6 0 0 9 0 0 3 0\n"
+        "8 0 7 0 0 1 0 6 4\n";
+
+static void testParseBoardFormat() {
+    BoardFormat format = BoardFormat::LINE;
+    test_assert(parseBoardFormat("grid", format));
+    test_assert(format == BoardFormat::GRID);
+    test_assert(parseBoardFormat("line", format));
+    test_assert(format == BoardFormat::LINE);
+    test_assert(!parseBoardFormat("xml", format));
+    test_assert(format == BoardFormat::LINE);
+}
+
+static void testParseLine() {
+    Board<Number> board;
+    test_assert(parseLine(problemLine, board));
+    test_assert(board[Position(0, 0)] == 0);
+    test_assert(board[Position(0, 1)] == N);
+    test_assert(board[Position(8, 8)] == 3);
+    test_assert(formatLine(board) == problemLine);
+
+    string dotted = problemLine;
+    dotted[1] = '.';
+    test_assert(parseLine(dotted, board));
+    test_assert(formatLine(board) == problemLine);
+
+    test_assert(!parseLine(string(problemLine).substr(1), board));
+    test_assert(!parseLine(string(problemLine) + "0", board));
+    dotted[1] = 'x';
+    test_assert(!parseLine(dotted, board));
+}
+
+static void testReadAndWrite() {
+    istringstream is(string(problemLine) + "\n" + problemLine + "\n");
+    Board<Number> board1, board2;
+    test_assert(readBoard(is, board1, BoardFormat::LINE));
+    test_assert(readBoard(is, board2, BoardFormat::LINE));
+    test_assert(board1 == board2);
+    test_assert(!readBoard(is, board2, BoardFormat::LINE));
+
+    ostringstream os1;
+    writeBoard(os1, board1, BoardFormat::GRID);
+    test_assert(os1.str() == problemGrid);
+
+    istringstream is2(problemGrid);
+    test_assert(readBoard(is2, board2, BoardFormat::GRID));
+    test_assert(formatLine(board2) == problemLine);
+
+    ostringstream os2;
+    writeBoard(os2, board2, BoardFormat::LINE);
+    test_assert(os2.str() == string(problemLine) + "\n");
+}
+
+static void testReadNextBoard() {
+    // A malformed line in the middle does not end the input.
+    istringstream is(string(problemLine) + "\nxyz\n" +
+            string(problemLine).substr(1) + "\n" + problemLine + "\n");
+    Board<Number> board;
+    test_assert(readNextBoard(is, board, BoardFormat::LINE) ==
+            ReadResult::BOARD);
+    test_assert(readNextBoard(is, board, BoardFormat::LINE) ==
+            ReadResult::MALFORMED);
+    test_assert(readNextBoard(is, board, BoardFormat::LINE) ==
+            ReadResult::MALFORMED);
+    test_assert(readNextBoard(is, board, BoardFormat::LINE) ==
+            ReadResult::BOARD);
+    test_assert(formatLine(board) == problemLine);
+    test_assert(readNextBoard(is, board, BoardFormat::LINE) ==
+            ReadResult::END);
+
+    istringstream grids(problemGrid + "x\n" + problemGrid + "1 2\n");
+    test_assert(readNextBoard(grids, board, BoardFormat::GRID) ==
+            ReadResult::BOARD);
+    test_assert(readNextBoard(grids, board, BoardFormat::GRID) ==
+            ReadResult::MALFORMED);
+    test_assert(readNextBoard(grids, board, BoardFormat::GRID) ==
+            ReadResult::BOARD);
+    test_assert(formatLine(board) == problemLine);
+    // Cut off by the end of the input.
+    test_assert(readNextBoard(grids, board, BoardFormat::GRID) ==
+            ReadResult::MALFORMED);
+    test_assert(readNextBoard(grids, board, BoardFormat::GRID) ==
+            ReadResult::END);
+
+    istringstream bad("xyz\n");
+    test_assert(!readBoard(bad, board, BoardFormat::LINE));
+}
+
+static void testCandidates() {
+    Board<Number> problem;
+    test_assert(parseLine(problemLine, problem));
+    Board<PossibilitySet> board, parsed;
+    convertToCandidates(problem, board);
+    board[Position(8, 8)] = PossibilitySet();
+
+    board[Position(0, 1)] = PossibilitySet(1).add(2).add(7);
+    string line = formatCandidates(board);
+    test_assert(line.compare(0, 6, "1 238 ") == 0);
+    test_assert(line.compare(line.size() - 2, 2, " -") == 0);
+    test_assert(parseCandidates(line, parsed));
+    test_assert(parsed == board);
+
+    test_assert(!parseCandidates(line + " ", parsed));
+    test_assert(!parseCandidates(line.substr(2), parsed));
+    test_assert(!parseCandidates("21" + line.substr(1), parsed));
+    test_assert(!parseCandidates("11" + line.substr(1), parsed));
+    test_assert(!parseCandidates(" " + line.substr(1), parsed));
+}
+
+static void testAll() {
+    testParseBoardFormat();
+    testParseLine();
+    testReadAndWrite();
+    testReadNextBoard();
+    testCandidates();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
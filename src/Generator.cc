@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <vector>
+#include "Generator.hh"
+#include "Solver.hh"
+
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+
+
+/**
+ * Fills the board by a depth-first search that tries the possible numbers in
+ * random order. Returns false if the board has no solution.
+ */
+static bool fillRandomly(Board<PossibilitySet> &board, Random &random) {
+    repeatNonAssumptionProcess(board);
+
+    switch (classify(board)) {
+    case BoardState::SOLVED:
+        return true;
+    case BoardState::INSOLVABLE:
+        return false;
+    case BoardState::UNSOLVED:
+        break;
+    }
+
+    Position pos = findPositionWithLeastPossibilities(board);
+    vector<Number> numbers;
+    board[pos].forAllPossibleNumbers([&](Number n) -> bool {
+        numbers.push_back(n);
+        return true;
+    });
+    std::shuffle(numbers.begin(), numbers.end(), random);
+
+    for (Number n : numbers) {
+        Board<PossibilitySet> nextBoard = board;
+        nextBoard[pos] = PossibilitySet(n);
+        if (fillRandomly(nextBoard, random)) {
+            board = nextBoard;
+            return true;
+        }
+    }
+    return false;
+}
+
+void generateSolution(Random &random, Board<Number> &solution) {
+    Board<PossibilitySet> board;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board[pos] = PossibilitySet::full();
+        return true;
+    });
+    fillRandomly(board, random);
+    convert(board, solution);
+}
+
+/** Searches for any solution, stopping at the first one. */
+static bool hasSolution(const Board<PossibilitySet> &board) {
+    bool found = false;
+    SearchBudget budget;
+    searchSolutions(board, [&](const Board<PossibilitySet> &) -> bool {
+        found = true;
+        return false;
+    }, budget);
+    return found;
+}
+
+static Position mirror(const Position &pos) {
+    return Position(N - 1 - pos.i(), N - 1 - pos.j());
+}
+
+static Number cellIndex(const Position &pos) {
+    return pos.i() * N + pos.j();
+}
+
+/**
+ * Removes clues from a complete board as long as the solution stays unique.
+ * Returns the number of remaining clues.
+ *
+ * The problem is unique before a removal, so any other solution after
+ * removing the clues at pos1 and pos2 must differ from the known solution at
+ * pos1 or pos2. It is therefore enough to look for a solution that excludes
+ * the removed numbers, and that search stops at the first solution found.
+ */
+static size_t removeClues(
+        Random &random,
+        const GeneratorOptions &options,
+        Board<Number> &problem) {
+    Board<PossibilitySet> givens;
+    convert(problem, givens);
+
+    vector<Position> positions;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        if (options.symmetry == Symmetry::NONE ||
+                cellIndex(pos) <= cellIndex(mirror(pos)))
+            positions.push_back(pos);
+        return true;
+    });
+    std::shuffle(positions.begin(), positions.end(), random);
+
+    size_t clues = N * N;
+    for (const Position &pos1 : positions) {
+        if (clues <= options.clues)
+            break;
+
+        Position pos2 =
+                options.symmetry == Symmetry::NONE ? pos1 : mirror(pos1);
+        Number n1 = problem[pos1], n2 = problem[pos2];
+
+        Board<PossibilitySet> board = givens;
+        board[pos2] = PossibilitySet::full();
+        board[pos1] = PossibilitySet::full().remove(n1);
+        if (hasSolution(board))
+            continue;
+        if (pos1 != pos2) {
+            board[pos1] = PossibilitySet(n1);
+            board[pos2].remove(n2);
+            if (hasSolution(board))
+                continue;
+        }
+
+        givens[pos1] = givens[pos2] = PossibilitySet::full();
+        problem[pos1] = problem[pos2] = N;
+        clues -= pos1 == pos2 ? 1 : 2;
+    }
+    return clues;
+}
+
+/** How far the problem misses the targets: difficulty first, then clues. */
+static size_t distance(
+        const GeneratorOptions &options,
+        const Board<Number> &problem,
+        size_t clues) {
+    size_t clueDistance = clues > options.clues ? clues - options.clues : 0;
+    if (!options.rated)
+        return clueDistance;
+
+    int levels = static_cast<int>(rate(problem).difficulty) -
+            static_cast<int>(options.difficulty);
+    return static_cast<size_t>(levels < 0 ? -levels : levels) * (N * N + 1) +
+            clueDistance;
+}
+
+size_t generateProblem(
+        Random &random,
+        const GeneratorOptions &options,
+        Board<Number> &problem,
+        bool *missed) {
+    size_t bestClues = N * N + 1, bestDistance = 0;
+    for (size_t attempt = 0; attempt < std::max<size_t>(options.attempts, 1);
+            attempt++) {
+        Board<Number> candidate;
+        generateSolution(random, candidate);
+        size_t clues = removeClues(random, options, candidate);
+        size_t candidateDistance = distance(options, candidate, clues);
+        if (attempt == 0 || candidateDistance < bestDistance) {
+            bestClues = clues;
+            bestDistance = candidateDistance;
+            problem = candidate;
+        }
+        if (bestDistance == 0 || (options.clues == 0 && !options.rated))
+            break;
+    }
+    // The clues alone never put a problem N * N + 1 away from the target.
+    if (missed != nullptr)
+        *missed = bestDistance > N * N;
+    return bestClues;
+}
+
+size_t generateProblems(
+        uint64_t seed,
+        size_t count,
+        const GeneratorOptions &options,
+        ThreadPool &pool,
+        std::function<void(const Board<Number> &problem)> callback) {
+    const size_t chunkSize = pool.size() * 16;
+    vector<Board<Number>> problems;
+    vector<char> missed;
+    size_t misses = 0;
+
+    for (size_t first = 0; first < count; first += chunkSize) {
+        problems.resize(std::min(chunkSize, count - first));
+        missed.assign(problems.size(), false);
+        pool.run(problems.size(), [&](size_t k) {
+            uint64_t index = first + k;
+            std::seed_seq sequence{
+                static_cast<std::uint32_t>(seed),
+                static_cast<std::uint32_t>(seed >> 32),
+                static_cast<std::uint32_t>(index),
+                static_cast<std::uint32_t>(index >> 32),
+            };
+            Random random(sequence);
+            bool miss;
+            generateProblem(random, options, problems[k], &miss);
+            missed[k] = miss;
+        });
+
+        for (size_t k = 0; k < problems.size(); k++) {
+            callback(problems[k]);
+            misses += missed[k] ? 1 : 0;
+        }
+    }
+    return misses;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,72 @@
+#ifndef INCLUDED_GENERATOR_HH
+#define INCLUDED_GENERATOR_HH 1
+
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include "Board.hh"
+#include "Rating.hh"
+#include "ThreadPool.hh"
+
+
+using Random = std::mt19937_64;
+
+enum class Symmetry {
+    NONE, ROTATIONAL,
+};
+
+struct GeneratorOptions {
+    /**
+     * The generator stops removing clues once the problem has this many
+     * clues. Zero means removing as many clues as possible.
+     */
+    std::size_t clues = 0;
+    /**
+     * Number of complete grids to try before settling for a problem that
+     * misses the clue or difficulty target.
+     */
+    std::size_t attempts = 100;
+    /**
+     * If true, problems rated at "difficulty" are preferred; when no attempt
+     * is rated there, the one closest to it is kept and reported as a miss.
+     */
+    bool rated = false;
+    Difficulty difficulty = Difficulty::EASY;
+    /** ROTATIONAL keeps the clues symmetric under a half turn. */
+    Symmetry symmetry = Symmetry::NONE;
+};
+
+/** Fills a random complete solution board. */
+extern void generateSolution(Random &random, Board<Number> &solution);
+
+/**
+ * Generates a problem with a unique solution. Returns the number of clues in
+ * the problem, which may exceed the target if no attempt reached it. If no
+ * attempt reaches the target difficulty, the problem with the closest
+ * difficulty is returned and "missed", if not null, is set to true.
+ */
+extern std::size_t generateProblem(
+        Random &random,
+        const GeneratorOptions &options,
+        Board<Number> &problem,
+        bool *missed = nullptr);
+
+/**
+ * Generates "count" problems in the thread pool and calls back for each of
+ * them in index order. Problem i is generated from a random generator seeded
+ * with "seed" and i, so the output does not depend on the number of threads.
+ * Returns the number of problems that missed the target difficulty.
+ */
+extern std::size_t generateProblems(
+        std::uint64_t seed,
+        std::size_t count,
+        const GeneratorOptions &options,
+        ThreadPool &pool,
+        std::function<void(const Board<Number> &problem)> callback);
+
+
+#endif // #ifndef INCLUDED_GENERATOR_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,123 @@
+#include <string>
+#include <vector>
+#include "Format.hh"
+#include "Generator.hh"
+#include "Solver.hh"
+#include "Tester.inl"
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+
+static size_t countClues(const Board<Number> &problem) {
+    size_t clues = 0;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        if (problem[pos] < N)
+            clues++;
+        return true;
+    });
+    return clues;
+}
+
+static void testGenerateSolution() {
+    Random random(1);
+    Board<Number> solution1, solution2;
+    generateSolution(random, solution1);
+    generateSolution(random, solution2);
+    test_assert(formatLine(solution1) != formatLine(solution2));
+
+    Board<PossibilitySet> board;
+    convert(solution1, board);
+    eliminateImpossibilities(board);
+    test_assert(classify(board) == BoardState::SOLVED);
+    test_assert(countClues(solution1) == N * N);
+}
+
+static void testGenerateProblem(const GeneratorOptions &options) {
+    Random random(2);
+    Board<Number> problem, solution;
+    size_t clues = generateProblem(random, options, problem);
+    test_assert(clues == countClues(problem));
+    if (options.clues != 0)
+        test_assert(clues <= options.clues);
+
+    SearchBudget budget;
+    test_assert(solve(problem, solution, budget) == SolveResult::UNIQUE);
+
+    if (options.symmetry == Symmetry::ROTATIONAL) {
+        wholeArea.forAllPositions([&](Position pos) -> bool {
+            Position mirror(N - 1 - pos.i(), N - 1 - pos.j());
+            test_assert((problem[pos] < N) == (problem[mirror] < N));
+            return true;
+        });
+    }
+}
+
+static void testGenerateProblem() {
+    GeneratorOptions options;
+    testGenerateProblem(options);
+    options.symmetry = Symmetry::ROTATIONAL;
+    testGenerateProblem(options);
+    options.clues = 32;
+    testGenerateProblem(options);
+}
+
+static void testRatedProblems() {
+    // Every problem is rated at the target unless it is reported as a miss.
+    GeneratorOptions options;
+    options.rated = true;
+    options.attempts = 3;
+    for (Difficulty difficulty : {Difficulty::EASY, Difficulty::HARD}) {
+        options.difficulty = difficulty;
+        Random random(2);
+        for (int i = 0; i < 5; i++) {
+            Board<Number> problem;
+            bool missed = true;
+            generateProblem(random, options, problem, &missed);
+            test_assert(missed != (rate(problem).difficulty == difficulty));
+        }
+    }
+
+    ThreadPool pool(2);
+    size_t rated = 0;
+    options.difficulty = Difficulty::HARD;
+    size_t misses = generateProblems(2, 5, options, pool,
+            [&](const Board<Number> &problem) {
+                if (rate(problem).difficulty == Difficulty::HARD)
+                    rated++;
+            });
+    test_assert(misses + rated == 5);
+}
+
+static vector<string> generateLines(size_t threads) {
+    ThreadPool pool(threads);
+    vector<string> lines;
+    generateProblems(3, 40, GeneratorOptions(), pool,
+            [&](const Board<Number> &problem) {
+                lines.push_back(formatLine(problem));
+            });
+    return lines;
+}
+
+static void testGenerateProblems() {
+    vector<string> lines1 = generateLines(1), lines2 = generateLines(3);
+    test_assert(lines1.size() == 40);
+    test_assert(lines1 == lines2);
+    test_assert(lines1.at(0) != lines1.at(1));
+}
+
+static void testAll() {
+    testGenerateSolution();
+    testGenerateProblem();
+    testRatedProblems();
+    testGenerateProblems();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,117 @@
+#include <new>
+#include "Board.hh"
+#include "Solver.hh"
+#include "sudoku.h"
+
+using std::size_t;
+
+
+static_assert(N * N == SUDOKU_CELLS, "packed puzzles have one byte per cell");
+
+struct sudoku_context {
+    SearchOptions options;
+    size_t nodeLimit = SearchBudget::unlimited;
+    Board<Number> problem, solution;
+};
+
+static bool unpack(const unsigned char *bytes, Board<Number> &board) noexcept {
+    for (Number i = 0; i < N; i++) {
+        for (Number j = 0; j < N; j++) {
+            unsigned char byte = *bytes++;
+            if (byte > N)
+                return false;
+            board[Position(i, j)] = byte == 0 ? N : byte - 1;
+        }
+    }
+    return true;
+}
+
+static void pack(const Board<Number> &board, unsigned char *bytes) noexcept {
+    for (Number i = 0; i < N; i++)
+        for (Number j = 0; j < N; j++)
+            *bytes++ = static_cast<unsigned char>(board[Position(i, j)] + 1);
+}
+
+static int status(SolveResult result) noexcept {
+    switch (result) {
+    case SolveResult::UNIQUE:
+        return SUDOKU_UNIQUE;
+    case SolveResult::MULTIPLE:
+        return SUDOKU_MULTIPLE;
+    case SolveResult::INSOLVABLE:
+        return SUDOKU_INSOLVABLE;
+    case SolveResult::ABORTED:
+        break;
+    }
+    return SUDOKU_ABORTED;
+}
+
+sudoku_context *sudoku_context_new(void) {
+    return new (std::nothrow) sudoku_context;
+}
+
+void sudoku_context_free(sudoku_context *context) {
+    delete context;
+}
+
+int sudoku_set_backend(sudoku_context *context, const char *name) {
+    return parseBackend(name, context->options.backend) ? 0 : -1;
+}
+
+void sudoku_set_node_limit(
+        sudoku_context *context, unsigned long long node_limit) {
+    context->nodeLimit = node_limit == 0 ?
+            SearchBudget::unlimited : static_cast<size_t>(node_limit);
+}
+
+int sudoku_solve(
+        sudoku_context *context,
+        const unsigned char *puzzle,
+        unsigned char *solution) {
+    if (!unpack(puzzle, context->problem))
+        return SUDOKU_INVALID;
+
+    SearchBudget budget(context->nodeLimit);
+    int result = status(solve(context->problem, context->solution, budget,
+                context->options));
+    if (result == SUDOKU_UNIQUE || result == SUDOKU_MULTIPLE)
+        pack(context->solution, solution);
+    return result;
+}
+
+size_t sudoku_solve_batch(
+        sudoku_context *context,
+        const unsigned char *puzzles,
+        size_t count,
+        unsigned char *solutions,
+        int *statuses) {
+    size_t solved = 0;
+    for (size_t k = 0; k < count; k++) {
+        int result = sudoku_solve(context,
+                puzzles + k * SUDOKU_CELLS, solutions + k * SUDOKU_CELLS);
+        if (result == SUDOKU_UNIQUE || result == SUDOKU_MULTIPLE)
+            solved++;
+        if (statuses != nullptr)
+            statuses[k] = result;
+    }
+    return solved;
+}
+
+const char *sudoku_status_name(int status) {
+    switch (status) {
+    case SUDOKU_UNIQUE:
+        return "unique";
+    case SUDOKU_MULTIPLE:
+        return "multiple";
+    case SUDOKU_INSOLVABLE:
+        return "insolvable";
+    case SUDOKU_ABORTED:
+        return "aborted";
+    case SUDOKU_INVALID:
+        return "invalid";
+    }
+    return "unknown";
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,105 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include "sudoku.h"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+/** The number of calls to operator new, which the library also uses. */
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations++;
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static void pack(const char *line, unsigned char *bytes) {
+    for (int k = 0; k < SUDOKU_CELLS; k++)
+        bytes[k] = static_cast<unsigned char>(line[k] - '0');
+}
+
+static void testSolve(const char *backend) {
+    sudoku_context *context = sudoku_context_new();
+    test_assert(context != nullptr);
+    test_assert(sudoku_set_backend(context, backend) == 0);
+    test_assert(sudoku_set_backend(context, "abacus") == -1);
+
+    unsigned char puzzle[SUDOKU_CELLS], solution[SUDOKU_CELLS];
+    unsigned char expected[SUDOKU_CELLS];
+    pack(problemLine, puzzle);
+    pack(solutionLine, expected);
+    test_assert(sudoku_solve(context, puzzle, solution) == SUDOKU_UNIQUE);
+    test_assert(std::memcmp(solution, expected, SUDOKU_CELLS) == 0);
+
+    puzzle[0] = 10;
+    test_assert(sudoku_solve(context, puzzle, solution) == SUDOKU_INVALID);
+
+    sudoku_context_free(context);
+}
+
+static void testBatch() {
+    sudoku_context *context = sudoku_context_new();
+    unsigned char puzzles[4 * SUDOKU_CELLS] = {};
+    unsigned char solutions[4 * SUDOKU_CELLS];
+    int statuses[4];
+    pack(problemLine, puzzles);
+    // The second puzzle is blank.
+    pack(problemLine, puzzles + 2 * SUDOKU_CELLS);
+    puzzles[2 * SUDOKU_CELLS + 1] = 1;
+    pack(problemLine, puzzles + 3 * SUDOKU_CELLS);
+    puzzles[3 * SUDOKU_CELLS + 5] = 255;
+
+    test_assert(sudoku_solve_batch(
+                context, puzzles, 4, solutions, statuses) == 2);
+    test_assert(statuses[0] == SUDOKU_UNIQUE);
+    test_assert(statuses[1] == SUDOKU_MULTIPLE);
+    test_assert(statuses[2] == SUDOKU_INSOLVABLE);
+    test_assert(statuses[3] == SUDOKU_INVALID);
+    test_assert(std::string(sudoku_status_name(statuses[1])) == "multiple");
+    test_assert(std::string(sudoku_status_name(-1)) == "unknown");
+
+    // Once warmed up, solving allocates nothing.
+    std::size_t before = allocations;
+    for (int k = 0; k < 10; k++)
+        test_assert(sudoku_solve_batch(
+                    context, puzzles, 4, solutions, nullptr) == 2);
+    test_assert(allocations == before);
+
+    sudoku_set_node_limit(context, 1);
+    test_assert(sudoku_solve_batch(
+                context, puzzles + SUDOKU_CELLS, 1, solutions, statuses) ==
+            0);
+    test_assert(statuses[0] == SUDOKU_ABORTED);
+    sudoku_set_node_limit(context, 0);
+    test_assert(sudoku_solve_batch(
+                context, puzzles + SUDOKU_CELLS, 1, solutions, statuses) ==
+            1);
+
+    sudoku_context_free(context);
+}
+
+static void testAll() {
+    testSolve("cells");
+    testSolve("bitboard");
+    testBatch();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
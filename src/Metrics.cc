@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Metrics.hh"
+
+using std::size_t;
+using std::string;
+using std::uint64_t;
+
+
+static const char *const stageNames[] = {
+    "parse", "solve", "write",
+};
+
+const char *stageName(Stage stage) noexcept {
+    return stageNames[static_cast<size_t>(stage)];
+}
+
+constexpr size_t Histogram::bucketCount;
+
+/** The number of bits needed to write the value. */
+static unsigned bitLength(uint64_t value) noexcept {
+    unsigned width = 0;
+    for (; value > 0; value >>= 1)
+        width++;
+    return width;
+}
+
+size_t Histogram::bucketIndex(uint64_t value) noexcept {
+    if (value < 2 * subBucketCount)
+        return static_cast<size_t>(value);
+    if (bitLength(value) > valueBits)
+        return bucketCount - 1;
+    // The top subBucketBits + 1 bits of the value pick the bucket.
+    unsigned shift = bitLength(value) - (subBucketBits + 1);
+    return (shift + 1) * subBucketCount +
+            static_cast<size_t>((value >> shift) - subBucketCount);
+}
+
+uint64_t Histogram::bucketMax(size_t index) noexcept {
+    if (index < 2 * subBucketCount)
+        return index;
+    unsigned shift = static_cast<unsigned>(index / subBucketCount - 1);
+    uint64_t top = subBucketCount + index % subBucketCount;
+    return ((top + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) noexcept {
+    mCounts[bucketIndex(value)]++;
+    mCount++;
+    mSum += value;
+    mMax = std::max(mMax, value);
+}
+
+void Histogram::add(
+        const std::vector<uint64_t> &counts,
+        uint64_t sum,
+        uint64_t max)
+        noexcept {
+    for (size_t i = 0; i < bucketCount; i++) {
+        mCounts[i] += counts[i];
+        mCount += counts[i];
+    }
+    mSum += sum;
+    mMax = std::max(mMax, max);
+}
+
+Histogram &Histogram::operator+=(const Histogram &other) noexcept {
+    for (size_t i = 0; i < bucketCount; i++)
+        mCounts[i] += other.mCounts[i];
+    mCount += other.mCount;
+    mSum += other.mSum;
+    mMax = std::max(mMax, other.mMax);
+    return *this;
+}
+
+uint64_t Histogram::quantile(double q) const noexcept {
+    if (mCount == 0)
+        return 0;
+    // The rank of the value, from 1.
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * mCount));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount; i++) {
+        seen += mCounts[i];
+        if (seen >= rank)
+            return std::min(bucketMax(i), mMax);
+    }
+    return mMax;
+}
+
+uint64_t MetricsSnapshot::problems() const noexcept {
+    uint64_t sum = 0;
+    for (uint64_t count : results)
+        sum += count;
+    return sum + malformed;
+}
+
+void Metrics::Recorder::record(Stage stage, Clock::duration time) noexcept {
+    size_t s = static_cast<size_t>(stage);
+    uint64_t value = static_cast<uint64_t>(std::max<Clock::rep>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                time).count(), 0));
+    add(mBuckets[s][Histogram::bucketIndex(value)], 1);
+    add(mSums[s], value);
+    if (value > mMaxes[s].load(std::memory_order_relaxed))
+        mMaxes[s].store(value, std::memory_order_relaxed);
+}
+
+void Metrics::Recorder::count(SolveResult result) noexcept {
+    add(mResults[static_cast<size_t>(result)], 1);
+}
+
+void Metrics::Recorder::countMalformed() noexcept {
+    add(mMalformed, 1);
+}
+
+void Metrics::Recorder::addTo(MetricsSnapshot &snapshot) const {
+    for (size_t s = 0; s < stageCount; s++) {
+        std::vector<uint64_t> buckets(Histogram::bucketCount);
+        for (size_t i = 0; i < Histogram::bucketCount; i++)
+            buckets[i] = mBuckets[s][i].load(std::memory_order_relaxed);
+        snapshot.stages[s].add(buckets,
+                mSums[s].load(std::memory_order_relaxed),
+                mMaxes[s].load(std::memory_order_relaxed));
+    }
+    for (size_t r = 0; r < solveResultCount; r++)
+        snapshot.results[r] += mResults[r].load(std::memory_order_relaxed);
+    snapshot.malformed += mMalformed.load(std::memory_order_relaxed);
+}
+
+/** Distinguishes the Metrics objects in the caches of the threads. */
+static std::atomic<uint64_t> nextMetricsId{0};
+
+Metrics::Metrics() : mId(nextMetricsId++), mStart(Clock::now()) { }
+
+Metrics::Recorder &Metrics::local() {
+    // The recorders this thread has, by the id of their Metrics.
+    thread_local std::vector<std::pair<uint64_t, Recorder *>> recorders;
+    for (const auto &entry : recorders)
+        if (entry.first == mId)
+            return *entry.second;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRecorders.emplace_back(new Recorder());
+    recorders.emplace_back(mId, mRecorders.back().get());
+    return *mRecorders.back();
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+    MetricsSnapshot snapshot;
+    snapshot.uptime = Clock::now() - mStart;
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const std::unique_ptr<Recorder> &recorder : mRecorders)
+        recorder->addTo(snapshot);
+    return snapshot;
+}
+
+static const double exportedQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+static double seconds(uint64_t nanoseconds) noexcept {
+    return static_cast<double>(nanoseconds) * 1e-9;
+}
+
+void writePrometheus(std::ostream &os, const MetricsSnapshot &snapshot) {
+    std::ostringstream text;
+    text << std::setprecision(9);
+
+    text << "# HELP sudoku_stage_seconds Latency of each stage of answering "
+            "a problem.\n"
+            "# TYPE sudoku_stage_seconds summary\n";
+    for (size_t s = 0; s < stageCount; s++) {
+        const Histogram &histogram = snapshot.stages[s];
+        string label = string("stage=\"") + stageNames[s] + '"';
+        for (double q : exportedQuantiles)
+            text << "sudoku_stage_seconds{" << label << ",quantile=\"" <<
+                    q << "\"} " << seconds(histogram.quantile(q)) << '\n';
+        text << "sudoku_stage_seconds_sum{" << label << "} " <<
+                seconds(histogram.sum()) << '\n';
+        text << "sudoku_stage_seconds_count{" << label << "} " <<
+                histogram.count() << '\n';
+    }
+
+    text << "# HELP sudoku_problems_total Problems answered, by result.\n"
+            "# TYPE sudoku_problems_total counter\n";
+    for (size_t r = 0; r < solveResultCount; r++)
+        text << "sudoku_problems_total{result=\"" <<
+                solveResultName(static_cast<SolveResult>(r)) << "\"} " <<
+                snapshot.results[r] << '\n';
+
+    text << "# HELP sudoku_malformed_total Problems that could not be "
+            "parsed.\n"
+            "# TYPE sudoku_malformed_total counter\n"
+            "sudoku_malformed_total " << snapshot.malformed << '\n';
+
+    text << "# HELP sudoku_uptime_seconds Time since the metrics started.\n"
+            "# TYPE sudoku_uptime_seconds gauge\n"
+            "sudoku_uptime_seconds " <<
+            std::chrono::duration<double>(snapshot.uptime).count() << '\n';
+    os << text.str();
+}
+
+std::ostream &operator<<(std::ostream &os, const MetricsSnapshot &snapshot) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(6);
+    for (size_t s = 0; s < stageCount; s++) {
+        const Histogram &histogram = snapshot.stages[s];
+        text << stageNames[s] << " count=" << histogram.count();
+        for (double q : exportedQuantiles) {
+            std::ostringstream name;
+            name << q * 100;
+            text << " p" << name.str() << '=' <<
+                    seconds(histogram.quantile(q)) << 's';
+        }
+        text << " max=" << seconds(histogram.max()) << "s\n";
+    }
+    double uptime = std::chrono::duration<double>(snapshot.uptime).count();
+    text << "problems=" << snapshot.problems() << " malformed=" <<
+            snapshot.malformed << " rate=" <<
+            std::setprecision(1) <<
+            (uptime > 0 ? snapshot.problems() / uptime : 0.0) << "/s\n";
+    return os << text.str();
+}
+
+/** How long a client of the socket may take to accept its dump. */
+static const suseconds_t sendTimeoutMicroseconds = 100000;
+
+MetricsExporter::MetricsExporter(
+        const Metrics &metrics,
+        const string &filePath,
+        const string &socketPath,
+        std::chrono::milliseconds interval) :
+        mMetrics(metrics), mFilePath(filePath), mInterval(interval) {
+    if (!socketPath.empty()) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof address.sun_path)
+            throw std::system_error(
+                    ENAMETOOLONG, std::generic_category(), socketPath);
+        socketPath.copy(address.sun_path, socketPath.size());
+
+        mListener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (mListener < 0)
+            throw std::system_error(
+                    errno, std::generic_category(), "socket");
+        unlink(socketPath.c_str());
+        if (bind(mListener, reinterpret_cast<sockaddr *>(&address),
+                    sizeof address) < 0 ||
+                listen(mListener, SOMAXCONN) < 0) {
+            int error = errno;
+            close(mListener);
+            throw std::system_error(
+                    error, std::generic_category(), socketPath);
+        }
+    }
+
+    if (pipe(mStopPipe) < 0) {
+        int error = errno;
+        if (mListener >= 0)
+            close(mListener);
+        throw std::system_error(error, std::generic_category(), "pipe");
+    }
+    mThread = std::thread(&MetricsExporter::run, this);
+}
+
+MetricsExporter::~MetricsExporter() {
+    close(mStopPipe[1]);
+    mThread.join();
+    close(mStopPipe[0]);
+    if (mListener >= 0)
+        close(mListener);
+    if (!mFilePath.empty())
+        writeFile();
+}
+
+void MetricsExporter::run() {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point nextDump = Clock::now() + mInterval;
+    for (;;) {
+        int timeout = -1;
+        if (!mFilePath.empty()) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    nextDump - Clock::now());
+            timeout = static_cast<int>(std::max<long long>(wait.count(), 0));
+        }
+
+        pollfd files[2] = {{mStopPipe[0], POLLIN, 0}, {mListener, POLLIN, 0}};
+        int ready = poll(files, mListener >= 0 ? 2 : 1, timeout);
+        if (ready < 0 && errno != EINTR)
+            return;
+        if (files[0].revents != 0)
+            return; // The write end has been closed.
+
+        if (mListener >= 0 && (files[1].revents & POLLIN)) {
+            int fd = accept(mListener, nullptr, nullptr);
+            if (fd >= 0) {
+                // A client that does not take its dump is dropped rather
+                // than let it hold up the file dumps.
+                timeval timeout = {0, sendTimeoutMicroseconds};
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO,
+                        &timeout, sizeof timeout);
+                answer(fd);
+                close(fd);
+            }
+        }
+        if (!mFilePath.empty() && Clock::now() >= nextDump) {
+            writeFile();
+            nextDump += mInterval;
+        }
+    }
+}
+
+void MetricsExporter::writeFile() const {
+    // Renamed over the file, so a reader never sees half a dump.
+    string temporary = mFilePath + ".tmp";
+    {
+        std::ofstream os(temporary);
+        writePrometheus(os, mMetrics.snapshot());
+        if (!os.flush())
+            return;
+    }
+    std::rename(temporary.c_str(), mFilePath.c_str());
+}
+
+void MetricsExporter::answer(int fd) const {
+    std::ostringstream os;
+    writePrometheus(os, mMetrics.snapshot());
+    string text = os.str();
+    for (size_t written = 0; written < text.size(); ) {
+        // A client that has gone away must not kill the process.
+        ssize_t n = send(fd, text.data() + written, text.size() - written,
+                MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        written += static_cast<size_t>(n);
+    }
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,252 @@
+#ifndef INCLUDED_METRICS_HH
+#define INCLUDED_METRICS_HH 1
+
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Solver.hh"
+
+
+/** The stages of answering a problem whose latencies Metrics records. */
+enum class Stage {
+    PARSE, SOLVE, WRITE,
+};
+
+constexpr std::size_t stageCount = 3;
+
+constexpr std::size_t solveResultCount = 4;
+
+extern const char *stageName(Stage stage) noexcept;
+
+/**
+ * A histogram of latencies in nanoseconds in the manner of HdrHistogram.
+ * Values below 64 have a bucket each; above, each power of two is split
+ * into 32 buckets, so a value is known within about 3% up to 2^45 ns
+ * (nearly ten hours). Larger values fall in the last bucket.
+ */
+class Histogram {
+
+public:
+
+    static constexpr unsigned subBucketBits = 5;
+    static constexpr std::size_t subBucketCount = 1u << subBucketBits;
+    static constexpr unsigned valueBits = 45;
+    static constexpr std::size_t bucketCount =
+            (valueBits - subBucketBits + 1) * subBucketCount;
+
+    static std::size_t bucketIndex(std::uint64_t value) noexcept;
+    /** The largest value counted in the bucket. */
+    static std::uint64_t bucketMax(std::size_t index) noexcept;
+
+private:
+
+    std::vector<std::uint64_t> mCounts;
+    std::uint64_t mCount = 0, mSum = 0, mMax = 0;
+
+public:
+
+    Histogram() : mCounts(bucketCount) { }
+
+    void record(std::uint64_t value) noexcept;
+
+    /**
+     * Adds values given by their count in each bucket, their sum and the
+     * largest of them.
+     */
+    void add(
+            const std::vector<std::uint64_t> &counts,
+            std::uint64_t sum,
+            std::uint64_t max)
+            noexcept;
+
+    /** Adds the values counted in the other histogram. */
+    Histogram &operator+=(const Histogram &other) noexcept;
+
+    std::uint64_t count() const noexcept {
+        return mCount;
+    }
+
+    std::uint64_t sum() const noexcept {
+        return mSum;
+    }
+
+    std::uint64_t max() const noexcept {
+        return mMax;
+    }
+
+    std::uint64_t bucket(std::size_t index) const noexcept {
+        return mCounts[index];
+    }
+
+    /**
+     * Returns the largest value of the bucket that holds the given quantile
+     * (from 0 to 1), but no more than the largest value recorded, or 0 if
+     * there are no values.
+     */
+    std::uint64_t quantile(double q) const noexcept;
+
+};
+
+/** Latencies and counts merged from every thread at one time. */
+struct MetricsSnapshot {
+    std::array<Histogram, stageCount> stages;
+    /** The number of problems answered with each result. */
+    std::array<std::uint64_t, solveResultCount> results{};
+    /** The number of problems that could not be parsed. */
+    std::uint64_t malformed = 0;
+    /** The time since the metrics were created. */
+    std::chrono::steady_clock::duration uptime{0};
+
+    const Histogram &stage(Stage s) const noexcept {
+        return stages[static_cast<std::size_t>(s)];
+    }
+
+    /** The number of problems answered, malformed ones included. */
+    std::uint64_t problems() const noexcept;
+};
+
+/**
+ * Latency histograms and result counters kept by each thread that records
+ * into them. Recording never locks or contends: a thread only writes its
+ * own counters, with relaxed atomic stores, and snapshot reads every
+ * thread's counters to merge them. A thread takes the lock once, when it
+ * records for the first time.
+ */
+class Metrics {
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    /** The counters of one thread. */
+    class Recorder {
+
+    private:
+
+        using Counter = std::atomic<std::uint64_t>;
+
+        std::array<std::array<Counter, Histogram::bucketCount>, stageCount>
+                mBuckets{};
+        std::array<Counter, stageCount> mSums{}, mMaxes{};
+        std::array<Counter, solveResultCount> mResults{};
+        Counter mMalformed{0};
+
+        /** Increases a counter that no other thread writes. */
+        static void add(Counter &counter, std::uint64_t value) noexcept {
+            counter.store(
+                    counter.load(std::memory_order_relaxed) + value,
+                    std::memory_order_relaxed);
+        }
+
+    public:
+
+        void record(Stage stage, Clock::duration time) noexcept;
+        void count(SolveResult result) noexcept;
+        void countMalformed() noexcept;
+
+        /** Adds the counters to the snapshot. */
+        void addTo(MetricsSnapshot &snapshot) const;
+
+    };
+
+private:
+
+    const std::uint64_t mId;
+    const Clock::time_point mStart;
+    mutable std::mutex mMutex;
+    std::deque<std::unique_ptr<Recorder>> mRecorders;
+
+public:
+
+    Metrics();
+    Metrics(const Metrics &metrics) = delete;
+    Metrics &operator=(const Metrics &metrics) = delete;
+
+    /** Returns the recorder of the calling thread. */
+    Recorder &local();
+
+    void record(Stage stage, Clock::duration time) {
+        local().record(stage, time);
+    }
+
+    void count(SolveResult result) {
+        local().count(result);
+    }
+
+    /** Counts a problem that could not be parsed and was not solved. */
+    void countMalformed() {
+        local().countMalformed();
+    }
+
+    MetricsSnapshot snapshot() const;
+
+};
+
+/**
+ * Writes the snapshot in the Prometheus text exposition format: a summary
+ * of the latency of each stage in seconds with its 0.5, 0.9, 0.99 and 0.999
+ * quantiles, a counter of the problems by result, a counter of the
+ * malformed problems, and the uptime.
+ */
+extern void writePrometheus(std::ostream &os, const MetricsSnapshot &snapshot);
+
+/**
+ * Prints one line for each stage with its count and quantiles and one with
+ * the problems, the malformed ones among them, and their rate.
+ */
+extern std::ostream &operator<<(
+        std::ostream &os,
+        const MetricsSnapshot &snapshot);
+
+/**
+ * Exports the metrics in a background thread. If the file path is not
+ * empty, the file is replaced with a dump every interval and once more when
+ * the exporter is destroyed. If the socket path is not empty, a Unix domain
+ * socket is listened on there, and every connection is sent a dump of the
+ * moment and closed. A client that does not take its dump within 100 ms or
+ * closes the connection first is dropped.
+ */
+class MetricsExporter {
+
+private:
+
+    const Metrics &mMetrics;
+    std::string mFilePath;
+    std::chrono::milliseconds mInterval;
+    int mListener = -1;
+    /** A pipe whose write end is closed to stop the thread. */
+    int mStopPipe[2] = {-1, -1};
+    std::thread mThread;
+
+    void run();
+    void writeFile() const;
+    void answer(int fd) const;
+
+public:
+
+    /** Throws std::system_error if the socket cannot be set up. */
+    MetricsExporter(
+            const Metrics &metrics,
+            const std::string &filePath,
+            const std::string &socketPath,
+            std::chrono::milliseconds interval);
+    MetricsExporter(const MetricsExporter &exporter) = delete;
+    ~MetricsExporter();
+    MetricsExporter &operator=(const MetricsExporter &exporter) = delete;
+
+};
+
+
+#endif // #ifndef INCLUDED_METRICS_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
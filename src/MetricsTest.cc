@@ -0,0 +1,215 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Metrics.hh"
+#include "Tester.inl"
+
+
+static void testBuckets() {
+    // Every value falls in a bucket whose range holds it, and the buckets
+    // follow each other without gaps.
+    for (std::size_t i = 1; i < Histogram::bucketCount; i++)
+        test_assert(Histogram::bucketMax(i - 1) < Histogram::bucketMax(i));
+    for (std::uint64_t value : {0ull, 1ull, 63ull, 64ull, 65ull, 1000ull,
+                123456789ull, (1ull << 45) - 1}) {
+        std::size_t index = Histogram::bucketIndex(value);
+        test_assert(index < Histogram::bucketCount);
+        test_assert(value <= Histogram::bucketMax(index));
+        test_assert(index == 0 || Histogram::bucketMax(index - 1) < value);
+        // Within about 3%.
+        test_assert(Histogram::bucketMax(index) - value <= value / 32);
+    }
+    test_assert(Histogram::bucketIndex(1ull << 50) ==
+            Histogram::bucketCount - 1);
+}
+
+static void testQuantiles() {
+    Histogram histogram;
+    test_assert(histogram.quantile(0.5) == 0);
+    for (std::uint64_t value = 1; value <= 10000; value++)
+        histogram.record(value);
+    test_assert(histogram.count() == 10000);
+    test_assert(histogram.sum() == 10000 * 10001 / 2);
+    test_assert(histogram.max() == 10000);
+
+    std::uint64_t median = histogram.quantile(0.5);
+    test_assert(median >= 5000 && median <= 5000 + 5000 / 32);
+    std::uint64_t p99 = histogram.quantile(0.99);
+    test_assert(p99 >= 9900 && p99 <= 9900 + 9900 / 32);
+    test_assert(histogram.quantile(1) == 10000);
+    test_assert(histogram.quantile(0) == 1);
+
+    Histogram other;
+    other.record(20000);
+    histogram += other;
+    test_assert(histogram.count() == 10001);
+    test_assert(histogram.max() == 20000);
+    test_assert(histogram.quantile(1) == 20000);
+}
+
+static void testThreads() {
+    Metrics metrics;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&metrics, t] {
+            for (int i = 0; i < 1000; i++) {
+                metrics.record(Stage::SOLVE, std::chrono::microseconds(t + 1));
+                metrics.count(SolveResult::UNIQUE);
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    metrics.record(Stage::PARSE, std::chrono::nanoseconds(100));
+    metrics.count(SolveResult::ABORTED);
+    metrics.countMalformed();
+
+    MetricsSnapshot snapshot = metrics.snapshot();
+    const Histogram &solve = snapshot.stage(Stage::SOLVE);
+    test_assert(solve.count() == 4000);
+    test_assert(solve.sum() == 1000 * (1000 + 2000 + 3000 + 4000));
+    test_assert(solve.max() == 4000);
+    test_assert(snapshot.stage(Stage::PARSE).count() == 1);
+    test_assert(snapshot.stage(Stage::WRITE).count() == 0);
+    test_assert(snapshot.results[0] == 4000);
+    test_assert(snapshot.results[3] == 1);
+    test_assert(snapshot.malformed == 1);
+    test_assert(snapshot.problems() == 4002);
+
+    // Another Metrics does not share the recorders of this thread.
+    Metrics fresh;
+    test_assert(fresh.snapshot().problems() == 0);
+}
+
+static void testPrometheus() {
+    Metrics metrics;
+    metrics.record(Stage::SOLVE, std::chrono::milliseconds(2));
+    metrics.count(SolveResult::MULTIPLE);
+    metrics.countMalformed();
+
+    std::ostringstream os;
+    writePrometheus(os, metrics.snapshot());
+    std::string text = os.str();
+    test_assert(text.find("# TYPE sudoku_stage_seconds summary\n") !=
+            std::string::npos);
+    test_assert(text.find(
+                "sudoku_stage_seconds{stage=\"solve\",quantile=\"0.5\"} "
+                "0.002") != std::string::npos);
+    test_assert(text.find(
+                "sudoku_stage_seconds_count{stage=\"solve\"} 1\n") !=
+            std::string::npos);
+    test_assert(text.find(
+                "sudoku_stage_seconds_count{stage=\"write\"} 0\n") !=
+            std::string::npos);
+    test_assert(text.find("sudoku_problems_total{result=\"multiple\"} 1\n") !=
+            std::string::npos);
+    test_assert(text.find("\nsudoku_malformed_total 1\n") !=
+            std::string::npos);
+    test_assert(text.find("\nsudoku_uptime_seconds ") != std::string::npos);
+    test_assert(text.back() == '\n');
+
+    std::ostringstream summary;
+    summary << metrics.snapshot();
+    test_assert(summary.str().find("solve count=1 p50=0.002") !=
+            std::string::npos);
+    test_assert(summary.str().find("problems=2 malformed=1 rate=") !=
+            std::string::npos);
+}
+
+static std::string readAll(int fd) {
+    std::string text;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof buffer)) > 0)
+        text.append(buffer, static_cast<std::size_t>(n));
+    return text;
+}
+
+/** Connects to the Unix domain socket at the path. */
+static int connectTo(const std::string &path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    test_assert(fd >= 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+    test_assert(connect(fd, reinterpret_cast<sockaddr *>(&address),
+                sizeof address) == 0);
+    return fd;
+}
+
+static void testExporter() {
+    std::string base = "MetricsTest.tmp";
+    std::string file = base + ".prom", socketPath = base + ".sock";
+    std::remove(file.c_str());
+
+    Metrics metrics;
+    metrics.count(SolveResult::UNIQUE);
+    {
+        MetricsExporter exporter(metrics, file, socketPath,
+                std::chrono::milliseconds(10));
+
+        int fd = connectTo(socketPath);
+        std::string text = readAll(fd);
+        close(fd);
+        test_assert(text.find(
+                    "sudoku_problems_total{result=\"unique\"} 1\n") !=
+                std::string::npos);
+
+        metrics.count(SolveResult::UNIQUE);
+    }
+
+    // The last dump is written when the exporter is destroyed.
+    std::ifstream is(file);
+    std::stringstream text;
+    text << is.rdbuf();
+    test_assert(text.str().find(
+                "sudoku_problems_total{result=\"unique\"} 2\n") !=
+            std::string::npos);
+    std::remove(file.c_str());
+    std::remove(socketPath.c_str());
+}
+
+static void testClosingClients() {
+    std::string socketPath = "MetricsTest.tmp.sock";
+    Metrics metrics;
+    metrics.count(SolveResult::UNIQUE);
+    MetricsExporter exporter(metrics, "", socketPath,
+            std::chrono::milliseconds(10));
+
+    // Clients that hang up before reading their dump must not take the
+    // process down with SIGPIPE or stop the exporter.
+    for (int i = 0; i < 100; i++)
+        close(connectTo(socketPath));
+    int fd = connectTo(socketPath);
+    std::string text = readAll(fd);
+    close(fd);
+    test_assert(text.find("sudoku_problems_total{result=\"unique\"} 1\n") !=
+            std::string::npos);
+    std::remove(socketPath.c_str());
+}
+
+static void testAll() {
+    testBuckets();
+    testQuantiles();
+    testThreads();
+    testPrometheus();
+    testExporter();
+    testClosingClients();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,320 @@
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "AutoTune.hh"
+#include "Options.hh"
+
+using std::invalid_argument;
+using std::istringstream;
+using std::size_t;
+using std::string;
+
+
+/**
+ * Splits a "--name=value" argument. Returns false if the argument does not
+ * have the given name. The value is empty if there is no '='.
+ */
+static bool matchOption(
+        const string &argument,
+        const char *name,
+        string &value,
+        bool &hasValue) {
+    string prefix = string("--") + name;
+    if (argument.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    if (argument.size() == prefix.size()) {
+        value.clear();
+        hasValue = false;
+        return true;
+    }
+    if (argument[prefix.size()] != '=')
+        return false;
+    value = argument.substr(prefix.size() + 1);
+    hasValue = true;
+    return true;
+}
+
+static size_t parseCount(const string &option, const string &value) {
+    size_t count;
+    istringstream is(value);
+    if (value.empty() ||
+            value.find_first_not_of("0123456789") != string::npos ||
+            !(is >> count))
+        throw invalid_argument("invalid value for " + option + ": " + value);
+    return count;
+}
+
+static std::uint64_t parseSeed(const string &value) {
+    std::uint64_t seed;
+    istringstream is(value);
+    if (value.empty() ||
+            value.find_first_not_of("0123456789") != string::npos ||
+            !(is >> seed))
+        throw invalid_argument("invalid value for --seed: " + value);
+    return seed;
+}
+
+static void requireValue(const string &option, bool hasValue) {
+    if (!hasValue)
+        throw invalid_argument("missing value for " + option);
+}
+
+void parseOptions(int argc, char *const *argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i], value;
+        bool hasValue;
+
+        if (argument.compare(0, 2, "--") != 0) {
+            options.files.push_back(argument);
+        } else if (matchOption(argument, "help", value, hasValue)) {
+            options.help = true;
+        } else if (matchOption(argument, "format", value, hasValue)) {
+            requireValue("--format", hasValue);
+            if (!parseBoardFormat(value, options.format))
+                throw invalid_argument("unknown format: " + value);
+        } else if (matchOption(argument, "threads", value, hasValue)) {
+            requireValue("--threads", hasValue);
+            options.threads = parseCount("--threads", value);
+        } else if (matchOption(argument, "budget", value, hasValue)) {
+            requireValue("--budget", hasValue);
+            options.nodeLimit = parseCount("--budget", value);
+        } else if (matchOption(argument, "table", value, hasValue)) {
+            requireValue("--table", hasValue);
+            options.tableSize = parseCount("--table", value);
+        } else if (matchOption(argument, "portfolio", value, hasValue)) {
+            requireValue("--portfolio", hasValue);
+            options.portfolio = parseCount("--portfolio", value);
+        } else if (matchOption(argument, "backend", value, hasValue)) {
+            requireValue("--backend", hasValue);
+            if (!parseBackend(value, options.search.backend))
+                throw invalid_argument("unknown backend: " + value);
+        } else if (matchOption(argument, "order", value, hasValue)) {
+            requireValue("--order", hasValue);
+            if (!parseValueOrder(value, options.search.valueOrder))
+                throw invalid_argument("unknown order: " + value);
+        } else if (matchOption(argument, "tie-break", value, hasValue)) {
+            requireValue("--tie-break", hasValue);
+            if (!parseTieBreak(value, options.search.tieBreak))
+                throw invalid_argument("unknown tie-break: " + value);
+        } else if (matchOption(argument, "propagation", value, hasValue)) {
+            requireValue("--propagation", hasValue);
+            Propagation propagation;
+            if (!parsePropagation(value, propagation))
+                throw invalid_argument("unknown propagation: " + value);
+            setPropagation(options.search, propagation);
+        } else if (matchOption(argument, "restarts", value, hasValue)) {
+            requireValue("--restarts", hasValue);
+            options.search.restartUnit = parseCount("--restarts", value);
+        } else if (matchOption(argument, "shard", value, hasValue)) {
+            requireValue("--shard", hasValue);
+            if (!parseShard(value, options.search.shard))
+                throw invalid_argument("invalid value for --shard: " + value);
+        } else if (matchOption(argument, "shard-depth", value, hasValue)) {
+            requireValue("--shard-depth", hasValue);
+            options.search.shard.depth = parseCount("--shard-depth", value);
+        } else if (matchOption(argument, "checkpoint", value, hasValue)) {
+            requireValue("--checkpoint", hasValue);
+            options.checkpointPath = value;
+        } else if (matchOption(
+                    argument, "checkpoint-interval", value, hasValue)) {
+            requireValue("--checkpoint-interval", hasValue);
+            options.search.checkpointInterval =
+                    parseCount("--checkpoint-interval", value);
+            if (options.search.checkpointInterval == 0)
+                throw invalid_argument(
+                        "invalid value for --checkpoint-interval: 0");
+        } else if (matchOption(argument, "auto-tune", value, hasValue)) {
+            requireValue("--auto-tune", hasValue);
+            options.autoTune = parseCount("--auto-tune", value);
+            if (options.autoTune == 0)
+                throw invalid_argument("invalid value for --auto-tune: 0");
+        } else if (matchOption(argument, "load-profile", value, hasValue)) {
+            requireValue("--load-profile", hasValue);
+            options.loadProfilePath = value;
+        } else if (matchOption(argument, "save-profile", value, hasValue)) {
+            requireValue("--save-profile", hasValue);
+            options.saveProfilePath = value;
+        } else if (matchOption(argument, "packed", value, hasValue)) {
+            options.packed = true;
+        } else if (matchOption(argument, "decode", value, hasValue)) {
+            options.mode = Mode::DECODE;
+        } else if (matchOption(argument, "stats", value, hasValue)) {
+            options.stats = true;
+        } else if (matchOption(argument, "latency", value, hasValue)) {
+            options.latency = true;
+        } else if (matchOption(argument, "metrics", value, hasValue)) {
+            requireValue("--metrics", hasValue);
+            options.metricsPath = value;
+        } else if (matchOption(
+                    argument, "metrics-socket", value, hasValue)) {
+            requireValue("--metrics-socket", hasValue);
+            options.metricsSocketPath = value;
+        } else if (matchOption(
+                    argument, "metrics-interval", value, hasValue)) {
+            requireValue("--metrics-interval", hasValue);
+            options.metricsInterval = parseCount("--metrics-interval", value);
+            if (options.metricsInterval == 0)
+                throw invalid_argument(
+                        "invalid value for --metrics-interval: 0");
+        } else if (matchOption(argument, "merge", value, hasValue)) {
+            options.merge = true;
+        } else if (matchOption(argument, "cache", value, hasValue)) {
+            requireValue("--cache", hasValue);
+            options.cacheSize = parseCount("--cache", value);
+        } else if (matchOption(argument, "batch", value, hasValue)) {
+            options.mode = Mode::BATCH;
+        } else if (matchOption(argument, "server", value, hasValue)) {
+            requireValue("--server", hasValue);
+            options.mode = Mode::SERVER;
+            options.socketPath = value;
+        } else if (matchOption(argument, "stdio", value, hasValue)) {
+            options.mode = Mode::SERVER;
+            options.socketPath.clear();
+        } else if (matchOption(argument, "generate", value, hasValue)) {
+            requireValue("--generate", hasValue);
+            options.mode = Mode::GENERATE;
+            options.generateCount = parseCount("--generate", value);
+        } else if (matchOption(argument, "seed", value, hasValue)) {
+            requireValue("--seed", hasValue);
+            options.seed = options.search.seed = parseSeed(value);
+        } else if (matchOption(argument, "clues", value, hasValue)) {
+            requireValue("--clues", hasValue);
+            options.generator.clues = parseCount("--clues", value);
+        } else if (matchOption(argument, "difficulty", value, hasValue)) {
+            requireValue("--difficulty", hasValue);
+            if (!parseDifficulty(value, options.generator.difficulty))
+                throw invalid_argument("unknown difficulty: " + value);
+            options.generator.rated = true;
+        } else if (matchOption(argument, "rate", value, hasValue)) {
+            options.mode = Mode::RATE;
+        } else if (matchOption(argument, "validate", value, hasValue)) {
+            options.mode = Mode::VALIDATE;
+        } else if (matchOption(argument, "verify", value, hasValue)) {
+            options.mode = Mode::VERIFY;
+        } else if (matchOption(argument, "count", value, hasValue)) {
+            options.mode = Mode::COUNT;
+        } else if (matchOption(argument, "benchmark", value, hasValue)) {
+            options.mode = Mode::BENCHMARK;
+        } else if (matchOption(argument, "symmetric", value, hasValue)) {
+            options.generator.symmetry = Symmetry::ROTATIONAL;
+        } else {
+            throw invalid_argument("unknown option: " + argument);
+        }
+    }
+    if (!options.merge && !options.files.empty())
+        throw invalid_argument("unexpected argument: " + options.files[0]);
+    if (!options.saveProfilePath.empty() && options.autoTune == 0)
+        throw invalid_argument("--save-profile needs --auto-tune");
+    if (options.packed && !options.checkpointPath.empty())
+        throw invalid_argument("--packed cannot be used with --checkpoint");
+}
+
+void printUsage(std::ostream &os) {
+    os <<
+        "Usage: sudoku [options] < problem\n"
+        "\n"
+        "Solves the problem read from the standard input and prints all of "
+        "its solutions.\n"
+        "\n"
+        "Options:\n"
+        "  --format=grid|line  board format of input and output\n"
+        "  --batch             solve every problem in the input and print the\n"
+        "                      status and first solution of each\n"
+        "  --server=PATH       serve solve requests on a Unix domain socket\n"
+        "  --stdio             serve solve requests on standard input/output\n"
+        "  --generate=N        generate N problems with unique solutions\n"
+        "  --seed=N            random seed for generating problems and for "
+        "random\n"
+        "                      search orders\n"
+        "  --clues=N           stop generating at N clues\n"
+        "  --symmetric         generate problems with symmetric clues\n"
+        "  --difficulty=LEVEL  generate problems of the given difficulty:\n"
+        "                      easy, medium, hard, expert or diabolical\n"
+        "  --rate              rate the difficulty of every problem in the "
+        "input\n"
+        "  --validate          check every problem in the input for givens "
+        "that\n"
+        "                      conflict\n"
+        "  --verify            check pairs of a problem and a claimed "
+        "solution\n"
+        "  --count             print the number of solutions of every problem "
+        "in the\n"
+        "                      input\n"
+        "  --benchmark         time solving every problem in the input with "
+        "each\n"
+        "                      backend\n"
+        "  --packed            print all solutions as a packed stream of the "
+        "cells\n"
+        "                      that differ from the previous solution\n"
+        "  --decode            print the solutions of packed streams in the "
+        "input\n"
+        "  --threads=N         number of worker threads\n"
+        "  --budget=N          maximum number of search nodes per problem\n"
+        "  --backend=NAME      board representation used by the search:\n"
+        "                      cells (default) or bitboard\n"
+        "  --order=ORDER       order of the numbers tried at a position:\n"
+        "                      ascending (default), descending or random\n"
+        "  --tie-break=RULE    position branched on among those with the "
+        "fewest\n"
+        "                      candidates: first (default), degree or random\n"
+        "  --propagation=LEVEL deduction done before branching: singles "
+        "(default),\n"
+        "                      locked (candidates) or subsets (pairs and "
+        "triples)\n"
+        "  --restarts=N        restart solving after N, N, 2N, N, N, 2N, 4N, "
+        "... nodes\n"
+        "                      (the Luby sequence), each time with a new "
+        "seed\n"
+        "  --portfolio=K       race K search configurations on every problem "
+        "of a\n"
+        "                      batch or server and take the first result\n"
+        "  --shard=I/N         only search the I-th of N parts (from 0) of "
+        "the search\n"
+        "                      tree, when printing all solutions or with "
+        "--count\n"
+        "  --shard-depth=D     split shards at depth D of the search tree "
+        "(default 4)\n"
+        "  --merge FILE...     combine the outputs of all shards of a run, "
+        "given in\n"
+        "                      shard order (with --count to add up the "
+        "counts)\n"
+        "  --checkpoint=FILE   save the search to FILE while printing all "
+        "solutions,\n"
+        "                      and resume from FILE if it exists\n"
+        "  --checkpoint-interval=N\n"
+        "                      save the search every N nodes (default "
+        "1000000)\n"
+        "  --auto-tune=N       before a batch, try search configurations on "
+        "its first\n"
+        "                      N problems and solve with the fastest\n"
+        "  --load-profile=FILE search with the configuration saved in FILE\n"
+        "  --save-profile=FILE save the configuration chosen by --auto-tune "
+        "to FILE\n"
+        "  --cache=N           cache the results of up to N distinct problems\n"
+        "  --table=N           remember up to N searched boards across the "
+        "problems\n"
+        "                      of a batch\n"
+        "  --stats             print the time and hardware event counts of "
+        "every phase\n"
+        "                      of solving to the standard error (and of "
+        "every problem\n"
+        "                      of a batch), less the estimated cost of "
+        "measuring them,\n"
+        "                      which slows the search down\n"
+        "  --latency           print the quantiles of the time taken to parse, "
+        "solve\n"
+        "                      and write the problems at the end of a batch\n"
+        "  --metrics=FILE      dump latencies and problem counts of a batch or "
+        "server\n"
+        "                      to FILE in the Prometheus text format\n"
+        "  --metrics-interval=N\n"
+        "                      dump the metrics every N seconds (default 10)\n"
+        "  --metrics-socket=PATH\n"
+        "                      send a dump of the metrics to every connection "
+        "to a\n"
+        "                      Unix domain socket at PATH\n"
+        "  --help              print this help\n";
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,78 @@
+#ifndef INCLUDED_OPTIONS_HH
+#define INCLUDED_OPTIONS_HH 1
+
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Format.hh"
+#include "Generator.hh"
+#include "Solver.hh"
+
+
+enum class Mode {
+    SOLVE, BATCH, SERVER, GENERATE, RATE, BENCHMARK, VALIDATE, VERIFY, COUNT,
+    DECODE,
+};
+
+struct Options {
+    Mode mode = Mode::SOLVE;
+    BoardFormat format = BoardFormat::GRID;
+    std::size_t threads = 0;
+    std::size_t nodeLimit = SearchBudget::unlimited;
+    SearchOptions search;
+    std::size_t cacheSize = 0;
+    std::size_t tableSize = 0;
+    /** The number of search configurations raced per problem, if not 0. */
+    std::size_t portfolio = 0;
+    std::string checkpointPath;
+    /** If true, all solutions are printed as a packed stream. */
+    bool packed = false;
+    std::string socketPath;
+    /**
+     * The number of problems at the start of a batch on which the search
+     * configuration is tuned before solving, if not 0.
+     */
+    std::size_t autoTune = 0;
+    /** A profile saved by an earlier tuning to apply, if not empty. */
+    std::string loadProfilePath;
+    /** Where to save the profile chosen by tuning, if not empty. */
+    std::string saveProfilePath;
+    std::size_t generateCount = 0;
+    std::uint64_t seed = 0;
+    GeneratorOptions generator;
+    /**
+     * If true, the files are outputs of the shards of one run to be combined
+     * instead of problems to be solved.
+     */
+    bool merge = false;
+    std::vector<std::string> files;
+    /** If true, events and time are measured per phase and printed. */
+    bool stats = false;
+    /** If true, latency quantiles are printed at the end of a batch. */
+    bool latency = false;
+    /** Where to dump the metrics of a batch or server, if not empty. */
+    std::string metricsPath;
+    /** Where to serve dumps of the metrics, if not empty. */
+    std::string metricsSocketPath;
+    /** The seconds between dumps to metricsPath. */
+    std::size_t metricsInterval = 10;
+    bool help = false;
+};
+
+/**
+ * Parses the command line arguments. Throws std::invalid_argument for an
+ * unknown option, a malformed option value, a file argument without
+ * --merge, --save-profile without --auto-tune, or --packed with
+ * --checkpoint.
+ */
+extern void parseOptions(int argc, char *const *argv, Options &options);
+
+extern void printUsage(std::ostream &os);
+
+
+#endif // #ifndef INCLUDED_OPTIONS_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include "PerfCounters.hh"
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using std::size_t;
+using std::uint64_t;
+
+
+static const char *const perfEventNames[] = {
+    "cycles", "instructions", "l1d-misses", "llc-misses", "branch-misses",
+};
+
+const char *perfEventName(PerfEvent event) noexcept {
+    return perfEventNames[static_cast<size_t>(event)];
+}
+
+PerfSample &PerfSample::operator+=(const PerfSample &other) noexcept {
+    for (size_t i = 0; i < perfEventCount; i++)
+        counts[i] += other.counts[i];
+    available |= other.available;
+    return *this;
+}
+
+PerfSample operator-(const PerfSample &to, const PerfSample &from) noexcept {
+    PerfSample difference;
+    difference.available = to.available;
+    for (size_t i = 0; i < perfEventCount; i++)
+        difference.counts[i] = to.counts[i] - from.counts[i];
+    return difference;
+}
+
+std::ostream &operator<<(std::ostream &os, const PerfSample &sample) {
+    for (size_t i = 0; i < perfEventCount; i++)
+        if (sample.available[i])
+            os << ' ' << perfEventNames[i] << '=' << sample.counts[i];
+    return os;
+}
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+
+static void describe(PerfEvent event, perf_event_attr &attr) noexcept {
+    auto cache = [&attr](uint64_t id, uint64_t result) {
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = id | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (result << 16);
+    };
+
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+    case PerfEvent::CYCLES:
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PerfEvent::INSTRUCTIONS:
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PerfEvent::L1D_MISSES:
+        cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS);
+        break;
+    case PerfEvent::LLC_MISSES:
+        cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS);
+        break;
+    case PerfEvent::BRANCH_MISSES:
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+PerfCounters::PerfCounters() {
+    mFiles.fill(-1);
+    for (size_t i = 0; i < perfEventCount; i++) {
+        PerfEvent event = static_cast<PerfEvent>(i);
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        describe(event, attr);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+
+        // The first event that opens leads the group, so that one read gets
+        // all counts at once.
+        long file = syscall(SYS_perf_event_open, &attr, 0, -1, mGroup, 0);
+        if (file < 0)
+            continue;
+        mFiles[i] = static_cast<int>(file);
+        if (mGroup < 0)
+            mGroup = mFiles[i];
+        mOrder[mOpen++] = event;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int file : mFiles)
+        if (file >= 0)
+            close(file);
+}
+
+PerfSample PerfCounters::read() const noexcept {
+    PerfSample sample;
+    if (mGroup < 0)
+        return sample;
+
+    uint64_t values[1 + perfEventCount];
+    ssize_t size = ::read(mGroup, values, sizeof values);
+    if (size < static_cast<ssize_t>(sizeof *values * (1 + mOpen)) ||
+            values[0] != mOpen)
+        return sample;
+    for (size_t k = 0; k < mOpen; k++) {
+        size_t i = static_cast<size_t>(mOrder[k]);
+        sample.counts[i] = values[1 + k];
+        sample.available[i] = true;
+    }
+    return sample;
+}
+
+#else // #ifdef HAVE_LINUX_PERF_EVENT_H
+
+PerfCounters::PerfCounters() {
+    mFiles.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+PerfSample PerfCounters::read() const noexcept {
+    return PerfSample();
+}
+
+#endif // #ifdef HAVE_LINUX_PERF_EVENT_H
+
+static const char *const phaseNames[] = {
+    "parse", "convert", "propagate", "search", "output",
+};
+
+const char *phaseName(Phase phase) noexcept {
+    return phaseNames[static_cast<size_t>(phase)];
+}
+
+PhaseStats::PhaseStats() {
+    // Time consecutive readings, as taken by consecutive phase changes.
+    constexpr size_t rounds = 33;
+    std::array<Clock::duration, rounds> times;
+    std::array<std::array<uint64_t, rounds>, perfEventCount> counts;
+    PerfSample last = mCounters.read();
+    Clock::time_point lastTime = Clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        PerfSample sample = mCounters.read();
+        Clock::time_point now = Clock::now();
+        times[r] = now - lastTime;
+        for (size_t i = 0; i < perfEventCount; i++)
+            counts[i][r] = sample.counts[i] - last.counts[i];
+        last = sample;
+        lastTime = now;
+    }
+
+    std::nth_element(times.begin(), times.begin() + rounds / 2, times.end());
+    mOverheadTime = times[rounds / 2];
+    for (size_t i = 0; i < perfEventCount; i++) {
+        std::nth_element(counts[i].begin(), counts[i].begin() + rounds / 2,
+                counts[i].end());
+        mOverheadSample.counts[i] = counts[i][rounds / 2];
+    }
+    mOverheadSample.available = last.available;
+}
+
+void PhaseStats::enter(Phase phase) noexcept {
+    PerfSample sample = mCounters.read();
+    Clock::time_point now = Clock::now();
+    if (mRunning) {
+        size_t i = static_cast<size_t>(mPhase);
+        PerfSample difference = sample - mLastSample;
+        for (size_t k = 0; k < perfEventCount; k++)
+            difference.counts[k] -= std::min(
+                    difference.counts[k], mOverheadSample.counts[k]);
+        mSamples[i] += difference;
+        Clock::duration time = now - mLastTime;
+        mTimes[i] += time - std::min(time, mOverheadTime);
+    }
+    mPhase = phase;
+    mRunning = true;
+    mLastSample = sample;
+    mLastTime = now;
+}
+
+void PhaseStats::stop() noexcept {
+    enter(mPhase);
+    mRunning = false;
+}
+
+PerfSample PhaseStats::totalSample() const noexcept {
+    PerfSample total;
+    for (const PerfSample &sample : mSamples)
+        total += sample;
+    return total;
+}
+
+PhaseStats::Clock::duration PhaseStats::totalTime() const noexcept {
+    Clock::duration total{0};
+    for (Clock::duration time : mTimes)
+        total += time;
+    return total;
+}
+
+std::function<void(SearchPhase phase)> PhaseStats::searchPhaseCallback() {
+    return [this](SearchPhase phase) {
+        switch (phase) {
+        case SearchPhase::CONVERT:
+            enter(Phase::CONVERT);
+            break;
+        case SearchPhase::PROPAGATE:
+            enter(Phase::PROPAGATE);
+            break;
+        case SearchPhase::SEARCH:
+            enter(Phase::SEARCH);
+            break;
+        }
+    };
+}
+
+static void printLine(
+        std::ostream &os,
+        const char *name,
+        PhaseStats::Clock::duration time,
+        const PerfSample &sample) {
+    os << std::left << std::setw(10) << name << std::right <<
+            std::fixed << std::setprecision(6) << " time=" <<
+            std::chrono::duration<double>(time).count() << 's' <<
+            sample << '\n';
+}
+
+std::ostream &operator<<(std::ostream &os, const PhaseStats &stats) {
+    std::ios::fmtflags flags = os.flags();
+    for (size_t i = 0; i < phaseCount; i++) {
+        Phase phase = static_cast<Phase>(i);
+        printLine(os, phaseName(phase), stats.time(phase),
+                stats.sample(phase));
+    }
+    printLine(os, "total", stats.totalTime(), stats.totalSample());
+    os.flags(flags);
+    return os;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
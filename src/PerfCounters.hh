@@ -0,0 +1,165 @@
+#ifndef INCLUDED_PERFCOUNTERS_HH
+#define INCLUDED_PERFCOUNTERS_HH 1
+
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include "Solver.hh"
+
+
+/** The hardware events counted by PerfCounters. */
+enum class PerfEvent {
+    CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES,
+};
+
+constexpr std::size_t perfEventCount = 5;
+
+extern const char *perfEventName(PerfEvent event) noexcept;
+
+/** Counts of the events, some of which may not have been counted. */
+struct PerfSample {
+    std::array<std::uint64_t, perfEventCount> counts{};
+    std::bitset<perfEventCount> available;
+
+    std::uint64_t operator[](PerfEvent event) const noexcept {
+        return counts[static_cast<std::size_t>(event)];
+    }
+
+    /** Adds the counts. An event is available in either sample. */
+    PerfSample &operator+=(const PerfSample &other) noexcept;
+};
+
+/** Returns the counts from "from" to "to", with the events of "to". */
+extern PerfSample operator-(const PerfSample &to, const PerfSample &from)
+        noexcept;
+
+/**
+ * Prints " name=count" for every available event, or nothing if none is
+ * available.
+ */
+extern std::ostream &operator<<(std::ostream &os, const PerfSample &sample);
+
+/**
+ * Counters of the hardware events of the calling thread in user space, read
+ * with Linux perf_event_open. An event the kernel or the processor does not
+ * support, or that the system does not allow to count, is not available, and
+ * none is available where perf_event_open is not.
+ */
+class PerfCounters {
+
+private:
+
+    /** The group leader, or -1 if no event is available. */
+    int mGroup = -1;
+    std::array<int, perfEventCount> mFiles;
+    /** The events in the order of the values read from the group. */
+    std::array<PerfEvent, perfEventCount> mOrder;
+    std::size_t mOpen = 0;
+
+public:
+
+    PerfCounters();
+    PerfCounters(const PerfCounters &counters) = delete;
+    ~PerfCounters();
+    PerfCounters &operator=(const PerfCounters &counters) = delete;
+
+    bool isAvailable() const noexcept {
+        return mOpen > 0;
+    }
+
+    /** Reads the counts since the counters were opened. */
+    PerfSample read() const noexcept;
+
+};
+
+/** The phases of solving a problem that PhaseStats tells apart. */
+enum class Phase {
+    PARSE, CONVERT, PROPAGATE, SEARCH, OUTPUT,
+};
+
+constexpr std::size_t phaseCount = 5;
+
+extern const char *phaseName(Phase phase) noexcept;
+
+/**
+ * Accounts the events and the time of the calling thread to the phase it is
+ * in. Phases are entered explicitly, and a search reports its own phases
+ * through the callback returned by searchPhaseCallback, twice for every
+ * board. Reading the counters takes a system call, which would make short
+ * phases look much longer than they are, so what a phase change costs is
+ * measured when the stats are created and taken off every phase.
+ */
+class PhaseStats {
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+private:
+
+    PerfCounters mCounters;
+    std::array<PerfSample, phaseCount> mSamples;
+    std::array<Clock::duration, phaseCount> mTimes{};
+    Phase mPhase = Phase::PARSE;
+    bool mRunning = false;
+    PerfSample mLastSample;
+    Clock::time_point mLastTime;
+    /** The median cost of a phase change. */
+    PerfSample mOverheadSample;
+    Clock::duration mOverheadTime{0};
+
+public:
+
+    PhaseStats();
+
+    const PerfCounters &counters() const noexcept {
+        return mCounters;
+    }
+
+    /**
+     * Charges the events and the time since the last phase change, less
+     * the overhead, to the current phase, if any, and starts counting for
+     * the given one.
+     */
+    void enter(Phase phase) noexcept;
+
+    /** Charges the current phase, if any, and stops counting. */
+    void stop() noexcept;
+
+    const PerfSample &sample(Phase phase) const noexcept {
+        return mSamples[static_cast<std::size_t>(phase)];
+    }
+
+    Clock::duration time(Phase phase) const noexcept {
+        return mTimes[static_cast<std::size_t>(phase)];
+    }
+
+    /** The time a phase change takes off the phase it charges. */
+    Clock::duration overhead() const noexcept {
+        return mOverheadTime;
+    }
+
+    /** The sum of all phases. */
+    PerfSample totalSample() const noexcept;
+    Clock::duration totalTime() const noexcept;
+
+    /** Returns a callback for SearchOptions::enterPhase. */
+    std::function<void(SearchPhase phase)> searchPhaseCallback();
+
+};
+
+/**
+ * Prints one line for each phase and one for the total, each with the time
+ * and the available event counts.
+ */
+extern std::ostream &operator<<(std::ostream &os, const PhaseStats &stats);
+
+
+#endif // #ifndef INCLUDED_PERFCOUNTERS_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
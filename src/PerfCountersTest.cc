@@ -0,0 +1,104 @@
+#include <sstream>
+#include <string>
+#include "PerfCounters.hh"
+#include "Tester.inl"
+
+using std::ostringstream;
+using std::string;
+
+
+/** Does some work that the compiler cannot leave out. */
+static void work() {
+    volatile std::uint64_t x = 1;
+    for (int i = 0; i < 100000; i++)
+        x = x * 3 + 1;
+}
+
+static void testSample() {
+    PerfSample a, b;
+    a.counts[0] = 10;
+    a.counts[4] = 3;
+    a.available[0] = a.available[4] = true;
+    b.counts[0] = 4;
+    b.available[0] = true;
+
+    PerfSample difference = a - b;
+    test_assert(difference[PerfEvent::CYCLES] == 6);
+    test_assert(difference[PerfEvent::BRANCH_MISSES] == 3);
+    test_assert(difference.available == a.available);
+
+    ostringstream os;
+    os << difference;
+    test_assert(os.str() == " cycles=6 branch-misses=3");
+    os.str("");
+    os << PerfSample();
+    test_assert(os.str().empty());
+
+    b += a;
+    test_assert(b[PerfEvent::CYCLES] == 14);
+    test_assert(b.available == a.available);
+}
+
+static void testCounters() {
+    PerfCounters counters;
+    PerfSample before = counters.read();
+    work();
+    PerfSample after = counters.read();
+
+    // Whether any event can be counted depends on the machine.
+    test_assert(before.available == after.available);
+    test_assert(after.available.any() == counters.isAvailable());
+    for (std::size_t i = 0; i < perfEventCount; i++)
+        test_assert(after.counts[i] >= before.counts[i]);
+    if (after.available[static_cast<std::size_t>(PerfEvent::INSTRUCTIONS)])
+        test_assert((after - before)[PerfEvent::INSTRUCTIONS] >= 100000);
+}
+
+static void testPhases() {
+    PhaseStats stats;
+    stats.enter(Phase::PARSE);
+    work();
+    auto enterPhase = stats.searchPhaseCallback();
+    enterPhase(SearchPhase::PROPAGATE);
+    work();
+    enterPhase(SearchPhase::SEARCH);
+    stats.stop();
+    work();
+
+    test_assert(stats.time(Phase::PARSE).count() > 0);
+    test_assert(stats.time(Phase::PROPAGATE).count() > 0);
+    test_assert(stats.time(Phase::CONVERT).count() == 0);
+    test_assert(stats.totalTime() ==
+            stats.time(Phase::PARSE) + stats.time(Phase::PROPAGATE) +
+            stats.time(Phase::SEARCH));
+
+    ostringstream os;
+    os << stats;
+    string text = os.str();
+    test_assert(text.compare(0, 16, "parse      time=") == 0);
+    test_assert(text.find("\npropagate  time=") != string::npos);
+    test_assert(text.find("\ntotal      time=") != string::npos);
+
+    // Phases as short as a phase change are charged less than they took.
+    PhaseStats empty;
+    PhaseStats::Clock::time_point start = PhaseStats::Clock::now();
+    for (int i = 0; i < 100; i++)
+        empty.enter(Phase::PROPAGATE);
+    empty.stop();
+    PhaseStats::Clock::duration elapsed = PhaseStats::Clock::now() - start;
+    test_assert(empty.totalTime() + 20 * empty.overhead() <= elapsed);
+}
+
+static void testAll() {
+    testSample();
+    testCounters();
+    testPhases();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "Portfolio.hh"
+
+using std::size_t;
+using std::vector;
+
+
+namespace {
+
+/** The state shared by the configurations solving one problem. */
+struct Race {
+    Board<Number> problem;
+    SearchBudget budget;
+    std::atomic<bool> cancelled;
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t running;
+    bool decided = false;
+    PortfolioResult result;
+    Board<Number> solution;
+
+    Race(const Board<Number> &p, const SearchBudget &b, size_t configs) :
+            problem(p), budget(b), cancelled(false), running(configs) { }
+};
+
+} // namespace
+
+static void runConfig(
+        Race &race, const SearchOptions &config, size_t index) noexcept {
+    Board<Number> solution;
+    SolveResult result = SolveResult::ABORTED;
+    SearchBudget budget = race.budget;
+    budget.setCancelFlag(race.cancelled);
+    if (!race.cancelled)
+        result = solve(race.problem, solution, budget, config);
+
+    std::lock_guard<std::mutex> lock(race.mutex);
+    race.running--;
+    if (!race.decided && result != SolveResult::ABORTED) {
+        race.decided = true;
+        race.result.result = result;
+        race.result.winner = index;
+        race.result.nodes = budget.nodes();
+        race.solution = solution;
+        race.cancelled = true;
+    }
+    race.condition.notify_all();
+}
+
+Portfolio::Portfolio(vector<SearchOptions> configs) :
+        mConfigs(std::move(configs)), mPool(mConfigs.size() - 1) {
+    for (SearchOptions &config : mConfigs)
+        config.table = nullptr;
+}
+
+PortfolioResult Portfolio::solve(
+        const Board<Number> &problem,
+        Board<Number> &solution,
+        const SearchBudget &budget) {
+    std::shared_ptr<Race> race =
+            std::make_shared<Race>(problem, budget, mConfigs.size());
+    for (size_t index = 1; index < mConfigs.size(); index++) {
+        const SearchOptions &config = mConfigs[index];
+        mPool.submit([race, &config, index] {
+            runConfig(*race, config, index);
+        });
+    }
+    runConfig(*race, mConfigs[0], 0);
+
+    std::unique_lock<std::mutex> lock(race->mutex);
+    race->condition.wait(lock, [&race] {
+        return race->decided || race->running == 0;
+    });
+    if (race->decided)
+        solution = race->solution;
+    return race->result;
+}
+
+vector<SearchOptions> defaultPortfolio(
+        size_t count, const SearchOptions &base) {
+    TieBreak otherTieBreak = base.tieBreak == TieBreak::FIRST ?
+            TieBreak::DEGREE : TieBreak::FIRST;
+    ValueOrder otherOrder = base.valueOrder == ValueOrder::ASCENDING ?
+            ValueOrder::DESCENDING : ValueOrder::ASCENDING;
+    Backend otherBackend = base.backend == Backend::CELLS ?
+            Backend::BITBOARD : Backend::CELLS;
+
+    vector<SearchOptions> configs;
+    for (TieBreak tieBreak : {base.tieBreak, otherTieBreak}) {
+        for (ValueOrder order : {base.valueOrder, otherOrder}) {
+            if (configs.size() >= count)
+                return configs;
+            SearchOptions config = base;
+            config.tieBreak = tieBreak;
+            config.valueOrder = order;
+            configs.push_back(config);
+        }
+    }
+
+    for (std::uint64_t k = 1; configs.size() < count; k++) {
+        SearchOptions config = base;
+        config.backend = k % 2 == 0 ? base.backend : otherBackend;
+        config.tieBreak = TieBreak::RANDOM;
+        config.valueOrder = ValueOrder::RANDOM;
+        config.seed = base.seed + k;
+        if (config.restartUnit == 0)
+            config.restartUnit = portfolioRestartUnit;
+        configs.push_back(config);
+    }
+    return configs;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,80 @@
+#ifndef INCLUDED_PORTFOLIO_HH
+#define INCLUDED_PORTFOLIO_HH 1
+
+
+#include <cstddef>
+#include <vector>
+#include "Board.hh"
+#include "Solver.hh"
+#include "ThreadPool.hh"
+
+
+struct PortfolioResult {
+    SolveResult result = SolveResult::ABORTED;
+    /** The index of the configuration that decided the result. */
+    std::size_t winner = 0;
+    /** The search nodes of the winner. */
+    std::size_t nodes = 0;
+};
+
+/**
+ * Solves a problem by racing several search configurations against each
+ * other. The first configuration to reach a result other than ABORTED
+ * decides it, and the others are cancelled through their budgets.
+ *
+ * The first configuration runs in the calling thread and the others in a
+ * thread pool of the portfolio's own, so a portfolio of K configurations
+ * uses K threads. Concurrent calls share the pool.
+ *
+ * Since the configurations search in different orders, the solution of a
+ * problem with more than one solution depends on which one wins.
+ */
+class Portfolio {
+
+private:
+
+    std::vector<SearchOptions> mConfigs;
+    ThreadPool mPool;
+
+public:
+
+    /**
+     * The configurations must not be empty. Their transposition tables are
+     * not used since the configurations run concurrently.
+     */
+    explicit Portfolio(std::vector<SearchOptions> configs);
+    Portfolio(const Portfolio &portfolio) = delete;
+    Portfolio &operator=(const Portfolio &portfolio) = delete;
+
+    const std::vector<SearchOptions> &configs() const noexcept {
+        return mConfigs;
+    }
+
+    /**
+     * Solves the problem with every configuration, each with a copy of the
+     * budget, and returns the first conclusive result. The result is ABORTED
+     * only if every configuration ran out of its budget.
+     */
+    PortfolioResult solve(
+            const Board<Number> &problem,
+            Board<Number> &solution,
+            const SearchBudget &budget);
+
+};
+
+/** The restart unit of the randomized configurations of defaultPortfolio. */
+constexpr std::size_t portfolioRestartUnit = 256;
+
+/**
+ * Returns "count" distinct configurations based on the given options, the
+ * first of which is the options themselves. The next three vary the
+ * tie-break and the value order, and the rest use random orders with
+ * restarts, each with its own seed, alternating between the backends.
+ */
+extern std::vector<SearchOptions> defaultPortfolio(
+        std::size_t count, const SearchOptions &base);
+
+
+#endif // #ifndef INCLUDED_PORTFOLIO_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
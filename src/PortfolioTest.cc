@@ -0,0 +1,89 @@
+#include <vector>
+#include "Board.hh"
+#include "Format.hh"
+#include "Portfolio.hh"
+#include "Solver.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+static Board<Number> lineBoard(const char *line) {
+    Board<Number> board;
+    parseLine(line, board);
+    return board;
+}
+
+static void testDefaultPortfolio() {
+    SearchOptions base;
+    base.backend = Backend::BITBOARD;
+    base.valueOrder = ValueOrder::DESCENDING;
+
+    std::vector<SearchOptions> configs = defaultPortfolio(3, base);
+    test_assert(configs.size() == 3);
+    test_assert(configs[0].backend == Backend::BITBOARD);
+    test_assert(configs[0].valueOrder == ValueOrder::DESCENDING);
+    test_assert(configs[0].tieBreak == TieBreak::FIRST);
+    test_assert(configs[1].valueOrder == ValueOrder::ASCENDING);
+
+    configs = defaultPortfolio(20, base);
+    test_assert(configs.size() == 20);
+    test_assert(configs[3].tieBreak == TieBreak::DEGREE);
+    test_assert(configs[3].valueOrder == ValueOrder::ASCENDING);
+    test_assert(configs[4].backend == Backend::CELLS);
+    test_assert(configs[4].tieBreak == TieBreak::RANDOM);
+    test_assert(configs[4].restartUnit == portfolioRestartUnit);
+    test_assert(configs[5].backend == Backend::BITBOARD);
+    for (std::size_t a = 0; a < configs.size(); a++)
+        for (std::size_t b = 0; b < a; b++)
+            test_assert(configs[a].backend != configs[b].backend ||
+                    configs[a].valueOrder != configs[b].valueOrder ||
+                    configs[a].tieBreak != configs[b].tieBreak ||
+                    configs[a].seed != configs[b].seed);
+}
+
+static void testSolve(std::size_t count) {
+    Portfolio portfolio(defaultPortfolio(count, SearchOptions()));
+    test_assert(portfolio.configs().size() == count);
+
+    Board<Number> solution;
+    PortfolioResult result =
+            portfolio.solve(lineBoard(problemLine), solution, SearchBudget());
+    test_assert(result.result == SolveResult::UNIQUE);
+    test_assert(result.winner < count);
+    test_assert(solution == lineBoard(solutionLine));
+
+    Board<Number> emptyProblem;
+    for (Number i = 0; i < N; i++)
+        for (Number j = 0; j < N; j++)
+            emptyProblem[Position(i, j)] = N;
+    result = portfolio.solve(emptyProblem, solution, SearchBudget());
+    test_assert(result.result == SolveResult::MULTIPLE);
+    // A complete board is its own unique solution only if it is valid.
+    Board<Number> check;
+    SearchBudget budget;
+    test_assert(solve(solution, check, budget) == SolveResult::UNIQUE);
+
+    Board<Number> insolvable = lineBoard(problemLine);
+    insolvable[Position(0, 1)] = 0;
+    result = portfolio.solve(insolvable, solution, SearchBudget());
+    test_assert(result.result == SolveResult::INSOLVABLE);
+
+    // Every configuration runs out of the budget.
+    result = portfolio.solve(emptyProblem, solution, SearchBudget(1));
+    test_assert(result.result == SolveResult::ABORTED);
+}
+
+static void testAll() {
+    testDefaultPortfolio();
+    testSolve(1);
+    testSolve(4);
+    testSolve(7);
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,513 @@
+#include <algorithm>
+#include <bitset>
+#include <functional>
+#include <vector>
+#include "Rating.hh"
+#include "Solver.hh"
+
+using std::array;
+using std::size_t;
+using std::string;
+using std::vector;
+
+
+namespace {
+
+struct Unit {
+    Area area;
+    array<Position, N> positions;
+};
+
+/** A block and a row or column that share Nsub positions. */
+struct Intersection {
+    const Unit *block;
+    const Unit *line;
+};
+
+} // namespace
+
+/** Difficulty scores of the techniques in tenths. */
+static const unsigned techniqueScores[techniqueCount] = {
+    10, 12, 26, 30, 32, 34, 36, 38, 40, 50, 52, 54, 70,
+};
+
+static const char *const techniqueNames[techniqueCount] = {
+    "naked-single", "hidden-single", "locked-candidates",
+    "naked-pair", "x-wing", "hidden-pair",
+    "naked-triple", "swordfish", "hidden-triple",
+    "naked-quad", "jellyfish", "hidden-quad",
+    "guess",
+};
+
+static const char *const difficultyNames[] = {
+    "easy", "medium", "hard", "expert", "diabolical",
+};
+
+const char *techniqueName(Technique technique) noexcept {
+    return techniqueNames[static_cast<size_t>(technique)];
+}
+
+const char *difficultyName(Difficulty difficulty) noexcept {
+    return difficultyNames[static_cast<size_t>(difficulty)];
+}
+
+bool parseDifficulty(const string &name, Difficulty &difficulty) noexcept {
+    for (size_t i = 0; i < sizeof difficultyNames / sizeof *difficultyNames;
+            i++) {
+        if (name == difficultyNames[i]) {
+            difficulty = static_cast<Difficulty>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Rows first, then columns, then blocks. */
+static vector<Unit> makeUnits() {
+    vector<Unit> units;
+    auto addUnit = [&units](const Area &area) -> bool {
+        Unit unit;
+        unit.area = area;
+        size_t k = 0;
+        area.forAllPositions([&](Position pos) -> bool {
+            unit.positions[k++] = pos;
+            return true;
+        });
+        units.push_back(unit);
+        return true;
+    };
+
+    for (Number i = 0; i < N; i++)
+        addUnit(rowArea(i));
+    for (Number j = 0; j < N; j++)
+        addUnit(columnArea(j));
+    forAllBlockAreas(addUnit);
+    return units;
+}
+
+static const vector<Unit> &units() {
+    static const vector<Unit> allUnits = makeUnits();
+    return allUnits;
+}
+
+static vector<Intersection> makeIntersections() {
+    vector<Intersection> intersections;
+    const vector<Unit> &all = units();
+    for (size_t b = 2 * N; b < 3 * N; b++)
+        for (size_t l = 0; l < 2 * N; l++)
+            if (std::any_of(all[l].positions.begin(),
+                    all[l].positions.end(), [&](const Position &pos) {
+                        return all[b].area.contains(pos);
+                    }))
+                intersections.push_back(Intersection{&all[b], &all[l]});
+    return intersections;
+}
+
+static const vector<Intersection> &intersections() {
+    static const vector<Intersection> allIntersections = makeIntersections();
+    return allIntersections;
+}
+
+static size_t countBits(unsigned mask) {
+    return std::bitset<N>(mask).count();
+}
+
+/**
+ * Calls back with every combination of k of the given items until the
+ * callback returns true. Returns true if the callback did.
+ */
+static bool anyCombination(
+        const vector<Number> &items,
+        size_t k,
+        const std::function<bool(const vector<Number> &)> &callback) {
+    if (k == 0 || k > items.size())
+        return false;
+
+    vector<size_t> indices(k);
+    vector<Number> combination(k);
+    for (size_t i = 0; i < k; i++)
+        indices[i] = i;
+
+    for (;;) {
+        for (size_t i = 0; i < k; i++)
+            combination[i] = items[indices[i]];
+        if (callback(combination))
+            return true;
+
+        size_t i = k;
+        while (i > 0 && indices[i - 1] == items.size() - k + i - 1)
+            i--;
+        if (i == 0)
+            return false;
+        indices[i - 1]++;
+        for (size_t j = i; j < k; j++)
+            indices[j] = indices[j - 1] + 1;
+    }
+}
+
+static bool contains(const vector<Number> &items, Number item) {
+    return std::find(items.begin(), items.end(), item) != items.end();
+}
+
+static size_t countUnique(const Board<PossibilitySet> &board) {
+    size_t count = 0;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        if (board[pos].isUnique())
+            count++;
+        return true;
+    });
+    return count;
+}
+
+static size_t applyHiddenSingles(Board<PossibilitySet> &board) {
+    size_t before = countUnique(board);
+    fixUniquePossibilities(board);
+    return countUnique(board) - before;
+}
+
+/**
+ * If n can occur in "source" only where it intersects "target", removes n
+ * from the rest of "target".
+ */
+static bool lockCandidates(
+        Board<PossibilitySet> &board,
+        const Unit &source,
+        const Unit &target,
+        Number n) {
+    size_t count = 0;
+    for (const Position &pos : source.positions) {
+        if (!board[pos].contains(n))
+            continue;
+        if (!target.area.contains(pos))
+            return false;
+        count++;
+    }
+    if (count < 2)
+        return false;
+
+    bool eliminated = false;
+    for (const Position &pos : target.positions) {
+        if (!source.area.contains(pos) && board[pos].contains(n)) {
+            board[pos].remove(n);
+            eliminated = true;
+        }
+    }
+    return eliminated;
+}
+
+static size_t applyLockedCandidates(Board<PossibilitySet> &board) {
+    for (const Intersection &x : intersections())
+        for (Number n = 0; n < N; n++)
+            if (lockCandidates(board, *x.block, *x.line, n) ||
+                    lockCandidates(board, *x.line, *x.block, n))
+                return 1;
+    return 0;
+}
+
+/**
+ * Finds k positions in a unit whose possibilities together are only k
+ * numbers, and removes those numbers from the other positions of the unit.
+ */
+static size_t applyNakedSubset(Board<PossibilitySet> &board, size_t k) {
+    for (const Unit &unit : units()) {
+        vector<Number> cells;
+        size_t unsolved = 0;
+        for (Number c = 0; c < N; c++) {
+            size_t count = board[unit.positions[c]].count();
+            if (count > 1)
+                unsolved++;
+            if (count > 1 && count <= k)
+                cells.push_back(c);
+        }
+        if (unsolved <= k)
+            continue;
+
+        if (anyCombination(cells, k, [&](const vector<Number> &subset) {
+            PossibilitySet numbers;
+            for (Number c : subset)
+                numbers |= board[unit.positions[c]];
+            if (numbers.count() != k)
+                return false;
+
+            bool eliminated = false;
+            for (Number c = 0; c < N; c++) {
+                PossibilitySet &pset = board[unit.positions[c]];
+                if (!contains(subset, c) && pset.count() > 1 &&
+                        !(pset & numbers).isEmpty()) {
+                    pset -= numbers;
+                    eliminated = true;
+                }
+            }
+            return eliminated;
+        }))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * Finds k numbers that can occur at only k positions in a unit, and removes
+ * the other numbers from those positions.
+ */
+static size_t applyHiddenSubset(Board<PossibilitySet> &board, size_t k) {
+    for (const Unit &unit : units()) {
+        array<unsigned, N> places;
+        places.fill(0);
+        size_t unsolved = 0;
+        for (Number c = 0; c < N; c++) {
+            const PossibilitySet &pset = board[unit.positions[c]];
+            if (pset.count() > 1)
+                unsolved++;
+            pset.forAllPossibleNumbers([&](Number n) -> bool {
+                places[n] |= 1u << c;
+                return true;
+            });
+        }
+        if (unsolved <= k)
+            continue;
+
+        vector<Number> numbers;
+        for (Number n = 0; n < N; n++)
+            if (2 <= countBits(places[n]) && countBits(places[n]) <= k)
+                numbers.push_back(n);
+
+        if (anyCombination(numbers, k, [&](const vector<Number> &subset) {
+            unsigned mask = 0;
+            PossibilitySet subsetNumbers;
+            for (Number n : subset) {
+                mask |= places[n];
+                subsetNumbers.add(n);
+            }
+            if (countBits(mask) != k)
+                return false;
+
+            bool eliminated = false;
+            for (Number c = 0; c < N; c++) {
+                PossibilitySet &pset = board[unit.positions[c]];
+                if ((mask & (1u << c)) && !(pset - subsetNumbers).isEmpty()) {
+                    pset &= subsetNumbers;
+                    eliminated = true;
+                }
+            }
+            return eliminated;
+        }))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * Finds k rows (or columns) in which a number can occur only in the same k
+ * columns (or rows), and removes the number from the rest of those columns
+ * (or rows).
+ */
+static size_t applyFish(Board<PossibilitySet> &board, size_t k) {
+    for (int transposed = 0; transposed < 2; transposed++) {
+        auto position = [transposed](Number base, Number cover) {
+            return transposed ? Position(cover, base) : Position(base, cover);
+        };
+
+        for (Number n = 0; n < N; n++) {
+            array<unsigned, N> places;
+            places.fill(0);
+            for (Number base = 0; base < N; base++)
+                for (Number cover = 0; cover < N; cover++)
+                    if (board[position(base, cover)].contains(n))
+                        places[base] |= 1u << cover;
+
+            vector<Number> bases;
+            for (Number base = 0; base < N; base++)
+                if (2 <= countBits(places[base]) &&
+                        countBits(places[base]) <= k)
+                    bases.push_back(base);
+
+            if (anyCombination(bases, k, [&](const vector<Number> &subset) {
+                unsigned mask = 0;
+                for (Number base : subset)
+                    mask |= places[base];
+                if (countBits(mask) != k)
+                    return false;
+
+                bool eliminated = false;
+                for (Number base = 0; base < N; base++) {
+                    if (contains(subset, base) || !(places[base] & mask))
+                        continue;
+                    for (Number cover = 0; cover < N; cover++) {
+                        if (mask & places[base] & (1u << cover)) {
+                            board[position(base, cover)].remove(n);
+                            eliminated = true;
+                        }
+                    }
+                }
+                return eliminated;
+            }))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static size_t applyNakedSingles(Board<PossibilitySet> &board) {
+    size_t before = countUnique(board);
+    eliminateImpossibilities(board);
+    size_t after = countUnique(board);
+    return after > before ? after - before : 0;
+}
+
+size_t applyTechnique(Technique technique, Board<PossibilitySet> &board) {
+    switch (technique) {
+    case Technique::NAKED_SINGLE:
+        return applyNakedSingles(board);
+    case Technique::HIDDEN_SINGLE:
+        return applyHiddenSingles(board);
+    case Technique::LOCKED_CANDIDATES:
+        return applyLockedCandidates(board);
+    case Technique::NAKED_PAIR:
+        return applyNakedSubset(board, 2);
+    case Technique::X_WING:
+        return applyFish(board, 2);
+    case Technique::HIDDEN_PAIR:
+        return applyHiddenSubset(board, 2);
+    case Technique::NAKED_TRIPLE:
+        return applyNakedSubset(board, 3);
+    case Technique::SWORDFISH:
+        return applyFish(board, 3);
+    case Technique::HIDDEN_TRIPLE:
+        return applyHiddenSubset(board, 3);
+    case Technique::NAKED_QUAD:
+        return applyNakedSubset(board, 4);
+    case Technique::JELLYFISH:
+        return applyFish(board, 4);
+    case Technique::HIDDEN_QUAD:
+        return applyHiddenSubset(board, 4);
+    case Technique::GUESS:
+        break;
+    }
+    return 0;
+}
+
+/**
+ * Completes a stalled board by backtracking. Returns true if a solution was
+ * found, in which case "solutionDepth" is the number of nested guesses that
+ * led to it. "guesses" counts all guesses made.
+ */
+static bool guess(
+        const Board<PossibilitySet> &board,
+        size_t depth,
+        size_t &solutionDepth,
+        size_t &guesses) {
+    Position pos = findPositionWithLeastPossibilities(board);
+    bool found = false;
+    board[pos].forAllPossibleNumbers([&](Number n) -> bool {
+        guesses++;
+        Board<PossibilitySet> nextBoard = board;
+        nextBoard[pos] = PossibilitySet(n);
+        repeatNonAssumptionProcess(nextBoard);
+
+        switch (classify(nextBoard)) {
+        case BoardState::SOLVED:
+            solutionDepth = depth + 1;
+            found = true;
+            break;
+        case BoardState::INSOLVABLE:
+            break;
+        case BoardState::UNSOLVED:
+            found = guess(nextBoard, depth + 1, solutionDepth, guesses);
+            break;
+        }
+        return !found;
+    });
+    return found;
+}
+
+static void record(Rating &rating, Technique technique, size_t steps) {
+    rating.steps[static_cast<size_t>(technique)] += steps;
+    rating.hardest = std::max(rating.hardest, technique);
+}
+
+static void finish(Rating &rating) {
+    if (!rating.solvable)
+        return;
+
+    rating.score = techniqueScores[static_cast<size_t>(rating.hardest)];
+    if (rating.hardest == Technique::GUESS)
+        rating.score += 5 * rating.guessDepth;
+
+    if (rating.hardest <= Technique::HIDDEN_SINGLE)
+        rating.difficulty = Difficulty::EASY;
+    else if (rating.hardest <= Technique::HIDDEN_PAIR)
+        rating.difficulty = Difficulty::MEDIUM;
+    else if (rating.hardest <= Technique::HIDDEN_TRIPLE)
+        rating.difficulty = Difficulty::HARD;
+    else if (rating.hardest <= Technique::HIDDEN_QUAD)
+        rating.difficulty = Difficulty::EXPERT;
+    else
+        rating.difficulty = Difficulty::DIABOLICAL;
+}
+
+Rating rate(const Board<Number> &problem) {
+    Rating rating;
+    Board<PossibilitySet> board, oldBoard;
+    convert(problem, board);
+
+    for (;;) {
+        // Eliminating the numbers of solved positions from their peers is
+        // bookkeeping; only the positions it solves count as steps.
+        oldBoard = board;
+        size_t nakedSingles = applyNakedSingles(board);
+        if (nakedSingles > 0)
+            record(rating, Technique::NAKED_SINGLE, nakedSingles);
+
+        switch (classify(board)) {
+        case BoardState::INSOLVABLE:
+            return rating;
+        case BoardState::SOLVED:
+            rating.solvable = true;
+            finish(rating);
+            return rating;
+        case BoardState::UNSOLVED:
+            break;
+        }
+        if (board != oldBoard)
+            continue;
+
+        bool progress = false;
+        for (size_t t = static_cast<size_t>(Technique::HIDDEN_SINGLE);
+                t < static_cast<size_t>(Technique::GUESS); t++) {
+            Technique technique = static_cast<Technique>(t);
+            size_t steps = applyTechnique(technique, board);
+            if (steps > 0) {
+                record(rating, technique, steps);
+                progress = true;
+                break;
+            }
+        }
+        if (progress)
+            continue;
+
+        size_t guesses = 0;
+        rating.solvable = guess(board, 0, rating.guessDepth, guesses);
+        if (rating.solvable)
+            record(rating, Technique::GUESS, guesses);
+        finish(rating);
+        return rating;
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, const Rating &rating) {
+    if (!rating.solvable)
+        return os << "0.0 insolvable";
+
+    os << rating.score / 10 << '.' << rating.score % 10 << ' ' <<
+            difficultyName(rating.difficulty) << ' ' <<
+            techniqueName(rating.hardest);
+    if (rating.guessDepth > 0)
+        os << " depth=" << rating.guessDepth;
+    for (size_t t = 0; t < techniqueCount; t++)
+        if (rating.steps[t] > 0)
+            os << ' ' << techniqueNames[t] << '=' << rating.steps[t];
+    return os;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,81 @@
+#ifndef INCLUDED_RATING_HH
+#define INCLUDED_RATING_HH 1
+
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "Board.hh"
+
+
+/** Solving techniques in the order of increasing difficulty. */
+enum class Technique {
+    NAKED_SINGLE, HIDDEN_SINGLE, LOCKED_CANDIDATES,
+    NAKED_PAIR, X_WING, HIDDEN_PAIR,
+    NAKED_TRIPLE, SWORDFISH, HIDDEN_TRIPLE,
+    NAKED_QUAD, JELLYFISH, HIDDEN_QUAD,
+    GUESS,
+};
+
+static constexpr std::size_t techniqueCount =
+        static_cast<std::size_t>(Technique::GUESS) + 1;
+
+enum class Difficulty {
+    EASY, MEDIUM, HARD, EXPERT, DIABOLICAL,
+};
+
+struct Rating {
+    /** False if the problem turned out to have no solution. */
+    bool solvable = false;
+    /** The most difficult technique that was needed. */
+    Technique hardest = Technique::NAKED_SINGLE;
+    /** How many times each technique was applied. */
+    std::array<std::size_t, techniqueCount> steps;
+    /**
+     * The depth of the backtracking search that completed the solution
+     * after the techniques stalled, or zero if no guess was needed.
+     */
+    std::size_t guessDepth = 0;
+    /** The difficulty score in tenths. */
+    unsigned score = 0;
+    Difficulty difficulty = Difficulty::EASY;
+
+    Rating() noexcept { steps.fill(0); }
+};
+
+extern const char *techniqueName(Technique technique) noexcept;
+
+extern const char *difficultyName(Difficulty difficulty) noexcept;
+
+extern bool parseDifficulty(const std::string &name, Difficulty &difficulty)
+        noexcept;
+
+/**
+ * Makes one step of the technique on the board. Returns the number of
+ * positions solved by singles, or 1 for one elimination step of the other
+ * techniques. Returns zero if the technique does not apply. Naked singles are
+ * found by eliminating the numbers of solved positions from their peers, and
+ * GUESS never applies.
+ */
+extern std::size_t applyTechnique(
+        Technique technique,
+        Board<PossibilitySet> &board);
+
+/**
+ * Rates the problem by solving it with logical techniques only, always
+ * trying the easiest technique that makes progress, and falling back to
+ * backtracking when no technique applies.
+ */
+extern Rating rate(const Board<Number> &problem);
+
+/**
+ * Prints the rating on one line: the score, the difficulty, the hardest
+ * technique and the number of steps of each technique that was used.
+ */
+extern std::ostream &operator<<(std::ostream &os, const Rating &rating);
+
+
+#endif // #ifndef INCLUDED_RATING_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
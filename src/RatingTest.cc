@@ -0,0 +1,135 @@
+#include <sstream>
+#include <string>
+#include "Format.hh"
+#include "Rating.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+using std::ostringstream;
+using std::string;
+
+
+static Board<Number> lineBoard(const string &line) {
+    Board<Number> board;
+    parseLine(line, board);
+    return board;
+}
+
+static Board<PossibilitySet> fullBoard() {
+    Board<PossibilitySet> board;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board[pos] = PossibilitySet::full();
+        return true;
+    });
+    return board;
+}
+
+static void testParseDifficulty() {
+    Difficulty difficulty = Difficulty::EASY;
+    test_assert(parseDifficulty("expert", difficulty));
+    test_assert(difficulty == Difficulty::EXPERT);
+    test_assert(!parseDifficulty("trivial", difficulty));
+    test_assert(difficulty == Difficulty::EXPERT);
+    test_assert(string(difficultyName(Difficulty::HARD)) == "hard");
+    test_assert(string(techniqueName(Technique::X_WING)) == "x-wing");
+}
+
+static void testLockedCandidates() {
+    Board<PossibilitySet> board = fullBoard();
+    const Number n = 5;
+    for (Number i = 1; i < Nsub; i++)
+        for (Number j = 0; j < Nsub; j++)
+            board[Position(i, j)].remove(n);
+
+    test_assert(applyTechnique(Technique::LOCKED_CANDIDATES, board) == 1);
+    for (Number j = 0; j < N; j++)
+        test_assert(board[Position(0, j)].contains(n) == (j < Nsub));
+    test_assert(board[Position(3, 0)].contains(n));
+}
+
+static void testNakedPair() {
+    Board<PossibilitySet> board = fullBoard();
+    const PossibilitySet pair = PossibilitySet(1).add(2);
+    board[Position(0, 0)] = board[Position(0, 4)] = pair;
+
+    test_assert(applyTechnique(Technique::LOCKED_CANDIDATES, board) == 0);
+    test_assert(applyTechnique(Technique::NAKED_PAIR, board) == 1);
+    for (Number j = 0; j < N; j++) {
+        const PossibilitySet &pset = board[Position(0, j)];
+        if (j == 0 || j == 4)
+            test_assert(pset == pair);
+        else
+            test_assert(pset == PossibilitySet::full() - pair);
+    }
+    test_assert(board[Position(1, 0)] == PossibilitySet::full());
+}
+
+static void testHiddenPair() {
+    Board<PossibilitySet> board = fullBoard();
+    const PossibilitySet pair = PossibilitySet(3).add(4);
+    for (Number j = 0; j < N; j++)
+        if (j != 2 && j != 6)
+            board[Position(5, j)] -= pair;
+
+    test_assert(applyTechnique(Technique::HIDDEN_PAIR, board) == 1);
+    test_assert(board[Position(5, 2)] == pair);
+    test_assert(board[Position(5, 6)] == pair);
+    test_assert(board[Position(5, 3)] == PossibilitySet::full() - pair);
+}
+
+static void testXWing() {
+    Board<PossibilitySet> board = fullBoard();
+    const Number n = 0;
+    for (Number i : { 1, 7 })
+        for (Number j = 0; j < N; j++)
+            if (j != 2 && j != 5)
+                board[Position(i, j)].remove(n);
+
+    test_assert(applyTechnique(Technique::X_WING, board) == 1);
+    for (Number i = 0; i < N; i++) {
+        bool base = i == 1 || i == 7;
+        test_assert(board[Position(i, 2)].contains(n) == base);
+        test_assert(board[Position(i, 5)].contains(n) == base);
+        test_assert(board[Position(i, 4)].contains(n) == !base);
+    }
+    test_assert(applyTechnique(Technique::X_WING, board) == 0);
+}
+
+static void testRate() {
+    Rating easy = rate(lineBoard(problemLine));
+    test_assert(easy.solvable);
+    test_assert(easy.difficulty == Difficulty::EASY);
+    test_assert(easy.hardest <= Technique::HIDDEN_SINGLE);
+    test_assert(easy.steps[0] + easy.steps[1] == 43);
+    test_assert(easy.guessDepth == 0);
+
+    Rating diabolical = rate(lineBoard(hardProblemLine));
+    test_assert(diabolical.solvable);
+    test_assert(diabolical.hardest == Technique::GUESS);
+    test_assert(diabolical.difficulty == Difficulty::DIABOLICAL);
+    test_assert(diabolical.guessDepth > 0);
+    test_assert(diabolical.score > easy.score);
+
+    Rating insolvable = rate(lineBoard("11" + string(N * N - 2, '0')));
+    test_assert(!insolvable.solvable);
+    ostringstream os;
+    os << insolvable;
+    test_assert(os.str() == "0.0 insolvable");
+}
+
+static void testAll() {
+    testParseDifficulty();
+    testLockedCandidates();
+    testNakedPair();
+    testHiddenPair();
+    testXWing();
+    testRate();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
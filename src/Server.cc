@@ -0,0 +1,265 @@
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Format.hh"
+#include "Server.hh"
+
+using std::deque;
+using std::istringstream;
+using std::ostringstream;
+using std::size_t;
+using std::string;
+using std::unique_lock;
+
+
+/** Parses a decimal number that fills the whole string. */
+static bool parseNumber(const string &s, size_t &n) {
+    if (s.empty() || s.find_first_not_of("0123456789") != string::npos)
+        return false;
+    istringstream is(s);
+    return static_cast<bool>(is >> n);
+}
+
+string Server::respond(const string &request) const {
+    Metrics::Clock::time_point start = Metrics::Clock::now();
+    istringstream is(request);
+    string id, puzzle, field;
+    ostringstream os;
+
+    // A request that cannot be parsed is counted but not solved.
+    auto malformed = [&]() {
+        if (mMetrics != nullptr) {
+            mMetrics->record(Stage::PARSE, Metrics::Clock::now() - start);
+            mMetrics->countMalformed();
+        }
+        return os.str();
+    };
+
+    if (!(is >> id >> puzzle)) {
+        os << (id.empty() ? "-" : id) << " error missing puzzle";
+        return malformed();
+    }
+    os << id << ' ';
+
+    Board<Number> problem;
+    if (!parseLine(puzzle, problem)) {
+        os << "error malformed puzzle";
+        return malformed();
+    }
+
+    size_t nodeLimit = mNodeLimit, timeLimit = 0;
+    while (is >> field) {
+        if (field.compare(0, 6, "nodes=") == 0 &&
+                parseNumber(field.substr(6), nodeLimit))
+            continue;
+        if (field.compare(0, 3, "ms=") == 0 &&
+                parseNumber(field.substr(3), timeLimit))
+            continue;
+        os << "error unknown field " << field;
+        return malformed();
+    }
+
+    Metrics::Clock::time_point parsed = Metrics::Clock::now();
+    if (mMetrics != nullptr)
+        mMetrics->record(Stage::PARSE, parsed - start);
+
+    SearchBudget budget(nodeLimit);
+    if (timeLimit > 0)
+        budget.setTimeLimit(std::chrono::milliseconds(timeLimit));
+
+    SolutionCache::Solver solver = [this, &budget](
+            const Board<Number> &p, Board<Number> &s) {
+        return mPortfolio != nullptr ?
+                mPortfolio->solve(p, s, budget).result :
+                solve(p, s, budget, mOptions);
+    };
+    Board<Number> solution;
+    SolveResult result = mCache != nullptr ?
+            mCache->solve(problem, solution, solver) :
+            solver(problem, solution);
+    if (mMetrics != nullptr) {
+        mMetrics->record(Stage::SOLVE, Metrics::Clock::now() - parsed);
+        mMetrics->count(result);
+    }
+    os << solveResultName(result) << ' ';
+    if (result == SolveResult::UNIQUE || result == SolveResult::MULTIPLE)
+        os << formatLine(solution);
+    else
+        os << '-';
+    return os.str();
+}
+
+void Server::serve(std::istream &in, std::ostream &out) {
+    std::mutex mutex;
+    std::condition_variable condition;
+    deque<string> responses;
+    size_t outstanding = 0;
+    bool endOfInput = false;
+
+    std::thread writer([&] {
+        unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            condition.wait(lock, [&] {
+                return !responses.empty() || (endOfInput && outstanding == 0);
+            });
+            if (responses.empty())
+                return;
+
+            deque<string> batch;
+            batch.swap(responses);
+            lock.unlock();
+            Metrics::Clock::time_point start = Metrics::Clock::now();
+            for (const string &response : batch)
+                out << response << '\n';
+            out.flush();
+            if (mMetrics != nullptr)
+                mMetrics->record(Stage::WRITE, Metrics::Clock::now() - start);
+            lock.lock();
+        }
+    });
+
+    string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+
+        {
+            unique_lock<std::mutex> lock(mutex);
+            outstanding++;
+        }
+        mPool.submit([this, line, &mutex, &condition, &responses,
+                &outstanding] {
+            string response = respond(line);
+            unique_lock<std::mutex> lock(mutex);
+            responses.push_back(std::move(response));
+            outstanding--;
+            condition.notify_one();
+        });
+    }
+
+    {
+        unique_lock<std::mutex> lock(mutex);
+        endOfInput = true;
+    }
+    condition.notify_one();
+    writer.join();
+}
+
+namespace {
+
+/** Stream buffer that reads from and writes to a connected socket. */
+class SocketBuffer : public std::streambuf {
+
+private:
+
+    int mFd;
+    char mInput[4096];
+    char mOutput[4096];
+
+    bool flushOutput() {
+        const char *p = pbase();
+        while (p < pptr()) {
+            ssize_t size = send(mFd, p, pptr() - p, MSG_NOSIGNAL);
+            if (size < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            p += size;
+        }
+        setp(mOutput, mOutput + sizeof mOutput);
+        return true;
+    }
+
+protected:
+
+    int_type underflow() override {
+        ssize_t size;
+        do
+            size = read(mFd, mInput, sizeof mInput);
+        while (size < 0 && errno == EINTR);
+        if (size <= 0)
+            return traits_type::eof();
+        setg(mInput, mInput, mInput + size);
+        return traits_type::to_int_type(mInput[0]);
+    }
+
+    int_type overflow(int_type c) override {
+        if (!flushOutput())
+            return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+            sputc(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        return flushOutput() ? 0 : -1;
+    }
+
+public:
+
+    explicit SocketBuffer(int fd) : mFd(fd) {
+        setg(mInput, mInput, mInput);
+        setp(mOutput, mOutput + sizeof mOutput);
+    }
+
+};
+
+} // namespace
+
+static void serveConnection(Server &server, int fd) {
+    SocketBuffer inBuffer(fd), outBuffer(fd);
+    std::istream in(&inBuffer);
+    std::ostream out(&outBuffer);
+    server.serve(in, out);
+    close(fd);
+}
+
+void Server::serveUnixSocket(const string &path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof address.sun_path)
+        throw std::system_error(
+                ENAMETOOLONG, std::generic_category(), path);
+    path.copy(address.sun_path, path.size());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw std::system_error(errno, std::generic_category(), "socket");
+
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address),
+                sizeof address) < 0 ||
+            listen(listener, SOMAXCONN) < 0) {
+        int error = errno;
+        close(listener);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            int error = errno;
+            close(listener);
+            throw std::system_error(error, std::generic_category(), "accept");
+        }
+        std::thread(serveConnection, std::ref(*this), fd).detach();
+    }
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,83 @@
+#ifndef INCLUDED_SERVER_HH
+#define INCLUDED_SERVER_HH 1
+
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "Metrics.hh"
+#include "Portfolio.hh"
+#include "SolutionCache.hh"
+#include "Solver.hh"
+#include "ThreadPool.hh"
+
+
+/**
+ * Answers solve requests sent over a line-based protocol. Each request is a
+ * single line:
+ *
+ *   <id> <puzzle> [nodes=<limit>] [ms=<limit>]
+ *
+ * where <puzzle> is in the LINE board format and the optional fields limit
+ * the search for that request. Each response is also a single line:
+ *
+ *   <id> <status> <solution>
+ *
+ * where <status> is one of the solve result names and <solution> is the first
+ * solution found in the LINE format, or "-" if there is none. A malformed
+ * request is answered with "<id> error <message>".
+ *
+ * If the server has a solution cache, requests are answered from the cache
+ * whenever a transform of the same puzzle has been solved before. If it has
+ * a portfolio, each request is solved by the portfolio instead of a single
+ * search with the options. If it has metrics, the time to parse and solve
+ * each request and to write each batch of responses is recorded there.
+ *
+ * Requests may be pipelined. They are solved concurrently in the thread pool,
+ * so responses can arrive out of order and must be matched by id. Responses
+ * that complete together are written and flushed together.
+ */
+class Server {
+
+private:
+
+    ThreadPool &mPool;
+    std::size_t mNodeLimit;
+    SolutionCache *mCache;
+    SearchOptions mOptions;
+    Portfolio *mPortfolio;
+    Metrics *mMetrics;
+
+public:
+
+    explicit Server(
+            ThreadPool &pool,
+            std::size_t nodeLimit = SearchBudget::unlimited,
+            SolutionCache *cache = nullptr,
+            const SearchOptions &options = SearchOptions(),
+            Portfolio *portfolio = nullptr,
+            Metrics *metrics = nullptr) noexcept :
+            mPool(pool), mNodeLimit(nodeLimit), mCache(cache),
+            mOptions(options), mPortfolio(portfolio), mMetrics(metrics) { }
+
+    Server(const Server &server) = delete;
+    Server &operator=(const Server &server) = delete;
+
+    std::string respond(const std::string &request) const;
+
+    /** Serves requests read from "in" until the end of input. */
+    void serve(std::istream &in, std::ostream &out);
+
+    /**
+     * Listens on a Unix domain socket at the given path and serves every
+     * connection. Never returns unless the socket cannot be set up, in which
+     * case std::system_error is thrown.
+     */
+    void serveUnixSocket(const std::string &path);
+
+};
+
+
+#endif // #ifndef INCLUDED_SERVER_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
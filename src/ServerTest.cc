@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Metrics.hh"
+#include "Server.hh"
+#include "SolutionCache.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+using std::istringstream;
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+
+static const string problem = problemLine;
+static const string solution = solutionLine;
+static const string emptyProblem(N * N, '0');
+
+static void testThreadPool() {
+    std::atomic<int> sum(0);
+    {
+        ThreadPool pool(3);
+        test_assert(pool.size() == 3);
+        for (int i = 1; i <= 100; i++)
+            pool.submit([&sum, i] { sum += i; });
+    }
+    test_assert(sum == 5050);
+}
+
+static void testRespond() {
+    ThreadPool pool(1);
+    Server server(pool);
+
+    test_assert(server.respond("a " + problem) ==
+            "a unique " + solution);
+    test_assert(server.respond("b " + problem + " nodes=100 ms=1000") ==
+            "b unique " + solution);
+    test_assert(server.respond("c " + emptyProblem).compare(0, 11,
+            "c multiple ") == 0);
+    test_assert(server.respond("d 11" + emptyProblem.substr(2)) ==
+            "d insolvable -");
+    test_assert(server.respond("e " + emptyProblem + " nodes=1") ==
+            "e aborted -");
+
+    test_assert(server.respond("f") == "f error missing puzzle");
+    test_assert(server.respond("g 123") == "g error malformed puzzle");
+    test_assert(server.respond("h " + problem + " nodes=x") ==
+            "h error unknown field nodes=x");
+}
+
+static void testMetrics() {
+    ThreadPool pool(1);
+    Metrics metrics;
+    Server server(pool, SearchBudget::unlimited, nullptr, SearchOptions(),
+            nullptr, &metrics);
+
+    server.respond("a " + problem);
+    server.respond("b 123");
+    server.respond("c " + problem + " nodes=x");
+    MetricsSnapshot snapshot = metrics.snapshot();
+    test_assert(snapshot.results[0] == 1);
+    test_assert(snapshot.malformed == 2);
+    test_assert(snapshot.problems() == 3);
+    // Every request is parsed, but only the well-formed one is solved.
+    test_assert(snapshot.stage(Stage::PARSE).count() == 3);
+    test_assert(snapshot.stage(Stage::SOLVE).count() == 1);
+}
+
+/**
+ * Checks that a cached server answers a blank board within its time limit:
+ * the board is too symmetric to canonicalize cheaply, so it skips the cache.
+ */
+static void testCache() {
+    ThreadPool pool(1);
+    SolutionCache cache(10);
+    Server server(pool, SearchBudget::unlimited, &cache);
+
+    test_assert(server.respond("a " + emptyProblem + " ms=100")
+            .compare(0, 11, "a multiple ") == 0);
+    test_assert(server.respond("b " + problem) == "b unique " + solution);
+    test_assert(server.respond("c " + problem) == "c unique " + solution);
+    test_assert(cache.hits() == 1);
+}
+
+static void testDefaultBudget() {
+    ThreadPool pool(1);
+    Server server(pool, 1);
+
+    test_assert(server.respond("a " + emptyProblem) == "a aborted -");
+    test_assert(server.respond("b " + emptyProblem + " nodes=100")
+            .compare(0, 11, "b multiple ") == 0);
+}
+
+static void testServe() {
+    ThreadPool pool(4);
+    Server server(pool);
+
+    istringstream in(
+            "1 " + problem + "\n"
+            "\n"
+            "2 " + emptyProblem + " nodes=1\n"
+            "3 " + problem + "\n");
+    ostringstream out;
+    server.serve(in, out);
+
+    vector<string> responses;
+    istringstream lines(out.str());
+    string line;
+    while (std::getline(lines, line))
+        responses.push_back(line);
+    std::sort(responses.begin(), responses.end());
+
+    test_assert(responses.size() == 3);
+    test_assert(responses.at(0) == "1 unique " + solution);
+    test_assert(responses.at(1) == "2 aborted -");
+    test_assert(responses.at(2) == "3 unique " + solution);
+}
+
+static void testAll() {
+    testThreadPool();
+    testRespond();
+    testMetrics();
+    testCache();
+    testDefaultBudget();
+    testServe();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
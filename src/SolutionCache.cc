@@ -0,0 +1,105 @@
+#include "Canonical.hh"
+#include "Format.hh"
+#include "SolutionCache.hh"
+
+using std::size_t;
+using std::string;
+using std::unique_lock;
+
+
+/**
+ * The most rows canonicalize may compare before the problem is solved
+ * without the cache. Typical problems take less than a hundred rows, while
+ * a blank board ties in every row and takes millions.
+ */
+static constexpr size_t canonicalRowLimit = 1024;
+
+bool SolutionCache::lookup(const string &key, Entry &entry) {
+    unique_lock<std::mutex> lock(mMutex);
+    auto i = mIndex.find(key);
+    if (i == mIndex.end()) {
+        mMisses++;
+        return false;
+    }
+
+    mHits++;
+    mEntries.splice(mEntries.begin(), mEntries, i->second);
+    entry = i->second->second;
+    return true;
+}
+
+void SolutionCache::store(const string &key, const Entry &entry) {
+    if (mCapacity == 0)
+        return;
+
+    unique_lock<std::mutex> lock(mMutex);
+    auto i = mIndex.find(key);
+    if (i != mIndex.end()) {
+        mEntries.splice(mEntries.begin(), mEntries, i->second);
+        return;
+    }
+
+    if (mEntries.size() >= mCapacity) {
+        mIndex.erase(mEntries.back().first);
+        mEntries.pop_back();
+    }
+    mEntries.emplace_front(key, entry);
+    mIndex.emplace(key, mEntries.begin());
+}
+
+SolveResult SolutionCache::solve(
+        const Board<Number> &problem,
+        Board<Number> &solution,
+        SearchBudget &budget,
+        const SearchOptions &options) {
+    return solve(problem, solution,
+            [&budget, &options](
+                    const Board<Number> &canonicalProblem,
+                    Board<Number> &canonicalSolution) {
+                return ::solve(
+                        canonicalProblem, canonicalSolution, budget, options);
+            });
+}
+
+SolveResult SolutionCache::solve(
+        const Board<Number> &problem,
+        Board<Number> &solution,
+        const Solver &solver) {
+    Board<Number> canonicalProblem;
+    Transform transform;
+    if (!canonicalize(problem, canonicalProblem, transform,
+            canonicalRowLimit))
+        return solver(problem, solution);
+    string key = formatLine(canonicalProblem);
+
+    Entry entry;
+    if (!lookup(key, entry)) {
+        entry.result = solver(canonicalProblem, entry.solution);
+        if (entry.result == SolveResult::ABORTED)
+            return entry.result;
+        store(key, entry);
+    }
+
+    if (entry.result == SolveResult::UNIQUE ||
+            entry.result == SolveResult::MULTIPLE)
+        transform.inverse().apply(entry.solution, solution);
+    return entry.result;
+}
+
+size_t SolutionCache::size() {
+    unique_lock<std::mutex> lock(mMutex);
+    return mEntries.size();
+}
+
+size_t SolutionCache::hits() {
+    unique_lock<std::mutex> lock(mMutex);
+    return mHits;
+}
+
+size_t SolutionCache::misses() {
+    unique_lock<std::mutex> lock(mMutex);
+    return mMisses;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,77 @@
+#ifndef INCLUDED_SOLUTIONCACHE_HH
+#define INCLUDED_SOLUTIONCACHE_HH 1
+
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "Board.hh"
+#include "Solver.hh"
+
+
+/**
+ * A bounded, thread-safe cache of solve results. Problems are keyed by their
+ * canonical form, so a problem hits the cache when any transform of it has
+ * been solved before. The least recently used entry is evicted when the cache
+ * is full. Aborted results are never cached, and problems too symmetric to
+ * canonicalize quickly, like a blank board, are solved without the cache.
+ */
+class SolutionCache {
+
+private:
+
+    struct Entry {
+        SolveResult result;
+        Board<Number> solution;
+    };
+
+    using Entries = std::list<std::pair<std::string, Entry>>;
+
+    std::size_t mCapacity;
+    std::mutex mMutex;
+    Entries mEntries;
+    std::unordered_map<std::string, Entries::iterator> mIndex;
+    std::size_t mHits = 0, mMisses = 0;
+
+    bool lookup(const std::string &key, Entry &entry);
+    void store(const std::string &key, const Entry &entry);
+
+public:
+
+    explicit SolutionCache(std::size_t capacity) : mCapacity(capacity) { }
+    SolutionCache(const SolutionCache &cache) = delete;
+    SolutionCache &operator=(const SolutionCache &cache) = delete;
+
+    /**
+     * Returns the cached result for the problem if any, or solves the
+     * canonical form of the problem and caches the result.
+     */
+    SolveResult solve(
+            const Board<Number> &problem,
+            Board<Number> &solution,
+            SearchBudget &budget,
+            const SearchOptions &options = SearchOptions());
+
+    using Solver = std::function<SolveResult(
+            const Board<Number> &problem, Board<Number> &solution)>;
+
+    /** Like the above, but solves the canonical form with the solver. */
+    SolveResult solve(
+            const Board<Number> &problem,
+            Board<Number> &solution,
+            const Solver &solver);
+
+    std::size_t size();
+    std::size_t hits();
+    std::size_t misses();
+
+};
+
+
+#endif // #ifndef INCLUDED_SOLUTIONCACHE_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
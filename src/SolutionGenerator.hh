@@ -0,0 +1,148 @@
+#ifndef INCLUDED_SOLUTIONGENERATOR_HH
+#define INCLUDED_SOLUTIONGENERATOR_HH 1
+
+#if !defined __cpp_impl_coroutine || !__has_include(<coroutine>)
+#error "SolutionGenerator.hh needs C++20 coroutines"
+#endif
+
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+#include "Board.hh"
+#include "Solver.hh"
+#include "SteppedSearch.hh"
+
+
+/**
+ * A lazy sequence of pointers to solutions, produced by a coroutine. Each
+ * pointer is valid until the sequence is advanced.
+ */
+class SolutionGenerator {
+
+public:
+
+    struct promise_type {
+        const Board<Number> *current = nullptr;
+        std::exception_ptr exception;
+
+        SolutionGenerator get_return_object() noexcept {
+            return SolutionGenerator(
+                    std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always yield_value(const Board<Number> *value) noexcept {
+            current = value;
+            return {};
+        }
+
+        void return_void() noexcept { }
+
+        void unhandled_exception() noexcept {
+            exception = std::current_exception();
+        }
+    };
+
+    class iterator {
+
+    private:
+
+        std::coroutine_handle<promise_type> mHandle;
+
+    public:
+
+        explicit iterator(std::coroutine_handle<promise_type> handle)
+                noexcept : mHandle(handle) { }
+
+        const Board<Number> *operator*() const noexcept {
+            return mHandle.promise().current;
+        }
+
+        iterator &operator++() {
+            mHandle.resume();
+            if (mHandle.promise().exception)
+                std::rethrow_exception(mHandle.promise().exception);
+            return *this;
+        }
+
+        bool operator==(std::default_sentinel_t) const noexcept {
+            return mHandle.done();
+        }
+
+    };
+
+private:
+
+    std::coroutine_handle<promise_type> mHandle;
+
+    explicit SolutionGenerator(std::coroutine_handle<promise_type> handle)
+            noexcept : mHandle(handle) { }
+
+public:
+
+    SolutionGenerator(SolutionGenerator &&other) noexcept :
+            mHandle(std::exchange(other.mHandle, nullptr)) { }
+    SolutionGenerator(const SolutionGenerator &) = delete;
+    SolutionGenerator &operator=(const SolutionGenerator &) = delete;
+
+    ~SolutionGenerator() {
+        if (mHandle)
+            mHandle.destroy();
+    }
+
+    /** Runs the coroutine up to its first yield. */
+    iterator begin() {
+        return ++iterator(mHandle);
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return {};
+    }
+
+};
+
+/**
+ * Yields every solution of the board, in the order of iterateSolutions,
+ * searching in steps of "stepNodes" nodes. After a step that finds no
+ * solution, yields null instead, so that no advance of the sequence does
+ * more than one step of work and an event loop can take its turn:
+ *
+ *   for (const Board<Number> *solution : generateSolutions(board, 1000))
+ *       if (solution != nullptr)
+ *           use(*solution);
+ *       else
+ *           pollEvents();
+ */
+inline SolutionGenerator generateSolutions(
+        Board<PossibilitySet> board,
+        std::size_t stepNodes,
+        SearchOptions options = SearchOptions()) {
+    SteppedSearch search(board, options);
+    Board<Number> solution;
+    for (;;) {
+        bool finished = search.step(stepNodes);
+        bool found = false;
+        while (search.takeSolution(solution)) {
+            found = true;
+            co_yield &solution;
+        }
+        if (finished)
+            co_return;
+        if (!found)
+            co_yield nullptr;
+    }
+}
+
+
+#endif // #ifndef INCLUDED_SOLUTIONGENERATOR_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,51 @@
+#include <vector>
+#include "Board.hh"
+#include "Format.hh"
+#include "SolutionGenerator.hh"
+#include "Solver.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+static void testGenerate() {
+    Board<Number> problem;
+    parseLine(openProblemLine, problem);
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+
+    std::vector<Board<Number>> all;
+    iterateSolutions(board, [&](const Board<Number> &solution) {
+        all.push_back(solution);
+    });
+
+    std::vector<Board<Number>> generated;
+    std::size_t idle = 0;
+    for (const Board<Number> *solution : generateSolutions(board, 2)) {
+        if (solution != nullptr)
+            generated.push_back(*solution);
+        else
+            idle++;
+    }
+    test_assert(generated == all);
+    test_assert(idle > 0);
+
+    // Stopping early leaves the rest of the search undone.
+    std::size_t taken = 0;
+    for (const Board<Number> *solution : generateSolutions(board, 1000)) {
+        if (solution != nullptr && ++taken == 3)
+            break;
+    }
+    test_assert(taken == 3);
+}
+
+static void testAll() {
+    testGenerate();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
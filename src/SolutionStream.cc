@@ -0,0 +1,164 @@
+#include <string>
+#include "Format.hh"
+#include "SolutionStream.hh"
+
+using std::size_t;
+using std::string;
+using std::uint32_t;
+
+
+static const char header[] = "sudoku-solutions 1";
+
+SolutionWriter::SolutionWriter(std::ostream &os, const Board<Number> &problem)
+        : mOs(os), mPrevious(problem) {
+    mBuffer.reserve(bufferSize);
+    mBuffer += header;
+    mBuffer += '\n';
+    mBuffer += formatLine(problem);
+    mBuffer += '\n';
+}
+
+void SolutionWriter::putBits(uint32_t value, unsigned width) {
+    mBits = (mBits << width) | value;
+    mBitCount += width;
+    while (mBitCount >= 8) {
+        mBitCount -= 8;
+        mBuffer += static_cast<char>(mBits >> mBitCount);
+    }
+    if (mBuffer.size() >= bufferSize)
+        flushBuffer();
+}
+
+void SolutionWriter::putGamma(uint32_t value) {
+    unsigned width = bitWidth(value);
+    putBits(0, width - 1);
+    putBits(value, width);
+}
+
+void SolutionWriter::flushBuffer() {
+    mOs.write(mBuffer.data(), mBuffer.size());
+    mWritten += mBuffer.size();
+    mBuffer.clear();
+}
+
+void SolutionWriter::write(const Board<Number> &solution) {
+    uint32_t count = 0;
+    for (Number index = 0; index < N * N; index++)
+        if (solution.data()[index] != mPrevious.data()[index])
+            count++;
+    putBits(count, solutionCountBits);
+
+    Number next = 0;
+    for (Number index = 0; index < N * N; index++) {
+        Number n = solution.data()[index];
+        if (n == mPrevious.data()[index])
+            continue;
+        putGamma(static_cast<uint32_t>(index - next + 1));
+        putBits(static_cast<uint32_t>(n), solutionNumberBits);
+        next = index + 1;
+    }
+    mPrevious = solution;
+}
+
+bool SolutionWriter::finish() {
+    putBits(solutionEndMarker, solutionCountBits);
+    if (mBitCount > 0)
+        putBits(0, 8 - mBitCount);
+    flushBuffer();
+    return static_cast<bool>(mOs.flush());
+}
+
+bool SolutionReader::getBits(uint32_t &value, unsigned width) {
+    while (mBitCount < width) {
+        std::istream::int_type c = mIs.rdbuf()->sbumpc();
+        if (c == std::istream::traits_type::eof())
+            return false;
+        mBits = (mBits << 8) | static_cast<unsigned char>(c);
+        mBitCount += 8;
+    }
+    mBitCount -= width;
+    value = static_cast<uint32_t>(mBits >> mBitCount) & ((1u << width) - 1);
+    return true;
+}
+
+bool SolutionReader::getGamma(uint32_t &value) {
+    unsigned zeros = 0;
+    uint32_t bit;
+    do {
+        if (!getBits(bit, 1) || ++zeros > 32)
+            return false;
+    } while (bit == 0);
+
+    value = 1;
+    if (zeros == 1)
+        return true;
+    uint32_t rest;
+    if (!getBits(rest, zeros - 1))
+        return false;
+    value = (value << (zeros - 1)) | rest;
+    return true;
+}
+
+bool SolutionReader::start(Board<Number> &problem) {
+    mBits = 0;
+    mBitCount = 0;
+
+    string line;
+    if (!std::getline(mIs, line))
+        return false;
+    mFailed = !(line == header && std::getline(mIs, line) &&
+            parseLine(line, problem));
+    if (mFailed)
+        return false;
+    mPrevious = problem;
+    return true;
+}
+
+bool SolutionReader::next(Board<Number> &solution) {
+    uint32_t count;
+    if (!getBits(count, solutionCountBits) ||
+            (count > N * N && count != solutionEndMarker)) {
+        mFailed = true;
+        return false;
+    }
+    if (count == solutionEndMarker)
+        return false;
+
+    solution = mPrevious;
+    size_t next = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t skip, n;
+        if (!getGamma(skip) || !getBits(n, solutionNumberBits)) {
+            mFailed = true;
+            return false;
+        }
+        size_t index = next + skip - 1;
+        if (index >= N * N || n >= N) {
+            mFailed = true;
+            return false;
+        }
+        solution.data()[index] = n;
+        next = index + 1;
+    }
+    mPrevious = solution;
+    return true;
+}
+
+bool decodeSolutions(
+        std::istream &is,
+        const std::function<void(const Board<Number> &problem)> &onProblem,
+        const std::function<void(const Board<Number> &solution)> &onSolution) {
+    SolutionReader reader(is);
+    Board<Number> board;
+    while (reader.start(board)) {
+        onProblem(board);
+        while (reader.next(board))
+            onSolution(board);
+        if (reader.failed())
+            return false;
+    }
+    return !reader.failed();
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,139 @@
+#ifndef INCLUDED_SOLUTIONSTREAM_HH
+#define INCLUDED_SOLUTIONSTREAM_HH 1
+
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include "Board.hh"
+
+
+/*
+ * A packed stream of the solutions of a problem starts with a header line,
+ * "sudoku-solutions 1", and the problem on one line (see formatLine). Bits
+ * follow, most significant first in each byte. Each solution is stored as
+ * the cells where it differs from the previous solution (or, for the first
+ * one, from the problem):
+ *
+ *   - the number of those cells in solutionCountBits bits,
+ *   - for each cell in row-major order, the number of cells skipped since
+ *     the previous one (or the start of the board) plus one, in the Elias
+ *     gamma code, and the number in solutionNumberBits bits.
+ *
+ * Searching in depth-first order changes few cells between neighboring
+ * solutions, so a solution takes about ten bytes instead of the 162 of the
+ * grid format. A count of solutionEndMarker ends the stream, padded with
+ * zero bits to a whole byte, so that streams can be concatenated.
+ */
+
+/** The number of bits needed to store values up to "max". */
+constexpr unsigned bitWidth(std::size_t max) noexcept {
+    unsigned width = 0;
+    while (max > 0) {
+        width++;
+        max >>= 1;
+    }
+    return width;
+}
+
+constexpr unsigned solutionCountBits = bitWidth(N * N + 1);
+constexpr unsigned solutionNumberBits = bitWidth(N - 1);
+constexpr std::uint32_t solutionEndMarker = (1u << solutionCountBits) - 1;
+
+/**
+ * Writes a packed stream of solutions. The bytes are buffered and written
+ * to the output stream in blocks; finish must be called to end the stream.
+ */
+class SolutionWriter {
+
+private:
+
+    static constexpr std::size_t bufferSize = 1 << 16;
+
+    std::ostream &mOs;
+    Board<Number> mPrevious;
+    std::uint64_t mBits = 0;
+    unsigned mBitCount = 0;
+    std::string mBuffer;
+    std::size_t mWritten = 0;
+
+    void putBits(std::uint32_t value, unsigned width);
+    /** Writes a value of at least 1 in the Elias gamma code. */
+    void putGamma(std::uint32_t value);
+    void flushBuffer();
+
+public:
+
+    /** Writes the header of the stream of the solutions of the problem. */
+    SolutionWriter(std::ostream &os, const Board<Number> &problem);
+    SolutionWriter(const SolutionWriter &writer) = delete;
+    SolutionWriter &operator=(const SolutionWriter &writer) = delete;
+
+    void write(const Board<Number> &solution);
+
+    /**
+     * Writes the end marker and flushes the buffer and the output stream.
+     * Returns false if the output stream has failed.
+     */
+    bool finish();
+
+    /** The number of bytes of the stream so far, counting the buffer. */
+    std::size_t size() const noexcept {
+        return mWritten + mBuffer.size();
+    }
+
+};
+
+/** Reads the solutions of one or more concatenated packed streams. */
+class SolutionReader {
+
+private:
+
+    std::istream &mIs;
+    Board<Number> mPrevious;
+    std::uint64_t mBits = 0;
+    unsigned mBitCount = 0;
+    bool mFailed = false;
+
+    bool getBits(std::uint32_t &value, unsigned width);
+    bool getGamma(std::uint32_t &value);
+
+public:
+
+    explicit SolutionReader(std::istream &is) noexcept : mIs(is) { }
+
+    /**
+     * Reads the header of the next stream and stores its problem. Returns
+     * false at the end of the input or if the header is bad (see failed).
+     */
+    bool start(Board<Number> &problem);
+
+    /**
+     * Reads the next solution of the stream. Returns false at the end of
+     * the stream or if the stream is bad.
+     */
+    bool next(Board<Number> &solution);
+
+    /** Returns true if a header or a solution was malformed or cut off. */
+    bool failed() const noexcept {
+        return mFailed;
+    }
+
+};
+
+/**
+ * Reads every stream of the input and calls onProblem with the problem of
+ * each stream and then onSolution with each of its solutions. Returns false
+ * if the input is not a sequence of whole packed streams.
+ */
+extern bool decodeSolutions(
+        std::istream &is,
+        const std::function<void(const Board<Number> &problem)> &onProblem,
+        const std::function<void(const Board<Number> &solution)> &onSolution);
+
+
+#endif // #ifndef INCLUDED_SOLUTIONSTREAM_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,133 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Board.hh"
+#include "Format.hh"
+#include "SolutionStream.hh"
+#include "Solver.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+static void testBitWidth() {
+    test_assert(bitWidth(0) == 0);
+    test_assert(bitWidth(1) == 1);
+    test_assert(bitWidth(8) == 4);
+    test_assert(bitWidth(82) == 7);
+    test_assert(solutionEndMarker > N * N);
+}
+
+static std::vector<Board<Number>> enumerate(const Board<Number> &problem) {
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+    std::vector<Board<Number>> solutions;
+    iterateSolutions(board, [&](const Board<Number> &solution) {
+        solutions.push_back(solution);
+    });
+    return solutions;
+}
+
+static void testRoundTrip() {
+    Board<Number> problem;
+    parseLine(openProblemLine, problem);
+    std::vector<Board<Number>> solutions = enumerate(problem);
+    test_assert(solutions.size() == 120);
+
+    std::stringstream stream;
+    SolutionWriter writer(stream, problem);
+    for (const Board<Number> &solution : solutions)
+        writer.write(solution);
+    test_assert(writer.finish());
+    test_assert(writer.size() == stream.str().size());
+
+    // An order of magnitude smaller than the grid format.
+    std::ostringstream grids;
+    for (const Board<Number> &solution : solutions)
+        writeBoard(grids, solution, BoardFormat::GRID);
+    test_assert(stream.str().size() * 10 < grids.str().size());
+
+    SolutionReader reader(stream);
+    Board<Number> read;
+    test_assert(reader.start(read));
+    test_assert(read == problem);
+    for (const Board<Number> &solution : solutions) {
+        test_assert(reader.next(read));
+        test_assert(read == solution);
+    }
+    test_assert(!reader.next(read));
+    test_assert(!reader.failed());
+    test_assert(!reader.start(read));
+    test_assert(!reader.failed());
+}
+
+static void testConcatenation() {
+    Board<Number> problem, solution, openProblem;
+    parseLine(problemLine, problem);
+    parseLine(solutionLine, solution);
+    parseLine(openProblemLine, openProblem);
+
+    std::stringstream stream;
+    SolutionWriter first(stream, problem);
+    first.write(solution);
+    test_assert(first.finish());
+    // A solved problem, whose only solution differs from it nowhere.
+    SolutionWriter second(stream, solution);
+    second.write(solution);
+    test_assert(second.finish());
+    // A problem without solutions.
+    SolutionWriter third(stream, openProblem);
+    test_assert(third.finish());
+
+    std::vector<Board<Number>> problems, solutions;
+    test_assert(decodeSolutions(stream,
+            [&](const Board<Number> &p) { problems.push_back(p); },
+            [&](const Board<Number> &s) { solutions.push_back(s); }));
+    test_assert(problems.size() == 3);
+    test_assert(problems[0] == problem);
+    test_assert(problems[1] == solution);
+    test_assert(problems[2] == openProblem);
+    test_assert(solutions.size() == 2);
+    test_assert(solutions[0] == solution);
+    test_assert(solutions[1] == solution);
+}
+
+static void testMalformed() {
+    Board<Number> problem, solution;
+    parseLine(problemLine, problem);
+    parseLine(solutionLine, solution);
+    auto ignore = [](const Board<Number> &) { };
+
+    std::istringstream badHeader("sudoku-solutions 2\n");
+    test_assert(!decodeSolutions(badHeader, ignore, ignore));
+
+    std::stringstream whole;
+    SolutionWriter writer(whole, problem);
+    writer.write(solution);
+    test_assert(writer.finish());
+    std::string bytes = whole.str();
+
+    // Cut off before the end marker.
+    std::istringstream cut(bytes.substr(0, bytes.size() - 2));
+    test_assert(!decodeSolutions(cut, ignore, ignore));
+
+    // A count larger than the board.
+    std::string large = bytes.substr(0, bytes.find('\n', 20) + 1) +
+            static_cast<char>(0xA4);
+    std::istringstream tooMany(large);
+    test_assert(!decodeSolutions(tooMany, ignore, ignore));
+}
+
+static void testAll() {
+    testBitWidth();
+    testRoundTrip();
+    testConcatenation();
+    testMalformed();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
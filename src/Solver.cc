@@ -1,119 +1,885 @@
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include "Arena.hh"
+#include "BitBoard.hh"
+#include "ConstraintGraph.hh"
 #include "Solver.hh"
+#include "TranspositionTable.hh"
 
-using std::array;
 
+constexpr std::size_t SearchBudget::unlimited;
 
-void eliminateImpossibilities(Board<PossibilitySet> &board) noexcept {
-    wholeArea.forAllPositions([&board](Position pos1) -> bool {
-        if (!board[pos1].isUnique())
+bool SearchBudget::consume() noexcept {
+    if (mExhausted)
+        return false;
+    if (mNodes >= mNodeLimit) {
+        mExhausted = true;
+        return false;
+    }
+    // Checked on the first node too, since the parts of a search with
+    // restarts may be shorter than the interval.
+    mNodes++;
+    if (mNodes % 64 == 1 &&
+            ((mHasDeadline && Clock::now() > mDeadline) ||
+             (mCancelled != nullptr &&
+              mCancelled->load(std::memory_order_relaxed)))) {
+        mExhausted = mInterrupted = true;
+        return false;
+    }
+    return true;
+}
+
+SearchBudget SearchBudget::part(std::size_t nodeLimit) const noexcept {
+    SearchBudget part = *this;
+    part.mNodes = 0;
+    part.mNodeLimit = std::min(nodeLimit, mNodeLimit - mNodes);
+    return part;
+}
+
+void SearchBudget::charge(const SearchBudget &part) noexcept {
+    mNodes += part.mNodes;
+    if (part.mInterrupted)
+        mExhausted = mInterrupted = true;
+    else if (part.mExhausted && mNodes >= mNodeLimit)
+        mExhausted = true;
+}
+
+const char *solveResultName(SolveResult result) noexcept {
+    switch (result) {
+    case SolveResult::UNIQUE:
+        return "unique";
+    case SolveResult::MULTIPLE:
+        return "multiple";
+    case SolveResult::INSOLVABLE:
+        return "insolvable";
+    case SolveResult::ABORTED:
+        return "aborted";
+    }
+    return "unknown";
+}
+
+static const char *const backendNames[] = {
+    "cells", "bitboard",
+};
+
+const char *backendName(Backend backend) noexcept {
+    return backendNames[static_cast<std::size_t>(backend)];
+}
+
+bool parseBackend(const std::string &name, Backend &backend) noexcept {
+    for (std::size_t i = 0; i < sizeof backendNames / sizeof *backendNames;
+            i++) {
+        if (name == backendNames[i]) {
+            backend = static_cast<Backend>(i);
             return true;
+        }
+    }
+    return false;
+}
+
+static const char *const valueOrderNames[] = {
+    "ascending", "descending", "random",
+};
 
-        Number n = board[pos1].uniqueValue();
-        auto eliminate = [&board, pos1, n](Position pos2) -> bool {
-            if (pos2 != pos1)
-                board[pos2].remove(n);
+const char *valueOrderName(ValueOrder order) noexcept {
+    return valueOrderNames[static_cast<std::size_t>(order)];
+}
+
+bool parseValueOrder(const std::string &name, ValueOrder &order) noexcept {
+    for (std::size_t i = 0;
+            i < sizeof valueOrderNames / sizeof *valueOrderNames; i++) {
+        if (name == valueOrderNames[i]) {
+            order = static_cast<ValueOrder>(i);
             return true;
-        };
+        }
+    }
+    return false;
+}
 
-        rowArea(pos1).forAllPositions(eliminate);
-        columnArea(pos1).forAllPositions(eliminate);
-        blockArea(pos1).forAllPositions(eliminate);
-        return true;
-    });
+static const char *const tieBreakNames[] = {
+    "first", "degree", "random",
+};
+
+const char *tieBreakName(TieBreak tieBreak) noexcept {
+    return tieBreakNames[static_cast<std::size_t>(tieBreak)];
 }
 
-/**
- * Counts the number of positions in the given area where a number can occur.
- * Makes the possibility unique if the number can occur at exactly one
- * position.
+bool parseTieBreak(const std::string &name, TieBreak &tieBreak) noexcept {
+    for (std::size_t i = 0;
+            i < sizeof tieBreakNames / sizeof *tieBreakNames; i++) {
+        if (name == tieBreakNames[i]) {
+            tieBreak = static_cast<TieBreak>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t lubyTerm(std::size_t index) noexcept {
+    // Find the smallest complete subsequence of length 2^k - 1 that contains
+    // the index, and descend into the repeated half that contains it.
+    std::size_t size = 1, exponent = 0;
+    while (size < index + 1) {
+        size = 2 * size + 1;
+        exponent++;
+    }
+    while (size - 1 != index) {
+        size = (size - 1) / 2;
+        exponent--;
+        index %= size;
+    }
+    return std::size_t(1) << exponent;
+}
+
+/** Parses a decimal number that fills the whole range of the text. */
+static bool parseNumber(
+        const std::string &text,
+        std::size_t begin,
+        std::size_t end,
+        std::size_t &number) noexcept {
+    if (begin == end)
+        return false;
+    number = 0;
+    for (std::size_t i = begin; i < end; i++) {
+        if (text[i] < '0' || text[i] > '9' ||
+                __builtin_mul_overflow(number, 10, &number) ||
+                __builtin_add_overflow(
+                        number, std::size_t(text[i] - '0'), &number))
+            return false;
+    }
+    return true;
+}
+
+bool parseShard(const std::string &text, Shard &shard) noexcept {
+    std::size_t slash = text.find('/');
+    std::size_t index, count;
+    if (slash == std::string::npos ||
+            !parseNumber(text, 0, slash, index) ||
+            !parseNumber(text, slash + 1, text.size(), count) ||
+            index >= count)
+        return false;
+    shard.index = index;
+    shard.count = count;
+    return true;
+}
+
+namespace {
+
+/*
+ * The search below is written once for both backends and for constraint
+ * graphs. These overloads adapt each board representation to it.
  */
-static void fixUniquePossibilities(
+
+BoardState propagate(
         Board<PossibilitySet> &board,
-        const Area &area) {
-    struct Possibility {
-        Position position;
-        size_t count = 0;
-    };
+        Position &branch,
+        const SearchOptions &options)
+        noexcept {
+    for (;;) {
+        repeatNonAssumptionProcess(board);
+        BoardState state = classifyAndFindBranch(board, branch);
+        if (state != BoardState::UNSOLVED || !options.deduce ||
+                !options.deduce(board))
+            return state;
+    }
+}
 
-    array<Possibility, N> possibilities;
+PossibilitySet candidates(
+        const Board<PossibilitySet> &board, const Position &pos) noexcept {
+    return board[pos];
+}
 
-    area.forAllPositions([&](Position pos) -> bool {
-        board[pos].forAllPossibleNumbers([&, pos](Number n) {
-            possibilities[n].position = pos;
-            possibilities[n].count++;
-            return true;
-        });
-        return true;
-    });
+void assume(Board<PossibilitySet> &board, const Position &pos, Number n)
+        noexcept {
+    board[pos] = PossibilitySet(n);
+}
 
-    for (Number n = 0; n < N; n++)
-        if (possibilities[n].count == 1)
-            board[possibilities[n].position] = PossibilitySet(n);
+const Board<PossibilitySet> &solutionBoard(
+        const Board<PossibilitySet> &board, Board<PossibilitySet> &)
+        noexcept {
+    return board;
 }
 
-void fixUniquePossibilities(Board<PossibilitySet> &board) noexcept {
+BoardState propagate(
+        BitBoard &board, Position &branch, const SearchOptions &) noexcept {
+    if (!board.propagate())
+        return BoardState::INSOLVABLE;
+    if (board.isSolved())
+        return BoardState::SOLVED;
+    branch = CellSet::position(board.findIndexWithLeastCandidates());
+    return BoardState::UNSOLVED;
+}
+
+PossibilitySet candidates(const BitBoard &board, const Position &pos)
+        noexcept {
+    return board.candidates(CellSet::index(pos));
+}
+
+void assume(BitBoard &board, const Position &pos, Number n) noexcept {
+    board.place(CellSet::index(pos), n);
+}
+
+const Board<PossibilitySet> &solutionBoard(
+        const BitBoard &board, Board<PossibilitySet> &scratch) noexcept {
+    board.toBoard(scratch);
+    return scratch;
+}
+
+/** A board of a variant, searched with the propagation of its graph. */
+struct GraphBoard {
+    Board<PossibilitySet> board;
+    const ConstraintGraph *graph;
+    /** The positions assumed since the board was last propagated. */
+    CellSet changed;
+};
+
+BoardState propagate(
+        GraphBoard &board, Position &branch, const SearchOptions &) noexcept {
+    CellSet changed = board.changed;
+    board.changed = CellSet();
+    if (!board.graph->propagate(board.board, changed))
+        return BoardState::INSOLVABLE;
+    return classifyAndFindBranch(board.board, branch);
+}
+
+PossibilitySet candidates(const GraphBoard &board, const Position &pos)
+        noexcept {
+    return board.board[pos];
+}
+
+void assume(GraphBoard &board, const Position &pos, Number n) noexcept {
+    board.board[pos] = PossibilitySet(n);
+    board.changed.add(CellSet::index(pos));
+}
+
+const Board<PossibilitySet> &solutionBoard(
+        const GraphBoard &board, Board<PossibilitySet> &) noexcept {
+    return board.board;
+}
+
+/** Returns the state to search for the board. */
+template <typename State>
+State makeState(
+        const Board<PossibilitySet> &board, const SearchOptions &) {
+    return State(board);
+}
+
+template <>
+GraphBoard makeState<GraphBoard>(
+        const Board<PossibilitySet> &board, const SearchOptions &options) {
+    return GraphBoard{board, options.graph, CellSet::all()};
+}
+
+std::uint64_t hashBoard(const Board<PossibilitySet> &board) noexcept {
+    return zobristHash(board);
+}
+
+std::uint64_t hashBoard(const GraphBoard &board) noexcept {
+    return zobristHash(board.board);
+}
+
+/** The positions that share a constraint with the position. */
+template <typename State>
+const CellSet &positionPeers(const State &, Number index) noexcept {
+    return peerCells(index);
+}
+
+const CellSet &positionPeers(const GraphBoard &board, Number index) noexcept {
+    return board.graph->peers(index);
+}
+
+std::uint64_t hashBoard(const BitBoard &board) noexcept {
+    std::uint64_t hash = 0;
     for (Number n = 0; n < N; n++) {
-        fixUniquePossibilities(board, rowArea(n));
-        fixUniquePossibilities(board, columnArea(n));
+        for (CellSet positions = board.positions(n); !positions.isEmpty(); ) {
+            Number index = positions.first();
+            positions.remove(index);
+            hash ^= zobristKey(index, n);
+        }
     }
+    return hash;
+}
 
-    forAllBlockAreas([&](const Area &area) -> bool {
-        fixUniquePossibilities(board, area);
-        return true;
-    });
+/** The finalizer of SplitMix64, which spreads every bit over all bits. */
+std::uint64_t mixBits(std::uint64_t x) noexcept {
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return x ^ (x >> 31);
 }
 
-static void repeatNonAssumptionProcess(Board<PossibilitySet> &board) noexcept {
-    Board<PossibilitySet> oldBoard;
-    do {
-        oldBoard = board;
-        eliminateImpossibilities(board);
-        fixUniquePossibilities(board);
-    } while (board != oldBoard);
+/**
+ * Returns the random bits that choose the branch of a propagated board in
+ * random orders. They depend only on the board and the seed, so every
+ * search with the seed, and every shard and resumed run of it, branches
+ * alike.
+ */
+template <typename State>
+std::uint64_t boardNoise(const State &board, std::uint64_t seed) noexcept {
+    return mixBits(hashBoard(board) ^ mixBits(seed));
 }
 
-static void iterateSolutionsWithAssumption(
-        const Board<PossibilitySet> &board,
-        std::function<void(const Board<Number> &solution)> resultCallback)
-        noexcept(noexcept(resultCallback(Board<Number>()))) {
-    Position pos = findPositionWithLeastPossibilities(board);
+/**
+ * Returns the unsolved position with the fewest candidates chosen by the
+ * tie-break: for DEGREE, the one that has the most unsolved peers (in the
+ * graph, for a variant), the first one in row-major order in case of a tie;
+ * for RANDOM, one chosen by the noise. The board must be propagated and not
+ * solved.
+ */
+template <typename State>
+Position tieBreakPosition(
+        const State &board, TieBreak tieBreak, std::uint64_t noise) {
+    std::array<std::size_t, N * N> counts;
+    std::size_t leastCount = N + 1, ties = 0;
+    for (Number index = 0; index < N * N; index++) {
+        counts[index] = candidates(board, CellSet::position(index)).count();
+        if (counts[index] <= 1 || counts[index] > leastCount)
+            continue;
+        if (counts[index] < leastCount) {
+            leastCount = counts[index];
+            ties = 0;
+        }
+        ties++;
+    }
 
-    board[pos].forAllPossibleNumbers([&](Number n) -> bool {
-        Board<PossibilitySet> nextBoard = board;
-        nextBoard[pos] = PossibilitySet(n);
-        iterateSolutions(nextBoard, resultCallback);
-        return true;
-    });
+    std::size_t tie = static_cast<std::size_t>(noise % ties);
+    Number bestIndex = 0;
+    std::size_t mostPeers = 0;
+    bool found = false;
+    for (Number index = 0; index < N * N; index++) {
+        if (counts[index] != leastCount)
+            continue;
+        if (tieBreak == TieBreak::RANDOM) {
+            if (tie-- == 0)
+                return CellSet::position(index);
+            continue;
+        }
+
+        std::size_t peers = 0;
+        for (CellSet cells = positionPeers(board, index);
+                !cells.isEmpty(); ) {
+            Number peer = cells.first();
+            cells.remove(peer);
+            if (counts[peer] > 1)
+                peers++;
+        }
+        if (!found || peers > mostPeers) {
+            bestIndex = index;
+            mostPeers = peers;
+            found = true;
+        }
+    }
+    return CellSet::position(bestIndex);
 }
 
-void iterateSolutions(
-        Board<PossibilitySet> &board,
-        std::function<void(const Board<Number> &solution)> resultCallback)
-        noexcept(noexcept(resultCallback(Board<Number>()))) {
-    repeatNonAssumptionProcess(board);
+bool usesNoise(const SearchOptions &options) noexcept {
+    return options.tieBreak == TieBreak::RANDOM ||
+            options.valueOrder == ValueOrder::RANDOM;
+}
 
-    switch (classify(board)) {
+/**
+ * Propagates the board and, if it is not solved, chooses the position to
+ * branch on as the options say and sets the noise for random orders.
+ */
+template <typename State>
+BoardState visitBoard(
+        State &board,
+        Position &branch,
+        std::uint64_t &noise,
+        const SearchOptions &options) noexcept {
+    BoardState state = propagate(board, branch, options);
+    if (state != BoardState::UNSOLVED)
+        return state;
+    if (usesNoise(options))
+        noise = boardNoise(board, options.seed);
+    if (options.tieBreak != TieBreak::FIRST)
+        branch = tieBreakPosition(board, options.tieBreak, noise);
+    return state;
+}
+
+/**
+ * Removes and returns the number to try next. A random order depends on the
+ * noise and the number of untried numbers only.
+ */
+Number takeNumber(
+        PossibilitySet &untried,
+        ValueOrder order,
+        std::uint64_t noise) noexcept {
+    Number n = untried.first();
+    switch (order) {
+    case ValueOrder::ASCENDING:
+        break;
+    case ValueOrder::DESCENDING:
+        n = untried.last();
+        break;
+    case ValueOrder::RANDOM: {
+        std::size_t count = untried.count();
+        PossibilitySet rest = untried;
+        for (std::uint64_t k = mixBits(noise + count) % count; k > 0; k--)
+            rest.remove(rest.first());
+        n = rest.first();
+        break;
+    }
+    }
+    untried.remove(n);
+    return n;
+}
+
+/**
+ * A board being searched, with the position where the search branches and
+ * the numbers at that position that are yet to be tried, which are tried in
+ * an order chosen by the noise if the order is random. With a
+ * transposition table, the frame also has the hash of the board as it was
+ * pushed and as it is after propagation, and counts the solutions found
+ * below it.
+ */
+template <typename State>
+struct SearchFrame {
+    State board;
+    Position position;
+    PossibilitySet untried;
+    std::uint64_t noise;
+    std::uint64_t key;
+    std::uint64_t propagatedKey;
+    std::size_t solutions;
+};
+
+/**
+ * Search frames of the current thread. Frames are reused from search to
+ * search, so a search allocates nothing once the stack has grown to the
+ * deepest search seen on the thread.
+ */
+template <typename State>
+ArenaStack<SearchFrame<State>> &searchStack() {
+    thread_local ArenaStack<SearchFrame<State>> stack;
+    return stack;
+}
+
+/** Restores the size of a search stack when a search finishes. */
+template <typename Stack>
+class SearchStackGuard {
+
+private:
+
+    Stack &mStack;
+    std::size_t mBase;
+
+public:
+
+    explicit SearchStackGuard(Stack &stack) noexcept :
+            mStack(stack), mBase(stack.size()) { }
+    SearchStackGuard(const SearchStackGuard &) = delete;
+    SearchStackGuard &operator=(const SearchStackGuard &) = delete;
+    ~SearchStackGuard() { mStack.popTo(mBase); }
+
+    std::size_t base() const noexcept {
+        return mBase;
+    }
+
+};
+
+/**
+ * Counts the units of a sharded search (see Shard): the boards at the shard
+ * depth and the solutions above it, visiting the tree above the shard depth
+ * in the same order as the search. Returns false if the budget ran out.
+ */
+template <typename State>
+bool countShardUnits(
+        const State &board,
+        std::size_t depth,
+        const SearchOptions &options,
+        SearchBudget &budget,
+        std::size_t &units) {
+    if (depth == options.shard.depth) {
+        units++;
+        return true;
+    }
+    if (!budget.consume())
+        return false;
+
+    State propagated = board;
+    Position position;
+    std::uint64_t noise = 0;
+    switch (visitBoard(propagated, position, noise, options)) {
     case BoardState::SOLVED:
-        Board<Number> solution;
-        convert(board, solution);
-        resultCallback(solution);
-        return;
+        units++;
+        return true;
     case BoardState::INSOLVABLE:
-        return;
+        return true;
     case BoardState::UNSOLVED:
-        iterateSolutionsWithAssumption(board, resultCallback);
-        return;
+        break;
+    }
+
+    for (PossibilitySet untried = candidates(propagated, position);
+            !untried.isEmpty(); ) {
+        Number n = takeNumber(untried, options.valueOrder, noise);
+        State child = propagated;
+        assume(child, position, n);
+        if (!countShardUnits(child, depth + 1, options, budget, units))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * The depth-first search of searchSolutions and countSolutions with an
+ * explicit stack of frames on the thread's search stack, so the callback may
+ * start another search. If "countOnly" is true, the callback is not called
+ * and only the number of solutions is added to "count".
+ *
+ * With a transposition table, every fully searched board is stored with the
+ * number of its solutions, both as it was pushed and as it was propagated.
+ * A child whose board is stored is not visited again, and a board whose
+ * propagated form is stored is not searched further, if the board is dead
+ * or if only counting.
+ *
+ * With more than one shard, the units of the search are counted first, and
+ * only the boards at the shard depth and the solutions above it whose unit
+ * falls in the shard's range are visited.
+ *
+ * A checkpoint is taken after a board is visited, when every frame on the
+ * stack has been propagated, and a search resumed from one pushes the saved
+ * frames and goes on to the next branch.
+ */
+template <typename State>
+bool search(
+        const Board<PossibilitySet> &board,
+        const std::function<bool(const Board<PossibilitySet> &)>
+                &resultCallback,
+        SearchBudget &budget,
+        const SearchOptions &options,
+        bool countOnly,
+        std::size_t &count) {
+    TranspositionTable *table = options.table;
+    const Shard &shard = options.shard;
+    const SearchCheckpoint *resume = options.resume;
+    std::size_t unit = 0, firstUnit = 0, lastUnit = 1;
+    if (resume != nullptr) {
+        unit = resume->unit;
+        firstUnit = resume->firstUnit;
+        lastUnit = resume->lastUnit;
+        count += resume->count;
+        if (shard.count > 1)
+            table = nullptr;
+    } else if (shard.count > 1) {
+        std::size_t units = 0;
+        if (!countShardUnits(makeState<State>(board, options), 0, options,
+                    budget, units))
+            return false;
+        firstUnit = units * shard.index / shard.count;
+        lastUnit = units * (shard.index + 1) / shard.count;
+        table = nullptr;
+    }
+    // Returns true if the next unit belongs to the shard.
+    auto nextUnitIsOurs = [&]() {
+        std::size_t current = unit++;
+        return shard.count <= 1 ||
+                (firstUnit <= current && current < lastUnit);
+    };
+
+    ArenaStack<SearchFrame<State>> &stack = searchStack<State>();
+    SearchStackGuard<ArenaStack<SearchFrame<State>>> guard(stack);
+    Board<PossibilitySet> scratch;
+
+    if (resume != nullptr) {
+        for (const SearchCheckpoint::Frame &saved : resume->frames) {
+            SearchFrame<State> &frame = stack.push();
+            frame.board = makeState<State>(saved.board, options);
+            frame.position = saved.position;
+            frame.untried = saved.untried;
+            frame.noise = usesNoise(options) ?
+                    boardNoise(frame.board, options.seed) : 0;
+            frame.key = frame.propagatedKey =
+                    table != nullptr ? hashBoard(frame.board) : 0;
+            frame.solutions = saved.solutions;
+        }
+    } else {
+        SearchFrame<State> &root = stack.push();
+        root.board = makeState<State>(board, options);
+        root.solutions = 0;
+        root.noise = 0;
+        root.key = root.propagatedKey = 0;
+        if (shard.depth == 0 && !nextUnitIsOurs())
+            return true;
+        if (table != nullptr) {
+            root.key = root.propagatedKey = zobristHash(board);
+            std::size_t solutions;
+            if (table->lookup(root.key, solutions) &&
+                    (solutions == 0 || countOnly)) {
+                count += solutions;
+                return true;
+            }
+        }
+    }
+
+    // Pops the top frame, whose subtree has been fully searched.
+    auto finish = [&]() {
+        const SearchFrame<State> &top = stack.top();
+        std::size_t solutions = top.solutions;
+        if (table != nullptr) {
+            table->store(top.key, solutions);
+            if (top.propagatedKey != top.key)
+                table->store(top.propagatedKey, solutions);
+        }
+        stack.pop();
+        if (stack.size() > guard.base())
+            stack.top().solutions += solutions;
+    };
+
+    // Saves the frames, all of which have been propagated.
+    const bool checkpointing = static_cast<bool>(options.checkpoint);
+    std::size_t nodesToCheckpoint = options.checkpointInterval;
+    auto takeCheckpoint = [&]() {
+        SearchCheckpoint checkpoint;
+        checkpoint.frames.resize(stack.size() - guard.base());
+        for (std::size_t i = 0; i < checkpoint.frames.size(); i++) {
+            SearchFrame<State> &frame = stack[guard.base() + i];
+            SearchCheckpoint::Frame &saved = checkpoint.frames[i];
+            saved.board = solutionBoard(frame.board, scratch);
+            saved.position = frame.position;
+            saved.untried = frame.untried;
+            saved.solutions = frame.solutions;
+        }
+        checkpoint.count = count;
+        checkpoint.unit = unit;
+        checkpoint.firstUnit = firstUnit;
+        checkpoint.lastUnit = lastUnit;
+        return options.checkpoint(checkpoint);
+    };
+
+    const bool measuring = static_cast<bool>(options.enterPhase);
+
+    // A resumed search starts by finding the next branch.
+    for (bool visit = resume == nullptr; ; visit = true) {
+        if (visit) {
+            // Visit the board on the top of the stack.
+            SearchFrame<State> &frame = stack.top();
+            if (!budget.consume())
+                return false;
+
+            if (measuring)
+                options.enterPhase(SearchPhase::PROPAGATE);
+            BoardState state = visitBoard(
+                    frame.board, frame.position, frame.noise, options);
+            if (measuring)
+                options.enterPhase(SearchPhase::SEARCH);
+
+            switch (state) {
+            case BoardState::SOLVED:
+                if (stack.size() - guard.base() <= shard.depth &&
+                        !nextUnitIsOurs()) {
+                    finish();
+                    break;
+                }
+                frame.solutions = 1;
+                count++;
+                if (!countOnly &&
+                        !resultCallback(solutionBoard(frame.board, scratch)))
+                    return false;
+                finish();
+                break;
+            case BoardState::INSOLVABLE:
+                finish();
+                break;
+            case BoardState::UNSOLVED:
+                frame.untried = candidates(frame.board, frame.position);
+                if (table == nullptr)
+                    break;
+
+                // Different boards may propagate to the same one.
+                frame.propagatedKey = hashBoard(frame.board);
+                std::size_t solutions;
+                if (frame.propagatedKey != frame.key &&
+                        table->lookup(frame.propagatedKey, solutions) &&
+                        (solutions == 0 || countOnly)) {
+                    frame.solutions = solutions;
+                    frame.untried = PossibilitySet();
+                    count += solutions;
+                }
+                break;
+            }
+
+            if (checkpointing && --nodesToCheckpoint == 0) {
+                nodesToCheckpoint = options.checkpointInterval;
+                if (stack.size() > guard.base() && !takeCheckpoint())
+                    return false;
+            }
+        }
+
+        // Find the next branch to visit.
+        for (;;) {
+            if (stack.size() == guard.base())
+                return true;
+
+            SearchFrame<State> &parent = stack.top();
+            if (parent.untried.isEmpty()) {
+                finish();
+                continue;
+            }
+
+            Number n = takeNumber(
+                    parent.untried, options.valueOrder, parent.noise);
+            if (stack.size() - guard.base() == shard.depth &&
+                    !nextUnitIsOurs())
+                continue;
+
+            std::uint64_t key = 0;
+            if (table != nullptr) {
+                PossibilitySet removed =
+                        candidates(parent.board, parent.position) -
+                        PossibilitySet(n);
+                key = parent.propagatedKey ^ zobristHash(
+                        CellSet::index(parent.position), removed);
+
+                std::size_t solutions;
+                if (table->lookup(key, solutions) &&
+                        (solutions == 0 || countOnly)) {
+                    parent.solutions += solutions;
+                    count += solutions;
+                    continue;
+                }
+            }
+
+            SearchFrame<State> &child = stack.push();
+            child.board = parent.board;
+            assume(child.board, parent.position, n);
+            child.key = child.propagatedKey = key;
+            child.solutions = 0;
+            child.noise = 0;
+            break;
+        }
     }
 }
 
+} // namespace
+
+/**
+ * Searches the given board for solutions, calling back for each solution
+ * found. Returns false if the search was stopped before the whole tree was
+ * explored, either because the callback returned false or because the budget
+ * ran out.
+ */
+bool searchSolutions(
+        const Board<PossibilitySet> &board,
+        std::function<bool(const Board<PossibilitySet> &solution)>
+                resultCallback,
+        SearchBudget &budget,
+        const SearchOptions &options)
+        noexcept(noexcept(resultCallback(Board<PossibilitySet>()))) {
+    std::size_t count = 0;
+    if (options.graph != nullptr)
+        return search<GraphBoard>(board, resultCallback, budget,
+                options, false, count);
+    switch (options.backend) {
+    case Backend::CELLS:
+        break;
+    case Backend::BITBOARD:
+        return search<BitBoard>(board, resultCallback, budget,
+                options, false, count);
+    }
+    return search<Board<PossibilitySet>>(board, resultCallback, budget,
+            options, false, count);
+}
+
+bool countSolutions(
+        const Board<PossibilitySet> &board,
+        std::size_t &count,
+        SearchBudget &budget,
+        const SearchOptions &options)
+        noexcept {
+    std::function<bool(const Board<PossibilitySet> &)> noCallback;
+    count = 0;
+    if (options.graph != nullptr)
+        return search<GraphBoard>(board, noCallback, budget,
+                options, true, count);
+    switch (options.backend) {
+    case Backend::CELLS:
+        break;
+    case Backend::BITBOARD:
+        return search<BitBoard>(board, noCallback, budget,
+                options, true, count);
+    }
+    return search<Board<PossibilitySet>>(board, noCallback, budget,
+            options, true, count);
+}
+
 void iterateSolutions(
         const Board<PossibilitySet> &board,
-        std::function<void(const Board<Number> &solution)> resultCallback)
+        std::function<void(const Board<Number> &solution)> resultCallback,
+        const SearchOptions &options)
         noexcept(noexcept(resultCallback(Board<Number>()))) {
-    Board<PossibilitySet> copyBoard(board);
-    iterateSolutions(copyBoard, resultCallback);
+    SearchBudget budget;
+    searchSolutions(board, [&](const Board<PossibilitySet> &solvedBoard) {
+        Board<Number> solution;
+        convert(solvedBoard, solution);
+        resultCallback(solution);
+        return true;
+    }, budget, options);
+}
+
+/** Solves the board with a single search. */
+static SolveResult solveOnce(
+        const Board<PossibilitySet> &board,
+        Board<Number> &solution,
+        SearchBudget &budget,
+        const SearchOptions &options)
+        noexcept {
+    std::size_t count = 0;
+    bool completed = searchSolutions(board,
+            [&](const Board<PossibilitySet> &solvedBoard) -> bool {
+                if (count++ == 0)
+                    convert(solvedBoard, solution);
+                return count < 2;
+            }, budget, options);
+
+    if (count >= 2)
+        return SolveResult::MULTIPLE;
+    if (!completed)
+        return SolveResult::ABORTED;
+    return count == 1 ? SolveResult::UNIQUE : SolveResult::INSOLVABLE;
+}
+
+SolveResult solve(
+        const Board<PossibilitySet> &board,
+        Board<Number> &solution,
+        SearchBudget &budget,
+        const SearchOptions &options)
+        noexcept {
+    if (options.restartUnit == 0)
+        return solveOnce(board, solution, budget, options);
+
+    // The seeds of the runs follow from the seed, so the result is the same
+    // every time for the same seed and node limit.
+    SearchOptions runOptions = options;
+    for (std::size_t run = 0; ; run++) {
+        std::size_t nodeLimit;
+        if (__builtin_mul_overflow(
+                    lubyTerm(run), options.restartUnit, &nodeLimit))
+            nodeLimit = SearchBudget::unlimited;
+        runOptions.seed = options.seed + run * UINT64_C(0x9e3779b97f4a7c15);
+
+        SearchBudget runBudget = budget.part(nodeLimit);
+        SolveResult result = solveOnce(board, solution, runBudget, runOptions);
+        budget.charge(runBudget);
+        if (result != SolveResult::ABORTED || budget.isExhausted())
+            return result;
+    }
+}
+
+SolveResult solve(
+        const Board<Number> &problem,
+        Board<Number> &solution,
+        SearchBudget &budget,
+        const SearchOptions &options)
+        noexcept {
+    if (options.enterPhase)
+        options.enterPhase(SearchPhase::CONVERT);
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+    if (options.enterPhase)
+        options.enterPhase(SearchPhase::SEARCH);
+    return solve(board, solution, budget, options);
 }
 
 
@@ -2,19 +2,406 @@
 #define INCLUDED_SOLVER_HH 1
 
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <string>
+#include <vector>
 #include "Board.hh"
 
 
-extern void eliminateImpossibilities(Board<PossibilitySet> &board) noexcept;
+/**
+ * Limits the amount of work a search may do. Every board visited by the
+ * search consumes one node. A budget may also have a deadline and a cancel
+ * flag set by another thread, which are checked every few nodes.
+ */
+class SearchBudget {
 
-extern void fixUniquePossibilities(Board<PossibilitySet> &board) noexcept;
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t unlimited =
+            std::numeric_limits<std::size_t>::max();
+
+private:
+
+    std::size_t mNodeLimit;
+    std::size_t mNodes = 0;
+    bool mHasDeadline = false;
+    bool mExhausted = false;
+    /** True if the deadline passed or the search was cancelled. */
+    bool mInterrupted = false;
+    Clock::time_point mDeadline;
+    const std::atomic<bool> *mCancelled = nullptr;
+
+public:
+
+    explicit SearchBudget(std::size_t nodeLimit = unlimited) noexcept :
+            mNodeLimit(nodeLimit) { }
+
+    SearchBudget &setTimeLimit(Clock::duration timeLimit) {
+        mHasDeadline = true;
+        mDeadline = Clock::now() + timeLimit;
+        return *this;
+    }
+
+    /** Makes the budget run out once the flag is set. */
+    SearchBudget &setCancelFlag(const std::atomic<bool> &cancelled) noexcept {
+        mCancelled = &cancelled;
+        return *this;
+    }
+
+    std::size_t nodes() const noexcept {
+        return mNodes;
+    }
+
+    bool isExhausted() const noexcept {
+        return mExhausted;
+    }
+
+    /**
+     * Consumes one node. Returns false if the budget has run out. The
+     * deadline and the cancel flag are checked on the first node and every
+     * 64th node after it.
+     */
+    bool consume() noexcept;
+
+    /**
+     * Returns a budget for part of the work of this one, with no nodes
+     * consumed, a node limit of at most "nodeLimit" and the same deadline
+     * and cancel flag.
+     */
+    SearchBudget part(std::size_t nodeLimit) const noexcept;
+
+    /**
+     * Consumes the nodes of a part. This budget runs out if the part ran out
+     * of anything but its own node limit.
+     */
+    void charge(const SearchBudget &part) noexcept;
+
+};
+
+enum class SolveResult {
+    UNIQUE, MULTIPLE, INSOLVABLE, ABORTED,
+};
+
+extern const char *solveResultName(SolveResult result) noexcept;
+
+/** How the search represents the boards it visits. */
+enum class Backend {
+    /** Boards of possibility sets, propagated by the functions below. */
+    CELLS,
+    /** Digit-major bitboards (see BitBoard). */
+    BITBOARD,
+};
+
+extern const char *backendName(Backend backend) noexcept;
+
+extern bool parseBackend(const std::string &name, Backend &backend) noexcept;
+
+class TranspositionTable;
+
+/**
+ * One of "count" shards of a search. The boards at the shard depth of the
+ * search tree and the solutions found above it are the units of the search,
+ * and each shard visits a contiguous range of them in search order, so the
+ * shards together visit the whole tree once and their solutions, taken in
+ * shard order, come in the same order as in a search without shards.
+ */
+struct Shard {
+    std::size_t index = 0;
+    std::size_t count = 1;
+    std::size_t depth = 4;
+};
+
+/** Parses "i/N", counting shards from zero. */
+extern bool parseShard(const std::string &text, Shard &shard) noexcept;
+
+/**
+ * A search stopped between two branches, from which it can be resumed. The
+ * frames are the propagated boards on the path from the root to the board
+ * visited last, each with the position where it branches and the numbers
+ * there that are yet to be tried. A search that has finished has no frames.
+ */
+struct SearchCheckpoint {
+    struct Frame {
+        Board<PossibilitySet> board;
+        Position position;
+        PossibilitySet untried;
+        /** The solutions found below the board so far. */
+        std::size_t solutions = 0;
+    };
+
+    std::vector<Frame> frames;
+    /** The solutions found so far. */
+    std::size_t count = 0;
+    /** The next unit of a sharded search and the range of the shard. */
+    std::size_t unit = 0, firstUnit = 0, lastUnit = 1;
+};
+
+/** The order in which the search tries the numbers at a position. */
+enum class ValueOrder {
+    ASCENDING, DESCENDING,
+    /** An order chosen from the seed and the board. */
+    RANDOM,
+};
+
+/** Which position with the fewest candidates the search branches on. */
+enum class TieBreak {
+    /** The first one in row-major order. */
+    FIRST,
+    /** The one with the most unsolved peers, then the first one. */
+    DEGREE,
+    /** One chosen from the seed and the board. */
+    RANDOM,
+};
+
+extern const char *valueOrderName(ValueOrder order) noexcept;
+
+extern bool parseValueOrder(const std::string &name, ValueOrder &order)
+        noexcept;
+
+extern const char *tieBreakName(TieBreak tieBreak) noexcept;
+
+extern bool parseTieBreak(const std::string &name, TieBreak &tieBreak)
+        noexcept;
+
+/**
+ * Returns the index-th term (from zero) of the Luby sequence 1, 1, 2, 1, 1,
+ * 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ...
+ */
+extern std::size_t lubyTerm(std::size_t index) noexcept;
+
+/** The parts of the work of solve that enterPhase tells apart. */
+enum class SearchPhase {
+    /** Converting the problem to a board of candidates. */
+    CONVERT,
+    /** Propagating the constraints of a board visited by the search. */
+    PROPAGATE,
+    /** Everything else the search does: branching, bookkeeping, output. */
+    SEARCH,
+};
+
+class ConstraintGraph;
+
+struct SearchOptions {
+    Backend backend = Backend::CELLS;
+    /**
+     * If not null, the search propagates the constraints of the graph
+     * instead of the rows, columns and blocks of the classic grid, and the
+     * backend is not used. A transposition table must not be shared by
+     * searches of different graphs.
+     */
+    const ConstraintGraph *graph = nullptr;
+    /**
+     * If set, the cells backend calls this after propagating the singles of
+     * an unsolved board, to apply stronger deductions. If it returns true,
+     * meaning it removed some candidates, the singles are propagated again
+     * and so on. The other backends and graphs do not use it.
+     */
+    std::function<bool(Board<PossibilitySet> &board)> deduce;
+    ValueOrder valueOrder = ValueOrder::ASCENDING;
+    TieBreak tieBreak = TieBreak::FIRST;
+    /**
+     * Random orders are a function of the seed and the board searched, so
+     * a search visits the same tree every time for the same seed.
+     */
+    std::uint64_t seed = 0;
+    /**
+     * If not 0, solve gives up every search after a number of nodes that
+     * follows the Luby sequence times this unit and restarts with another
+     * seed. This is useful only with random orders.
+     */
+    std::size_t restartUnit = 0;
+    /**
+     * If not null, the search stores the results of fully searched boards
+     * in the table and skips boards known to be dead. The table may be
+     * shared by any searches in the same thread.
+     */
+    TranspositionTable *table = nullptr;
+    /**
+     * The part of the search tree to visit. The transposition table is not
+     * used by a search split into more than one shard.
+     */
+    Shard shard;
+    /**
+     * If not null, the search continues from the checkpoint, which must have
+     * been taken by a search of the same board with the same backend and
+     * shard, instead of starting from the board.
+     */
+    const SearchCheckpoint *resume = nullptr;
+    /**
+     * If set, called with a checkpoint after every checkpointInterval
+     * nodes, unless the search has just finished. The search stops if it
+     * returns false.
+     */
+    std::function<bool(const SearchCheckpoint &checkpoint)> checkpoint;
+    std::size_t checkpointInterval = 1000000;
+    /**
+     * If set, called whenever the search enters another phase, which is
+     * twice for every board visited, so that the phases can be measured.
+     */
+    std::function<void(SearchPhase phase)> enterPhase;
+};
+
+/*
+ * The propagation functions below run for every node of the search, so they
+ * loop over positions directly instead of going through the std::function
+ * callbacks of Area, which would allocate for every position visited. They
+ * are defined here as constexpr so that puzzles can also be solved in
+ * constant expressions (see StaticSolver.hh).
+ */
+
+/**
+ * Removes the numbers of the solved positions from their peers with the unit
+ * masks of the board. A solved position whose number is also solved in a
+ * peer becomes empty. Returns true if any position changed.
+ */
+constexpr bool eliminateImpossibilities(Board<PossibilitySet> &board)
+        noexcept {
+    UnitMasks placed, duplicated;
+    for (Position pi; pi.isValid(); pi.down()) {
+        for (Position pos = pi; pos.isValid(); pos.right()) {
+            const PossibilitySet &pset = board[pos];
+            if (!pset.isUnique())
+                continue;
+
+            Number n = pset.first();
+            if (!placed.canPlace(pos, n))
+                duplicated.place(pos, n);
+            placed.place(pos, n);
+        }
+    }
+
+    bool changed = false;
+    for (Position pi; pi.isValid(); pi.down()) {
+        for (Position pos = pi; pos.isValid(); pos.right()) {
+            PossibilitySet &pset = board[pos];
+            PossibilitySet old = pset;
+            if (!pset.isUnique())
+                pset -= placed.used(pos);
+            else if (!duplicated.canPlace(pos, pset.first()))
+                pset = PossibilitySet();
+            changed |= pset != old;
+        }
+    }
+    return changed;
+}
+
+/**
+ * Finds the numbers that can occur at exactly one position in the given area
+ * and makes the possibility at that position unique. The numbers occurring
+ * once are found in one pass with two masks: the numbers seen at least once
+ * and those seen at least twice. Returns true if any position changed.
+ */
+constexpr bool fixUniquePossibilities(
+        Board<PossibilitySet> &board,
+        const Area &area)
+        noexcept {
+    PossibilitySet once, twice;
+    const Position &end = area.bottomRight();
+    for (Position pi = area.topLeft(); pi.i() < end.i(); pi.down()) {
+        for (Position pos = pi; pos.j() < end.j(); pos.right()) {
+            const PossibilitySet &pset = board[pos];
+            twice |= once & pset;
+            once |= pset;
+        }
+    }
+
+    PossibilitySet unique = once - twice;
+    if (unique.isEmpty())
+        return false;
+
+    bool changed = false;
+    for (Position pi = area.topLeft(); pi.i() < end.i(); pi.down()) {
+        for (Position pos = pi; pos.j() < end.j(); pos.right()) {
+            PossibilitySet found = board[pos] & unique;
+            if (!found.isEmpty()) {
+                // If several numbers are unique here, the last one wins.
+                PossibilitySet fixed(found.last());
+                changed |= board[pos] != fixed;
+                board[pos] = fixed;
+            }
+        }
+    }
+    return changed;
+}
+
+/** Returns true if any position changed. */
+constexpr bool fixUniquePossibilities(Board<PossibilitySet> &board)
+        noexcept {
+    bool changed = false;
+    for (Number n = 0; n < N; n++) {
+        changed |= fixUniquePossibilities(board, rowArea(n));
+        changed |= fixUniquePossibilities(board, columnArea(n));
+    }
+
+    for (Position pi; pi.isValid(); pi.down(Nsub))
+        for (Position pj = pi; pj.isValid(); pj.right(Nsub))
+            changed |= fixUniquePossibilities(board, blockArea(pj));
+    return changed;
+}
+
+constexpr void repeatNonAssumptionProcess(Board<PossibilitySet> &board)
+        noexcept {
+    bool changed = true;
+    while (changed) {
+        changed = eliminateImpossibilities(board);
+        changed |= fixUniquePossibilities(board);
+    }
+}
 
 extern void iterateSolutions(
         const Board<PossibilitySet> &board,
-        std::function<void(const Board<Number> &solution)> resultCallback)
+        std::function<void(const Board<Number> &solution)> resultCallback,
+        const SearchOptions &options = SearchOptions())
         noexcept(noexcept(resultCallback(Board<Number>())));
 
+extern bool searchSolutions(
+        const Board<PossibilitySet> &board,
+        std::function<bool(const Board<PossibilitySet> &solution)>
+                resultCallback,
+        SearchBudget &budget,
+        const SearchOptions &options = SearchOptions())
+        noexcept(noexcept(resultCallback(Board<PossibilitySet>())));
+
+/**
+ * Counts the solutions of the board without calling back for each. Returns
+ * false if the budget ran out, in which case "count" has the solutions found
+ * so far. With a transposition table, counts of boards already searched are
+ * reused.
+ */
+extern bool countSolutions(
+        const Board<PossibilitySet> &board,
+        std::size_t &count,
+        SearchBudget &budget,
+        const SearchOptions &options = SearchOptions())
+        noexcept;
+
+/**
+ * Solves the board, looking for at most two solutions so that the uniqueness
+ * of the first one is known. The first solution found is stored in the
+ * "solution" argument.
+ */
+extern SolveResult solve(
+        const Board<PossibilitySet> &board,
+        Board<Number> &solution,
+        SearchBudget &budget,
+        const SearchOptions &options = SearchOptions())
+        noexcept;
+
+/** Converts the problem to candidates and solves it. */
+extern SolveResult solve(
+        const Board<Number> &problem,
+        Board<Number> &solution,
+        SearchBudget &budget,
+        const SearchOptions &options = SearchOptions())
+        noexcept;
+
 
 #endif // #ifndef INCLUDED_SOLVER_HH
 
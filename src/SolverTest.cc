@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <vector>
+#include "ConstraintGraph.hh"
 #include "Solver.hh"
 #include "Tester.inl"
 
+using std::istringstream;
+
 
 static void setUnique(Board<PossibilitySet> &board, Position pos, Number n) {
     auto eliminate = [&](Position pos2) -> bool {
@@ -86,9 +93,295 @@ static void testApplyUniquePossibilities() {
     test_assert(actualBoard == expectedBoard);
 }
 
+static Board<Number> parseBoard(const char *text) {
+    Board<Number> board;
+    istringstream is(text);
+    is >> board;
+    return board;
+}
+
+static const char problemText[] =
+        "1 0 0 4 0 0 7 0 9\n"
+        "0 5 0 7 8 0 0 2 0\n"
+        "7 0 9 0 2 3 0 0 6\n"
+        "3 0 0 6 0 0 0 0 0\n"
+        "6 4 0 0 7 0 0 1 2\n"
+        "9 0 8 0 0 2 0 4 5\n"
+        "2 3 0 5 0 4 8 0 0\n"
+        "0 6 0 0 9 0 0 3 0\n"
+        "8 0 7 0 0 1 0 6 4\n";
+
+static const char solutionText[] =
+        "1 2 3 4 5 6 7 8 9\n"
+        "4 5 6 7 8 9 1 2 3\n"
+        "7 8 9 1 2 3 4 5 6\n"
+        "3 1 2 6 4 5 9 7 8\n"
+        "6 4 5 9 7 8 3 1 2\n"
+        "9 7 8 3 1 2 6 4 5\n"
+        "2 3 1 5 6 4 8 9 7\n"
+        "5 6 4 8 9 7 2 3 1\n"
+        "8 9 7 2 3 1 5 6 4\n";
+
+static void testSolve(Backend backend) {
+    SearchOptions options;
+    options.backend = backend;
+
+    Board<Number> problem = parseBoard(problemText), solution;
+    SearchBudget budget1;
+    test_assert(solve(problem, solution, budget1, options) ==
+            SolveResult::UNIQUE);
+    test_assert(solution == parseBoard(solutionText));
+    test_assert(!budget1.isExhausted());
+
+    Board<Number> emptyProblem;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        emptyProblem[pos] = N;
+        return true;
+    });
+    SearchBudget budget2;
+    test_assert(solve(emptyProblem, solution, budget2, options) ==
+            SolveResult::MULTIPLE);
+
+    SearchBudget budget3(1);
+    test_assert(solve(emptyProblem, solution, budget3, options) ==
+            SolveResult::ABORTED);
+    test_assert(budget3.isExhausted());
+    test_assert(budget3.nodes() == 1);
+
+    problem[Position(0, 1)] = 0;
+    SearchBudget budget4;
+    test_assert(solve(problem, solution, budget4, options) ==
+            SolveResult::INSOLVABLE);
+}
+
+/** Returns the problem without its first two rows, with 120 solutions. */
+static Board<PossibilitySet> openBoard() {
+    Board<Number> problem = parseBoard(problemText);
+    for (Number i = 0; i < 2; i++)
+        for (Number j = 0; j < N; j++)
+            problem[Position(i, j)] = N;
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+    return board;
+}
+
+static std::vector<Board<Number>> allSolutions(
+        const Board<PossibilitySet> &board, const SearchOptions &options) {
+    std::vector<Board<Number>> all;
+    SearchBudget budget;
+    test_assert(searchSolutions(board,
+            [&](const Board<PossibilitySet> &solution) -> bool {
+                all.emplace_back();
+                convert(solution, all.back());
+                return true;
+            }, budget, options));
+    return all;
+}
+
+static void testOrders(Backend backend) {
+    SearchOptions options;
+    options.backend = backend;
+    Board<PossibilitySet> board = openBoard();
+    std::vector<Board<Number>> ascending = allSolutions(board, options);
+    test_assert(ascending.size() == 120);
+
+    // The positions branched on do not depend on the value order, so the
+    // descending order finds the same solutions in reverse.
+    for (TieBreak tieBreak : {TieBreak::FIRST, TieBreak::DEGREE}) {
+        options.tieBreak = tieBreak;
+        options.valueOrder = ValueOrder::ASCENDING;
+        std::vector<Board<Number>> forward = allSolutions(board, options);
+        options.valueOrder = ValueOrder::DESCENDING;
+        std::vector<Board<Number>> backward = allSolutions(board, options);
+        test_assert(std::vector<Board<Number>>(
+                    backward.rbegin(), backward.rend()) == forward);
+        if (tieBreak == TieBreak::FIRST)
+            test_assert(forward == ascending);
+        else
+            test_assert(std::is_permutation(
+                    forward.begin(), forward.end(), ascending.begin()));
+    }
+}
+
+/** Returns the position the search branches on at the root of the board. */
+static Position rootBranch(
+        const Board<PossibilitySet> &board, SearchOptions options) {
+    Position branch(N, N);
+    options.checkpointInterval = 1;
+    options.checkpoint = [&](const SearchCheckpoint &checkpoint) -> bool {
+        branch = checkpoint.frames.at(0).position;
+        return false;
+    };
+    SearchBudget budget;
+    searchSolutions(board,
+            [](const Board<PossibilitySet> &) -> bool { return true; },
+            budget, options);
+    return branch;
+}
+
+static void testDegreeTies() {
+    // Without constraints, two open positions have no unsolved peers, and
+    // the first one is taken.
+    ConstraintGraph graph;
+    Board<PossibilitySet> board;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board[pos] = PossibilitySet(0);
+        return true;
+    });
+    board[Position(0, 0)] = board[Position(4, 4)] = PossibilitySet::full();
+
+    SearchOptions options;
+    options.graph = &graph;
+    options.tieBreak = TieBreak::DEGREE;
+    test_assert(rootBranch(board, options) == Position(0, 0));
+
+    // Only the positions of the unit have peers in the graph.
+    std::vector<Position> column;
+    for (Number i = 0; i < N; i++)
+        column.emplace_back(i, N - 1);
+    graph.addUnit(column);
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        board[pos] = PossibilitySet::full();
+        return true;
+    });
+    test_assert(rootBranch(board, options) == Position(0, N - 1));
+}
+
+static void testRandomOrders(Backend backend) {
+    SearchOptions options;
+    options.backend = backend;
+    Board<PossibilitySet> board = openBoard();
+    std::vector<Board<Number>> ascending = allSolutions(board, options);
+
+    options.tieBreak = TieBreak::RANDOM;
+    options.valueOrder = ValueOrder::RANDOM;
+    std::vector<Board<Number>> first, again, other;
+    options.seed = 1;
+    first = allSolutions(board, options);
+    again = allSolutions(board, options);
+    options.seed = 2;
+    other = allSolutions(board, options);
+    test_assert(first == again);
+    test_assert(first != other);
+    test_assert(std::is_permutation(
+            first.begin(), first.end(), ascending.begin()));
+    test_assert(std::is_permutation(
+            other.begin(), other.end(), ascending.begin()));
+}
+
+static void testRestarts(Backend backend) {
+    static const std::size_t luby[] = {
+        1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, 1,
+    };
+    for (std::size_t i = 0; i < sizeof luby / sizeof *luby; i++)
+        test_assert(lubyTerm(i) == luby[i]);
+
+    SearchOptions options;
+    options.backend = backend;
+    options.tieBreak = TieBreak::RANDOM;
+    options.valueOrder = ValueOrder::RANDOM;
+    options.restartUnit = 1;
+
+    Board<Number> problem = parseBoard(problemText), solution;
+    SearchBudget budget1;
+    test_assert(solve(problem, solution, budget1, options) ==
+            SolveResult::UNIQUE);
+    test_assert(solution == parseBoard(solutionText));
+
+    Board<Number> emptyProblem;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        emptyProblem[pos] = N;
+        return true;
+    });
+    Board<Number> solution2, solution3;
+    SearchBudget budget2, budget3;
+    test_assert(solve(emptyProblem, solution2, budget2, options) ==
+            SolveResult::MULTIPLE);
+    test_assert(solve(emptyProblem, solution3, budget3, options) ==
+            SolveResult::MULTIPLE);
+    test_assert(solution2 == solution3);
+    test_assert(budget2.nodes() == budget3.nodes());
+
+    // The runs share the node limit of the budget.
+    SearchBudget budget4(10);
+    test_assert(solve(emptyProblem, solution, budget4, options) ==
+            SolveResult::ABORTED);
+    test_assert(budget4.isExhausted());
+    test_assert(budget4.nodes() == 10);
+
+    // Even runs of a node or two see the cancel flag.
+    std::atomic<bool> cancelled(true);
+    SearchBudget budget5;
+    budget5.setCancelFlag(cancelled);
+    test_assert(solve(emptyProblem, solution, budget5, options) ==
+            SolveResult::ABORTED);
+    test_assert(budget5.isExhausted());
+    test_assert(budget5.nodes() == 1);
+}
+
+static void testShards(
+        Backend backend,
+        TieBreak tieBreak,
+        ValueOrder valueOrder = ValueOrder::ASCENDING) {
+    SearchOptions options;
+    options.backend = backend;
+    options.tieBreak = tieBreak;
+    options.valueOrder = valueOrder;
+
+    Board<PossibilitySet> board = openBoard();
+    std::vector<Board<Number>> all = allSolutions(board, options);
+    test_assert(all.size() == 120);
+
+    for (std::size_t depth : {0, 1, 2, 5, 30}) {
+        std::vector<Board<Number>> merged;
+        std::size_t total = 0;
+        options.shard.count = 3;
+        options.shard.depth = depth;
+        for (options.shard.index = 0; options.shard.index < 3;
+                options.shard.index++) {
+            SearchBudget shardBudget;
+            test_assert(searchSolutions(board,
+                    [&](const Board<PossibilitySet> &solution) -> bool {
+                        merged.emplace_back();
+                        convert(solution, merged.back());
+                        return true;
+                    }, shardBudget, options));
+
+            std::size_t count;
+            SearchBudget countBudget;
+            test_assert(countSolutions(board, count, countBudget, options));
+            total += count;
+        }
+        test_assert(merged == all);
+        test_assert(total == all.size());
+    }
+
+    Shard shard;
+    test_assert(parseShard("2/5", shard));
+    test_assert(shard.index == 2);
+    test_assert(shard.count == 5);
+    test_assert(!parseShard("5/5", shard));
+    test_assert(!parseShard("1/", shard));
+    test_assert(!parseShard("-1/5", shard));
+    test_assert(!parseShard("15", shard));
+}
+
 static void testAll() {
     testEliminateImpossibilities();
     testApplyUniquePossibilities();
+    testSolve(Backend::CELLS);
+    testSolve(Backend::BITBOARD);
+    testOrders(Backend::CELLS);
+    testOrders(Backend::BITBOARD);
+    testDegreeTies();
+    testShards(Backend::CELLS, TieBreak::FIRST);
+    testShards(Backend::BITBOARD, TieBreak::FIRST);
+    testShards(Backend::CELLS, TieBreak::DEGREE);
+    testShards(Backend::BITBOARD, TieBreak::RANDOM, ValueOrder::RANDOM);
+    testRandomOrders(Backend::CELLS);
+    testRandomOrders(Backend::BITBOARD);
+    testRestarts(Backend::CELLS);
+    testRestarts(Backend::BITBOARD);
 }
 
 int main() {
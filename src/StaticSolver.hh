@@ -0,0 +1,142 @@
+#ifndef INCLUDED_STATICSOLVER_HH
+#define INCLUDED_STATICSOLVER_HH 1
+
+
+#include <cstddef>
+#include <stdexcept>
+#include "Board.hh"
+#include "Solver.hh"
+
+
+/*
+ * Solving in constant expressions, so that a table of puzzles can be solved
+ * by the compiler and cost nothing at run time:
+ *
+ *   constexpr StaticSolution daily = solveStatically(parseStatically(
+ *           "100400709050780020709023006300600000640070012"
+ *           "908002045230504800060090030807001064"));
+ *   static_assert(daily.result == SolveResult::UNIQUE, "not unique");
+ *
+ * The search propagates with repeatNonAssumptionProcess, the same code that
+ * the cells backend runs, and branches on the first position with the
+ * fewest candidates like classifyAndFindBranch, but it recurses instead of
+ * keeping an explicit stack and has none of the options of solve.
+ * Compilers limit the work of a constant expression (see
+ * -fconstexpr-ops-limit in GCC), so a puzzle that needs a long search may
+ * still have to be solved at run time.
+ */
+
+struct StaticSolution {
+    SolveResult result;
+    /** The first solution found, unless the result is INSOLVABLE. */
+    Board<Number> solution{};
+};
+
+/**
+ * Parses N * N digits like parseLine, where 0 or '.' is a blank. In a
+ * constant expression, a line that is not exactly N * N digits does not
+ * compile; at run time, std::invalid_argument is thrown instead.
+ */
+constexpr Board<Number> parseStatically(const char *line) {
+    std::size_t length = 0;
+    while (length <= N * N && line[length] != '\0')
+        length++;
+    if (length != N * N)
+        throw std::invalid_argument("a line does not have N * N digits");
+
+    Board<Number> board{};
+    for (Number index = 0; index < N * N; index++) {
+        char c = line[index];
+        if (c == '0' || c == '.')
+            board.data()[index] = N;
+        else if ('1' <= c && c <= static_cast<char>('0' + N))
+            board.data()[index] = static_cast<Number>(c - '1');
+        else
+            throw std::invalid_argument("a line has a non-digit");
+    }
+    return board;
+}
+
+/**
+ * Returns the state of a board and, if it is UNSOLVED, the first position
+ * in row-major order with the fewest possibilities, like
+ * classifyAndFindBranch.
+ */
+constexpr BoardState classifyStatically(
+        const Board<PossibilitySet> &board,
+        Position &branch)
+        noexcept {
+    std::size_t leastCount = N + 1;
+    for (Position pi; pi.isValid(); pi.down()) {
+        for (Position pos = pi; pos.isValid(); pos.right()) {
+            std::size_t count = board[pos].count();
+            if (count == 0)
+                return BoardState::INSOLVABLE;
+            if (count > 1 && count < leastCount) {
+                leastCount = count;
+                branch = pos;
+            }
+        }
+    }
+    return leastCount > N ? BoardState::SOLVED : BoardState::UNSOLVED;
+}
+
+/**
+ * Searches the problem until two solutions are found in all, counting the
+ * "found" ones found before, and stores the first one in "solution".
+ * Returns the solutions found in all.
+ */
+constexpr std::size_t searchStatically(
+        const Board<PossibilitySet> &problem,
+        Board<Number> &solution,
+        std::size_t found)
+        noexcept {
+    Board<PossibilitySet> board = problem;
+    repeatNonAssumptionProcess(board);
+    Position branch;
+    switch (classifyStatically(board, branch)) {
+    case BoardState::INSOLVABLE:
+        return found;
+    case BoardState::SOLVED:
+        if (found == 0)
+            for (Number index = 0; index < N * N; index++)
+                solution.data()[index] = board.data()[index].first();
+        return found + 1;
+    case BoardState::UNSOLVED:
+        break;
+    }
+
+    for (PossibilitySet untried = board[branch];
+            !untried.isEmpty() && found < 2; ) {
+        Number n = untried.first();
+        untried.remove(n);
+        Board<PossibilitySet> child = board;
+        child[branch] = PossibilitySet(n);
+        found = searchStatically(child, solution, found);
+    }
+    return found;
+}
+
+/** Solves the problem like solve, in a constant expression if need be. */
+constexpr StaticSolution solveStatically(const Board<Number> &problem)
+        noexcept {
+    Board<PossibilitySet> board{};
+    convertToCandidates(problem, board);
+    StaticSolution solution{SolveResult::INSOLVABLE};
+    switch (searchStatically(board, solution.solution, 0)) {
+    case 0:
+        break;
+    case 1:
+        solution.result = SolveResult::UNIQUE;
+        break;
+    default:
+        solution.result = SolveResult::MULTIPLE;
+        break;
+    }
+    return solution;
+}
+
+
+#endif // #ifndef INCLUDED_STATICSOLVER_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
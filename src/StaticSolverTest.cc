@@ -0,0 +1,73 @@
+#include <stdexcept>
+#include "Board.hh"
+#include "Format.hh"
+#include "Solver.hh"
+#include "StaticSolver.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+/** The README problem with a second 1 in the first row. */
+static constexpr const char conflictLine[] =
+        "110400709050780020709023006300600000640070012"
+        "908002045230504800060090030807001064";
+
+/** A table of puzzles solved by the compiler. */
+static constexpr StaticSolution solutions[] = {
+    solveStatically(parseStatically(problemLine)),
+    solveStatically(parseStatically(openProblemLine)),
+    solveStatically(parseStatically(conflictLine)),
+};
+
+static_assert(solutions[0].result == SolveResult::UNIQUE,
+        "the README problem has a unique solution");
+static_assert(solutions[0].solution[Position(0, 1)] == 1,
+        "the solution has 2 next to the given 1");
+static_assert(solutions[1].result == SolveResult::MULTIPLE,
+        "the open problem has many solutions");
+static_assert(solutions[2].result == SolveResult::INSOLVABLE,
+        "a conflicting problem has no solution");
+
+static void testSolutions() {
+    Board<Number> expected;
+    parseLine(solutionLine, expected);
+    test_assert(solutions[0].solution == expected);
+
+    // The first solution is the one that solve finds.
+    Board<Number> problem, solution;
+    parseLine(openProblemLine, problem);
+    SearchBudget budget;
+    test_assert(solve(problem, solution, budget) == SolveResult::MULTIPLE);
+    test_assert(solutions[1].solution == solution);
+}
+
+static void testRunTime() {
+    Board<Number> problem;
+    parseLine(problemLine, problem);
+    test_assert(parseStatically(problemLine) == problem);
+
+    StaticSolution solution = solveStatically(problem);
+    test_assert(solution.result == SolveResult::UNIQUE);
+    test_assert(solution.solution == solutions[0].solution);
+
+    bool thrown = false;
+    try {
+        parseStatically("123");
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    test_assert(thrown);
+}
+
+static void testAll() {
+    testSolutions();
+    testRunTime();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
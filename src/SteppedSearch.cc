@@ -0,0 +1,52 @@
+#include <utility>
+#include "SteppedSearch.hh"
+
+using std::size_t;
+
+
+SteppedSearch::SteppedSearch(
+        const Board<PossibilitySet> &board,
+        const SearchOptions &options) :
+        mBoard(board), mOptions(options) {
+    mOptions.resume = nullptr;
+}
+
+bool SteppedSearch::step(size_t nodes) {
+    if (mFinished)
+        return true;
+
+    // The first checkpoint after the given nodes stops the step.
+    bool stopped = false;
+    SearchOptions options = mOptions;
+    options.resume = mStarted ? &mCheckpoint : nullptr;
+    options.checkpointInterval = nodes;
+    options.checkpoint = [this, &stopped](const SearchCheckpoint &checkpoint) {
+        mCheckpoint = checkpoint;
+        stopped = true;
+        return false;
+    };
+
+    SearchBudget budget;
+    searchSolutions(mBoard, [this](const Board<PossibilitySet> &solution) {
+        mSolutions.emplace_back();
+        convert(solution, mSolutions.back());
+        mSolutionCount++;
+        return true;
+    }, budget, options);
+
+    mStarted = true;
+    mFinished = !stopped;
+    mNodes += budget.nodes();
+    return mFinished;
+}
+
+bool SteppedSearch::takeSolution(Board<Number> &solution) {
+    if (mSolutions.empty())
+        return false;
+    solution = std::move(mSolutions.front());
+    mSolutions.pop_front();
+    return true;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,71 @@
+#ifndef INCLUDED_STEPPEDSEARCH_HH
+#define INCLUDED_STEPPEDSEARCH_HH 1
+
+
+#include <cstddef>
+#include <deque>
+#include "Board.hh"
+#include "Solver.hh"
+
+
+/**
+ * A search for all solutions of a board that runs in steps of a bounded
+ * number of nodes, so that a single-threaded event loop can interleave it
+ * with other work. Between steps, the search is kept as a checkpoint (see
+ * SearchOptions::resume), and the next step resumes from it.
+ *
+ * The search finds the same solutions in the same order as
+ * iterateSolutions with the same options, with or without a transposition
+ * table. The checkpoint options are used by the steps themselves.
+ */
+class SteppedSearch {
+
+private:
+
+    Board<PossibilitySet> mBoard;
+    SearchOptions mOptions;
+    SearchCheckpoint mCheckpoint;
+    bool mStarted = false;
+    bool mFinished = false;
+    std::size_t mNodes = 0;
+    std::size_t mSolutionCount = 0;
+    std::deque<Board<Number>> mSolutions;
+
+public:
+
+    explicit SteppedSearch(
+            const Board<PossibilitySet> &board,
+            const SearchOptions &options = SearchOptions());
+
+    /**
+     * Advances the search by "nodes" nodes, which must not be 0, or fewer if
+     * it finishes first. Returns true if the search has finished.
+     */
+    bool step(std::size_t nodes);
+
+    bool isFinished() const noexcept {
+        return mFinished;
+    }
+
+    /** The nodes of all steps so far. */
+    std::size_t nodes() const noexcept {
+        return mNodes;
+    }
+
+    /** The number of solutions found so far, taken or not. */
+    std::size_t solutionCount() const noexcept {
+        return mSolutionCount;
+    }
+
+    /**
+     * Takes the earliest solution found and not taken yet. Returns false if
+     * there is none.
+     */
+    bool takeSolution(Board<Number> &solution);
+
+};
+
+
+#endif // #ifndef INCLUDED_STEPPEDSEARCH_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,76 @@
+#include <vector>
+#include "Board.hh"
+#include "Format.hh"
+#include "Solver.hh"
+#include "SteppedSearch.hh"
+#include "TranspositionTable.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+
+
+/** Runs the search to the end in steps of "nodes" nodes. */
+static std::vector<Board<Number>> runSteps(
+        SteppedSearch &search, std::size_t nodes) {
+    std::vector<Board<Number>> solutions;
+    Board<Number> solution;
+    std::size_t steps = 0;
+    while (!search.step(nodes)) {
+        steps++;
+        test_assert(search.nodes() == steps * nodes);
+        while (search.takeSolution(solution))
+            solutions.push_back(solution);
+    }
+    while (search.takeSolution(solution))
+        solutions.push_back(solution);
+    test_assert(search.nodes() <= (steps + 1) * nodes);
+    return solutions;
+}
+
+static void testSteps(Backend backend, TranspositionTable *table = nullptr) {
+    Board<Number> problem;
+    parseLine(openProblemLine, problem);
+    Board<PossibilitySet> board;
+    convertToCandidates(problem, board);
+
+    SearchOptions options;
+    options.backend = backend;
+    std::vector<Board<Number>> all;
+    iterateSolutions(board, [&](const Board<Number> &solution) {
+        all.push_back(solution);
+    }, options);
+
+    options.table = table;
+    SteppedSearch search(board, options);
+    test_assert(runSteps(search, 5) == all);
+    test_assert(search.nodes() > 10 * 5);
+    test_assert(search.isFinished());
+    test_assert(search.solutionCount() == all.size());
+    test_assert(search.step(5));
+    Board<Number> solution;
+    test_assert(!search.takeSolution(solution));
+
+    if (table != nullptr) {
+        // Resumed steps may skip the dead boards the table now knows, and
+        // the solutions stay the same.
+        SteppedSearch again(board, options);
+        test_assert(runSteps(again, 5) == all);
+        test_assert(again.nodes() <= search.nodes());
+    }
+}
+
+static void testAll() {
+    testSteps(Backend::CELLS);
+    testSteps(Backend::BITBOARD);
+    TranspositionTable table(1 << 12);
+    testSteps(Backend::CELLS, &table);
+    table.clear();
+    testSteps(Backend::BITBOARD, &table);
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,33 @@
+#ifndef INCLUDED_TESTPUZZLES_INL
+#define INCLUDED_TESTPUZZLES_INL 1
+
+
+/*
+ * The puzzles the tests share, each on one line of 81 characters with '0'
+ * for a blank (see parseLine).
+ */
+
+/** The problem of the README, which singles alone solve. */
+static constexpr const char problemLine[] =
+        "100400709050780020709023006300600000640070012"
+        "908002045230504800060090030807001064";
+
+/** The unique solution of problemLine. */
+static constexpr const char solutionLine[] =
+        "123456789456789123789123456312645978645978312"
+        "978312645231564897564897231897231564";
+
+/** The README problem without its first two rows, with 120 solutions. */
+static constexpr const char openProblemLine[] =
+        "000000000000000000709023006300600000640070012"
+        "908002045230504800060090030807001064";
+
+/** A problem with a unique solution that singles alone do not find. */
+static constexpr const char hardProblemLine[] =
+        "100000002090400050006000700050903000000070000"
+        "000850040700000600030009080002000001";
+
+
+#endif // #ifndef INCLUDED_TESTPUZZLES_INL
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,76 @@
+#include <utility>
+#include "ThreadPool.hh"
+
+using std::size_t;
+using std::unique_lock;
+
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0)
+        threadCount = 1;
+    mThreads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++)
+        mThreads.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        unique_lock<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    for (std::thread &thread : mThreads)
+        thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        unique_lock<std::mutex> lock(mMutex);
+        mTasks.push_back(std::move(task));
+    }
+    mCondition.notify_one();
+}
+
+void ThreadPool::run(size_t count, std::function<void(size_t index)> task) {
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t remaining = count;
+
+    for (size_t index = 0; index < count; index++) {
+        submit([&, index] {
+            task(index);
+
+            unique_lock<std::mutex> lock(mutex);
+            if (--remaining == 0)
+                condition.notify_one();
+        });
+    }
+
+    unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&] { return remaining == 0; });
+}
+
+void ThreadPool::work() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] {
+                return mStopping || !mTasks.empty();
+            });
+            if (mTasks.empty())
+                return;
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+        task();
+    }
+}
+
+size_t defaultThreadCount() noexcept {
+    size_t count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,56 @@
+#ifndef INCLUDED_THREADPOOL_HH
+#define INCLUDED_THREADPOOL_HH 1
+
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * A fixed number of worker threads that run submitted tasks in submission
+ * order. The destructor waits for all queued tasks to finish.
+ */
+class ThreadPool {
+
+private:
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::function<void()>> mTasks;
+    std::vector<std::thread> mThreads;
+    bool mStopping = false;
+
+    void work();
+
+public:
+
+    explicit ThreadPool(std::size_t threadCount);
+    ThreadPool(const ThreadPool &pool) = delete;
+    ~ThreadPool();
+    ThreadPool &operator=(const ThreadPool &pool) = delete;
+
+    std::size_t size() const noexcept {
+        return mThreads.size();
+    }
+
+    void submit(std::function<void()> task);
+
+    /**
+     * Runs task(0), ..., task(count - 1) in the pool and waits for all of
+     * them to finish.
+     */
+    void run(std::size_t count, std::function<void(std::size_t index)> task);
+
+};
+
+extern std::size_t defaultThreadCount() noexcept;
+
+
+#endif // #ifndef INCLUDED_THREADPOOL_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <array>
+#include "TranspositionTable.hh"
+
+using std::array;
+using std::size_t;
+using std::uint64_t;
+
+
+namespace {
+
+/** Keys generated once from a fixed seed with SplitMix64. */
+struct ZobristKeys {
+
+    array<array<uint64_t, N>, N * N> keys;
+
+    ZobristKeys() noexcept {
+        uint64_t state = 0x5eed5eed5eed5eedu;
+        for (array<uint64_t, N> &cellKeys : keys) {
+            for (uint64_t &key : cellKeys) {
+                uint64_t z = (state += 0x9e3779b97f4a7c15u);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+                key = z ^ (z >> 31);
+            }
+        }
+    }
+
+};
+
+const ZobristKeys zobristKeys;
+
+} // namespace
+
+uint64_t zobristKey(Number index, Number n) noexcept {
+    return zobristKeys.keys[index][n];
+}
+
+uint64_t zobristHash(Number index, const PossibilitySet &pset) noexcept {
+    const array<uint64_t, N> &cellKeys = zobristKeys.keys[index];
+    uint64_t hash = 0;
+    for (PossibilitySet::Bits bits = pset.bits(); bits != 0;
+            bits &= static_cast<PossibilitySet::Bits>(bits - 1))
+        hash ^= cellKeys[PossibilitySet::fromBits(bits).first()];
+    return hash;
+}
+
+uint64_t zobristHash(const Board<PossibilitySet> &board) noexcept {
+    const PossibilitySet *psets = board.data();
+    uint64_t hash = 0;
+    for (Number index = 0; index < N * N; index++)
+        hash ^= zobristHash(index, psets[index]);
+    return hash;
+}
+
+TranspositionTable::TranspositionTable(size_t capacity) {
+    size_t size = 1;
+    while (size <= capacity / 2)
+        size *= 2;
+    mEntries.resize(size);
+    mMask = size - 1;
+}
+
+void TranspositionTable::clear() noexcept {
+    std::fill(mEntries.begin(), mEntries.end(), Entry());
+    mHits = mStores = 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,95 @@
+#ifndef INCLUDED_TRANSPOSITIONTABLE_HH
+#define INCLUDED_TRANSPOSITIONTABLE_HH 1
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Board.hh"
+
+
+/**
+ * Zobrist hashing of candidate boards: every number at every position has a
+ * fixed random 64-bit key, and a board hashes to the XOR of the keys of all
+ * its candidates. Removing candidates from a position updates the hash by
+ * XORing their keys, so a child of a search node is hashed from its parent
+ * in time proportional to the removed candidates.
+ */
+extern std::uint64_t zobristKey(Number index, Number n) noexcept;
+
+/** Returns the XOR of the keys of the numbers at the position. */
+extern std::uint64_t zobristHash(Number index, const PossibilitySet &pset)
+        noexcept;
+
+extern std::uint64_t zobristHash(const Board<PossibilitySet> &board)
+        noexcept;
+
+/**
+ * A bounded, lossy table of search results keyed by Zobrist hashes. Each
+ * entry records the number of solutions of a fully searched candidate board;
+ * zero marks a dead state. The table is a power-of-two array indexed by the
+ * low bits of the hash, and a store always replaces the entry in its slot.
+ * Entries are matched by the full 64-bit hash, so two different boards are
+ * confused only if their hashes collide.
+ *
+ * A table is not thread-safe; give each thread its own.
+ */
+class TranspositionTable {
+
+private:
+
+    struct Entry {
+        std::uint64_t key = 0;
+        /** The number of solutions plus one, or zero for an empty slot. */
+        std::size_t value = 0;
+    };
+
+    std::vector<Entry> mEntries;
+    std::size_t mMask;
+    std::size_t mHits = 0;
+    std::size_t mStores = 0;
+
+public:
+
+    /** Constructs a table with the largest power of two <= capacity. */
+    explicit TranspositionTable(std::size_t capacity);
+    TranspositionTable(const TranspositionTable &table) = delete;
+    TranspositionTable &operator=(const TranspositionTable &table) = delete;
+
+    std::size_t capacity() const noexcept {
+        return mEntries.size();
+    }
+
+    std::size_t hits() const noexcept {
+        return mHits;
+    }
+
+    std::size_t stores() const noexcept {
+        return mStores;
+    }
+
+    /** Finds the solution count of the board with the hash, if stored. */
+    bool lookup(std::uint64_t key, std::size_t &solutions) noexcept {
+        const Entry &entry = mEntries[key & mMask];
+        if (entry.value == 0 || entry.key != key)
+            return false;
+        solutions = entry.value - 1;
+        mHits++;
+        return true;
+    }
+
+    void store(std::uint64_t key, std::size_t solutions) noexcept {
+        Entry &entry = mEntries[key & mMask];
+        entry.key = key;
+        entry.value = solutions + 1;
+        mStores++;
+    }
+
+    void clear() noexcept;
+
+};
+
+
+#endif // #ifndef INCLUDED_TRANSPOSITIONTABLE_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,122 @@
+#include <string>
+#include "Board.hh"
+#include "Solver.hh"
+#include "Tester.inl"
+#include "TranspositionTable.hh"
+
+
+static Board<PossibilitySet> lineBoard(const std::string &line) {
+    Board<PossibilitySet> board;
+    wholeArea.forAllPositions([&](Position pos) -> bool {
+        char c = line[pos.i() * N + pos.j()];
+        board[pos] = c == '0' ? PossibilitySet::full() :
+                PossibilitySet(static_cast<Number>(c - '1'));
+        return true;
+    });
+    return board;
+}
+
+/** A 17-clue puzzle with one clue moved, which has 1058 solutions. */
+static const char *const openLine =
+        "000000010400000000020000000000050407008000300"
+        "001090000300400200050100000000800006";
+
+static void testZobrist() {
+    Board<PossibilitySet> board = lineBoard(openLine);
+    std::uint64_t hash = zobristHash(board);
+    test_assert(hash != 0);
+    test_assert(zobristKey(0, 0) != zobristKey(0, 1));
+    test_assert(zobristKey(0, 0) != zobristKey(1, 0));
+
+    // Removing candidates updates the hash incrementally.
+    Position pos(4, 4);
+    Number index = pos.i() * N + pos.j();
+    PossibilitySet removed = PossibilitySet(2).add(7);
+    board[pos] -= removed;
+    test_assert(zobristHash(board) == (hash ^ zobristHash(index, removed)));
+}
+
+static void testTable() {
+    TranspositionTable table(1000);
+    test_assert(table.capacity() == 512);
+
+    std::size_t solutions = 99;
+    test_assert(!table.lookup(12345, solutions));
+    table.store(12345, 0);
+    test_assert(table.lookup(12345, solutions));
+    test_assert(solutions == 0);
+    table.store(12345 + 512, 7);
+    test_assert(!table.lookup(12345, solutions));
+    test_assert(table.lookup(12345 + 512, solutions));
+    test_assert(solutions == 7);
+    test_assert(table.hits() == 2);
+    test_assert(table.stores() == 2);
+
+    table.clear();
+    test_assert(!table.lookup(12345 + 512, solutions));
+    test_assert(TranspositionTable(0).capacity() == 1);
+}
+
+static void testCountSolutions(Backend backend) {
+    Board<PossibilitySet> board = lineBoard(openLine);
+    SearchOptions options;
+    options.backend = backend;
+
+    std::size_t expected = 0;
+    SearchBudget budget1;
+    test_assert(searchSolutions(board,
+            [&](const Board<PossibilitySet> &) -> bool {
+                expected++;
+                return true;
+            }, budget1, options));
+    test_assert(expected == 1058);
+
+    std::size_t count;
+    SearchBudget budget2;
+    test_assert(countSolutions(board, count, budget2, options));
+    test_assert(count == expected);
+    test_assert(budget2.nodes() == budget1.nodes());
+
+    TranspositionTable table(1 << 12);
+    options.table = &table;
+    SearchBudget budget3;
+    test_assert(countSolutions(board, count, budget3, options));
+    test_assert(count == expected);
+    test_assert(table.stores() > 0);
+
+    // The whole board is known now.
+    SearchBudget budget4;
+    test_assert(countSolutions(board, count, budget4, options));
+    test_assert(count == expected);
+    test_assert(budget4.nodes() == 0);
+
+    // Searching for the solutions still visits them, but not dead states.
+    std::size_t found = 0;
+    SearchBudget budget5;
+    test_assert(searchSolutions(board,
+            [&](const Board<PossibilitySet> &) -> bool {
+                found++;
+                return true;
+            }, budget5, options));
+    test_assert(found == expected);
+    test_assert(budget5.nodes() < budget1.nodes());
+
+    SearchBudget budget6(3);
+    options.table = nullptr;
+    test_assert(!countSolutions(board, count, budget6, options));
+}
+
+static void testAll() {
+    testZobrist();
+    testTable();
+    testCountSolutions(Backend::CELLS);
+    testCountSolutions(Backend::BITBOARD);
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,148 @@
+#include <array>
+#include "Validation.hh"
+
+using std::array;
+
+
+static const char *const unitKindNames[] = {
+    "row", "column", "block",
+};
+
+const char *unitKindName(UnitKind kind) noexcept {
+    return unitKindNames[static_cast<std::size_t>(kind)];
+}
+
+/**
+ * Finds the first unit where a number occurs twice. Each number is a bit in
+ * the masks of its three units; a bit that is already set in a unit mask
+ * marks the number as duplicated in that unit. Blanks are skipped.
+ */
+static Validation findConflict(const Board<Number> &board) noexcept {
+    // Rows, then columns, then blocks.
+    array<PossibilitySet::Bits, 3 * N> seen{}, duplicated{};
+
+    const Number *numbers = board.data();
+    for (Number i = 0; i < N; i++) {
+        for (Number j = 0; j < N; j++) {
+            Number n = numbers[i * N + j];
+            if (n >= N)
+                continue;
+
+            PossibilitySet::Bits bit =
+                    static_cast<PossibilitySet::Bits>(1u << n);
+            Number units[] = {
+                i, N + j, 2 * N + UnitMasks::blockIndex(Position(i, j)),
+            };
+            for (Number unit : units) {
+                duplicated[unit] |= seen[unit] & bit;
+                seen[unit] |= bit;
+            }
+        }
+    }
+
+    Validation validation;
+    for (Number unit = 0; unit < 3 * N; unit++) {
+        if (duplicated[unit] == 0)
+            continue;
+
+        validation.status = Validation::Status::CONFLICT;
+        validation.unitKind = static_cast<UnitKind>(unit / N);
+        validation.unit = unit % N;
+        validation.number =
+                PossibilitySet::fromBits(duplicated[unit]).first();
+        break;
+    }
+    return validation;
+}
+
+Validation validatePuzzle(const Board<Number> &puzzle) noexcept {
+    return findConflict(puzzle);
+}
+
+Validation verifySolution(
+        const Board<Number> &puzzle,
+        const Board<Number> &solution)
+        noexcept {
+    Validation validation;
+    const Number *givens = puzzle.data(), *numbers = solution.data();
+    for (Number index = 0; index < N * N; index++) {
+        if (numbers[index] >= N) {
+            validation.status = Validation::Status::INCOMPLETE;
+        } else if (givens[index] < N && givens[index] != numbers[index]) {
+            validation.status = Validation::Status::MISMATCH;
+        } else {
+            continue;
+        }
+        validation.position = Position(index / N, index % N);
+        return validation;
+    }
+
+    // A complete board without duplicates has every number in every unit.
+    return findConflict(solution);
+}
+
+std::ostream &operator<<(std::ostream &os, const Validation &validation) {
+    switch (validation.status) {
+    case Validation::Status::VALID:
+        return os << "valid";
+    case Validation::Status::CONFLICT:
+        return os << "conflict " << unitKindName(validation.unitKind) << ' ' <<
+                validation.unit + 1 << " number " << validation.number + 1;
+    case Validation::Status::INCOMPLETE:
+        return os << "incomplete " << validation.position.i() + 1 << ' ' <<
+                validation.position.j() + 1;
+    case Validation::Status::MISMATCH:
+        return os << "mismatch " << validation.position.i() + 1 << ' ' <<
+                validation.position.j() + 1;
+    }
+    return os;
+}
+
+bool validateStream(std::istream &is, std::ostream &os, BoardFormat format) {
+    Board<Number> problem;
+    bool validAll = true;
+    std::size_t number = 0;
+    for (ReadResult read; (read = readNextBoard(is, problem, format)) !=
+                ReadResult::END; ) {
+        number++;
+        if (read == ReadResult::MALFORMED) {
+            os << "malformed problem " << number << '\n';
+            validAll = false;
+            continue;
+        }
+        Validation validation = validatePuzzle(problem);
+        os << validation << '\n';
+        validAll = validAll && validation.isValid();
+    }
+    return validAll;
+}
+
+bool verifyStream(std::istream &is, std::ostream &os, BoardFormat format) {
+    Board<Number> problem, solution;
+    bool validAll = true;
+    std::size_t number = 0;
+    for (ReadResult read; (read = readNextBoard(is, problem, format)) !=
+                ReadResult::END; ) {
+        number++;
+        // The solution is read even after a malformed problem, so that the
+        // next pair starts at the next problem.
+        ReadResult solutionRead = readNextBoard(is, solution, format);
+        if (read == ReadResult::MALFORMED) {
+            os << "malformed problem " << number << '\n';
+        } else if (solutionRead == ReadResult::END) {
+            os << "missing solution " << number << '\n';
+        } else if (solutionRead == ReadResult::MALFORMED) {
+            os << "malformed solution " << number << '\n';
+        } else {
+            Validation validation = verifySolution(problem, solution);
+            os << validation << '\n';
+            validAll = validAll && validation.isValid();
+            continue;
+        }
+        validAll = false;
+    }
+    return validAll;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,94 @@
+#ifndef INCLUDED_VALIDATION_HH
+#define INCLUDED_VALIDATION_HH 1
+
+
+#include <iostream>
+#include "Board.hh"
+#include "Format.hh"
+
+
+enum class UnitKind {
+    ROW, COLUMN, BLOCK,
+};
+
+extern const char *unitKindName(UnitKind kind) noexcept;
+
+/** The outcome of validating a puzzle or verifying a solution. */
+struct Validation {
+
+    enum class Status {
+        /** No problem was found. */
+        VALID,
+        /** A number occurs twice in the unit. */
+        CONFLICT,
+        /** A solution has a blank at the position. */
+        INCOMPLETE,
+        /** A solution differs from a given of the puzzle at the position. */
+        MISMATCH,
+    };
+
+    Status status = Status::VALID;
+    /** The first conflicting unit: rows first, then columns, then blocks. */
+    UnitKind unitKind = UnitKind::ROW;
+    /** The index of the conflicting unit. Blocks are in row-major order. */
+    Number unit = 0;
+    /** The smallest number occurring twice in the conflicting unit. */
+    Number number = 0;
+    /** The first incomplete or mismatching position in row-major order. */
+    Position position;
+
+    bool isValid() const noexcept {
+        return status == Status::VALID;
+    }
+
+};
+
+/**
+ * Checks that no given number occurs twice in a row, column or block. This
+ * does not search, so a valid puzzle may still have no solution.
+ */
+extern Validation validatePuzzle(const Board<Number> &puzzle) noexcept;
+
+/**
+ * Checks that the solution is complete, keeps all givens of the puzzle, and
+ * has every number exactly once in every row, column and block.
+ */
+extern Validation verifySolution(
+        const Board<Number> &puzzle,
+        const Board<Number> &solution)
+        noexcept;
+
+/**
+ * Prints the validation on one line, such as "valid", "conflict row 3
+ * number 5" or "mismatch 2 7". Units, numbers and positions count from 1.
+ */
+extern std::ostream &operator<<(
+        std::ostream &os,
+        const Validation &validation);
+
+/**
+ * Validates every problem read from "is" and prints a line for each to
+ * "os". A problem that cannot be read is printed as "malformed problem N",
+ * counting from 1, and the next one is read. Returns true if every problem
+ * was read and valid.
+ */
+extern bool validateStream(
+        std::istream &is,
+        std::ostream &os,
+        BoardFormat format);
+
+/**
+ * Like validateStream, but reads pairs of a problem and a claimed solution
+ * and verifies the solution. A pair with a part that cannot be read is
+ * printed as "malformed problem N" or "malformed solution N", and a problem
+ * at the end without a solution as "missing solution N".
+ */
+extern bool verifyStream(
+        std::istream &is,
+        std::ostream &os,
+        BoardFormat format);
+
+
+#endif // #ifndef INCLUDED_VALIDATION_HH
+
+/* vim: set et sw=4 sts=4 tw=79: */
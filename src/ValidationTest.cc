@@ -0,0 +1,114 @@
+#include <sstream>
+#include <string>
+#include "Format.hh"
+#include "TestPuzzles.inl"
+#include "Tester.inl"
+#include "Validation.hh"
+
+using std::ostringstream;
+using std::string;
+
+
+static Board<Number> lineBoard(const string &line) {
+    Board<Number> board;
+    parseLine(line, board);
+    return board;
+}
+
+static string toString(const Validation &validation) {
+    ostringstream os;
+    os << validation;
+    return os.str();
+}
+
+static void testValidatePuzzle() {
+    Board<Number> puzzle = lineBoard(problemLine);
+    test_assert(validatePuzzle(puzzle).isValid());
+    test_assert(toString(validatePuzzle(puzzle)) == "valid");
+
+    // A 9 in row 4 column 3 conflicts with column 3 and block 4.
+    puzzle[Position(3, 2)] = 8;
+    Validation validation = validatePuzzle(puzzle);
+    test_assert(validation.status == Validation::Status::CONFLICT);
+    test_assert(validation.unitKind == UnitKind::COLUMN);
+    test_assert(validation.unit == 2);
+    test_assert(validation.number == 8);
+    test_assert(toString(validation) == "conflict column 3 number 9");
+
+    // A row conflict is reported before the column conflict.
+    puzzle[Position(5, 1)] = 7;
+    validation = validatePuzzle(puzzle);
+    test_assert(validation.unitKind == UnitKind::ROW);
+    test_assert(validation.unit == 5);
+    test_assert(validation.number == 7);
+
+    Board<Number> blockOnly = lineBoard(string(N * N, '0'));
+    blockOnly[Position(3, 3)] = blockOnly[Position(4, 4)] = 0;
+    validation = validatePuzzle(blockOnly);
+    test_assert(toString(validation) == "conflict block 5 number 1");
+}
+
+static void testVerifySolution() {
+    Board<Number> puzzle = lineBoard(problemLine);
+    Board<Number> solution = lineBoard(solutionLine);
+    test_assert(verifySolution(puzzle, solution).isValid());
+
+    Board<Number> incomplete = solution;
+    incomplete[Position(2, 6)] = N;
+    test_assert(toString(verifySolution(puzzle, incomplete)) ==
+            "incomplete 3 7");
+
+    // Swapping two numbers in a row keeps the rows valid.
+    Board<Number> swapped = solution;
+    std::swap(swapped[Position(0, 1)], swapped[Position(0, 2)]);
+    Validation validation = verifySolution(puzzle, swapped);
+    test_assert(validation.status == Validation::Status::CONFLICT);
+    test_assert(validation.unitKind == UnitKind::COLUMN);
+    test_assert(validation.unit == 1);
+
+    Board<Number> mismatch = solution;
+    std::swap(mismatch[Position(0, 0)], mismatch[Position(0, 1)]);
+    test_assert(toString(verifySolution(puzzle, mismatch)) ==
+            "mismatch 1 1");
+}
+
+static void testStreams() {
+    const string problem = problemLine, solution = solutionLine;
+
+    // A malformed line in the middle is reported and skipped.
+    std::istringstream problems(problem + "\n" +
+            problem.substr(1) + "\n" + problem + "\n");
+    std::ostringstream validations;
+    test_assert(!validateStream(problems, validations, BoardFormat::LINE));
+    test_assert(validations.str() == "valid\nmalformed problem 2\nvalid\n");
+
+    std::istringstream valid(problem + "\n" + problem + "\n");
+    std::ostringstream allValid;
+    test_assert(validateStream(valid, allValid, BoardFormat::LINE));
+    test_assert(allValid.str() == "valid\nvalid\n");
+
+    std::istringstream pairs(
+            "xyz\n" + solution + "\n" +
+            problem + "\n" + solution + "\n" +
+            problem + "\nxyz\n" +
+            problem + "\n");
+    std::ostringstream verifications;
+    test_assert(!verifyStream(pairs, verifications, BoardFormat::LINE));
+    test_assert(verifications.str() ==
+            "malformed problem 1\nvalid\nmalformed solution 3\n"
+            "missing solution 4\n");
+}
+
+static void testAll() {
+    testValidatePuzzle();
+    testVerifySolution();
+    testStreams();
+}
+
+int main() {
+    testAll();
+    return Tester::errors != 0;
+}
+
+
+/* vim: set et sw=4 sts=4 tw=79: */
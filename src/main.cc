@@ -1,25 +1,645 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "AutoTune.hh"
+#include "Benchmark.hh"
 #include "Board.hh"
+#include "Checkpoint.hh"
+#include "Counting.hh"
+#include "Format.hh"
+#include "Generator.hh"
+#include "Metrics.hh"
+#include "Options.hh"
+#include "PerfCounters.hh"
+#include "Portfolio.hh"
+#include "Rating.hh"
+#include "Server.hh"
+#include "SolutionCache.hh"
+#include "SolutionStream.hh"
 #include "Solver.hh"
+#include "ThreadPool.hh"
+#include "TranspositionTable.hh"
+#include "Validation.hh"
 
 
-int main() {
+/**
+ * Returns the size of the standard output if it is a regular file, or -1.
+ * The output must have been flushed.
+ */
+static std::int64_t outputSize() {
+    struct stat status;
+    if (fstat(STDOUT_FILENO, &status) != 0 || !S_ISREG(status.st_mode))
+        return -1;
+    return lseek(STDOUT_FILENO, 0, SEEK_CUR);
+}
+
+/**
+ * Prepares to resume from the checkpoint file if it exists, cutting the
+ * output back to its size at the checkpoint so that no solution is printed
+ * twice, and to save checkpoints to the file. A file that is not a
+ * checkpoint of the same problem and search options is refused rather than
+ * overwritten.
+ */
+static bool setUpCheckpoint(
+        const std::string &path,
+        const Board<Number> &problem,
+        CheckpointFile &checkpoint,
+        SearchOptions &search) {
+    LoadResult loaded = loadCheckpoint(path, checkpoint);
+    if (loaded == LoadResult::MALFORMED) {
+        std::cerr << "sudoku: " << path << " is not a valid checkpoint\n";
+        return false;
+    }
+    if (loaded == LoadResult::LOADED) {
+        if (!(checkpoint.problem == problem)) {
+            std::cerr << "sudoku: " << path <<
+                    " is a checkpoint of another problem\n";
+            return false;
+        }
+        if (!checkpoint.hasOptions(search)) {
+            std::cerr << "sudoku: " << path << " is a checkpoint of a "
+                    "search with another backend, order, tie-break, seed "
+                    "or shard\n";
+            return false;
+        }
+        if (checkpoint.outputSize >= 0) {
+            struct stat status;
+            if (fstat(STDOUT_FILENO, &status) != 0 ||
+                    status.st_size < checkpoint.outputSize ||
+                    ftruncate(STDOUT_FILENO, checkpoint.outputSize) != 0 ||
+                    lseek(STDOUT_FILENO, 0, SEEK_END) < 0) {
+                std::cerr << "sudoku: the output is shorter than at the "
+                        "checkpoint (append it with >>)\n";
+                return false;
+            }
+        }
+        search.resume = &checkpoint.search;
+    }
+
+    checkpoint.problem = problem;
+    checkpoint.setOptions(search);
+    search.checkpoint = [&checkpoint, path](const SearchCheckpoint &state) {
+        // The search has no use for the resumed checkpoint any more.
+        checkpoint.search = state;
+        checkpoint.outputSize = std::cout.flush() ? outputSize() : -1;
+        if (!saveCheckpoint(path, checkpoint))
+            std::cerr << "sudoku: cannot save " << path << '\n';
+        return true;
+    };
+    return true;
+}
+
+/** Measures the phases of solving if --stats is given. */
+static std::unique_ptr<PhaseStats> startStats(
+        const Options &options, SearchOptions &search) {
+    std::unique_ptr<PhaseStats> stats;
+    if (options.stats) {
+        stats.reset(new PhaseStats);
+        stats->enter(Phase::PARSE);
+        search.enterPhase = stats->searchPhaseCallback();
+    }
+    return stats;
+}
+
+static void enterPhase(const std::unique_ptr<PhaseStats> &stats, Phase phase)
+        noexcept {
+    if (stats != nullptr)
+        stats->enter(phase);
+}
+
+static void printStats(const std::unique_ptr<PhaseStats> &stats) {
+    if (stats == nullptr)
+        return;
+    stats->stop();
+    std::cerr << *stats;
+}
+
+static int solveProblem(const Options &options) {
+    SearchOptions search = options.search;
+    std::unique_ptr<PhaseStats> stats = startStats(options, search);
+
     Board<Number> problem;
-    if (!(std::cin >> problem)) {
+    if (!readBoard(std::cin, problem, options.format)) {
         std::cerr << "Cannot parse problem board.\n";
         return EXIT_FAILURE;
     }
 
+    enterPhase(stats, Phase::CONVERT);
     Board<PossibilitySet> problemPSBoard;
-    convert(problem, problemPSBoard);
+    convertToCandidates(problem, problemPSBoard);
+
+    CheckpointFile checkpoint;
+    if (!options.checkpointPath.empty() && !setUpCheckpoint(
+                options.checkpointPath, problem, checkpoint, search))
+        return EXIT_FAILURE;
 
-    bool foundSolution = false;
+    std::unique_ptr<SolutionWriter> writer;
+    if (options.packed)
+        writer.reset(new SolutionWriter(std::cout, problem));
+
+    enterPhase(stats, Phase::SEARCH);
+    bool foundSolution = checkpoint.search.count > 0;
     iterateSolutions(problemPSBoard, [&](const Board<Number> &solution) {
+        enterPhase(stats, Phase::OUTPUT);
         foundSolution = true;
-        std::cout << solution;
-    });
-    return foundSolution ? EXIT_SUCCESS : EXIT_FAILURE;
+        if (writer != nullptr)
+            writer->write(solution);
+        else
+            writeBoard(std::cout, solution, options.format);
+        enterPhase(stats, Phase::SEARCH);
+    }, search);
+
+    // The search has finished, so the next run starts over.
+    enterPhase(stats, Phase::OUTPUT);
+    if (writer != nullptr && !writer->finish()) {
+        std::cerr << "sudoku: cannot write the solutions\n";
+        return EXIT_FAILURE;
+    }
+    if (!options.checkpointPath.empty() && std::cout.flush())
+        std::remove(options.checkpointPath.c_str());
+    printStats(stats);
+
+    // Other shards may have the solutions.
+    return foundSolution || options.search.shard.count > 1 ?
+            EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Creates the metrics if an option asks for them, and starts exporting them
+ * if asked to. Returns false if the socket cannot be set up.
+ */
+static bool startMetrics(
+        const Options &options,
+        std::unique_ptr<Metrics> &metrics,
+        std::unique_ptr<MetricsExporter> &exporter) {
+    bool exported =
+            !options.metricsPath.empty() || !options.metricsSocketPath.empty();
+    if (!options.latency && !exported)
+        return true;
+    metrics.reset(new Metrics);
+    if (!exported)
+        return true;
+    try {
+        exporter.reset(new MetricsExporter(*metrics, options.metricsPath,
+                options.metricsSocketPath,
+                std::chrono::seconds(options.metricsInterval)));
+    } catch (const std::system_error &e) {
+        std::cerr << "sudoku: " << e.what() << '\n';
+        return false;
+    }
+    return true;
+}
+
+/** A board read from the input, or the note that it was malformed. */
+using InputBoard = std::pair<ReadResult, Board<Number>>;
+
+/**
+ * Reads up to options.autoTune problems into "pending", tunes the search
+ * options on the well-formed ones and saves the chosen profile if asked to.
+ */
+static bool tuneBatch(
+        const Options &options,
+        std::vector<InputBoard> &pending,
+        SearchOptions &search) {
+    std::vector<Board<Number>> sample;
+    Board<Number> problem;
+    ReadResult read;
+    while (sample.size() < options.autoTune && (read = readNextBoard(
+                    std::cin, problem, options.format)) != ReadResult::END) {
+        pending.emplace_back(read, problem);
+        if (read == ReadResult::BOARD)
+            sample.push_back(problem);
+    }
+
+    TuningProfile profile = autoTune(sample, search, options.nodeLimit);
+    profile.apply(search);
+    std::cerr << "auto-tune: propagation=" <<
+            propagationName(profile.propagation) << " backend=" <<
+            backendName(profile.backend) << " tie-break=" <<
+            tieBreakName(profile.tieBreak) << '\n';
+
+    if (!options.saveProfilePath.empty() &&
+            !saveProfile(options.saveProfilePath, profile)) {
+        std::cerr << "sudoku: cannot save " << options.saveProfilePath <<
+                '\n';
+        return false;
+    }
+    return true;
+}
+
+static int solveBatch(const Options &options) {
+    SolutionCache cache(options.cacheSize);
+    Board<Number> problem, solution;
+    bool solvedAll = true;
+
+    SearchOptions tuned = options.search;
+    std::vector<InputBoard> pending;
+    if (options.autoTune > 0 && !tuneBatch(options, pending, tuned))
+        return EXIT_FAILURE;
+
+    SearchOptions searchOptions = tuned;
+    std::unique_ptr<PhaseStats> stats = startStats(options, searchOptions);
+    PerfSample lastSample;
+    PhaseStats::Clock::duration lastTime{0};
+    std::size_t index = 0;
+    std::unique_ptr<TranspositionTable> table;
+    if (options.tableSize > 0) {
+        table.reset(new TranspositionTable(options.tableSize));
+        searchOptions.table = table.get();
+    }
+    std::unique_ptr<Portfolio> portfolio;
+    if (options.portfolio > 0)
+        portfolio.reset(new Portfolio(
+                defaultPortfolio(options.portfolio, tuned)));
+    std::unique_ptr<Metrics> metrics;
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!startMetrics(options, metrics, exporter))
+        return EXIT_FAILURE;
+
+    // Records the time since the last stage ended to the given one.
+    Metrics::Clock::time_point lapStart = Metrics::Clock::now();
+    auto lap = [&](Stage stage) {
+        if (metrics == nullptr)
+            return;
+        Metrics::Clock::time_point now = Metrics::Clock::now();
+        metrics->record(stage, now - lapStart);
+        lapStart = now;
+    };
+
+    auto solveOne = [&](const Board<Number> &current) {
+        index++;
+        lap(Stage::PARSE);
+        enterPhase(stats, Phase::SEARCH);
+        SearchBudget budget(options.nodeLimit);
+        SolutionCache::Solver solver = [&](
+                const Board<Number> &p, Board<Number> &s) {
+            return portfolio != nullptr ?
+                    portfolio->solve(p, s, budget).result :
+                    solve(p, s, budget, searchOptions);
+        };
+        SolveResult result = options.cacheSize > 0 ?
+                cache.solve(current, solution, solver) :
+                solver(current, solution);
+        lap(Stage::SOLVE);
+        if (metrics != nullptr)
+            metrics->count(result);
+
+        enterPhase(stats, Phase::OUTPUT);
+        std::cout << solveResultName(result) << '\n';
+        if (result == SolveResult::UNIQUE || result == SolveResult::MULTIPLE)
+            writeBoard(std::cout, solution, options.format);
+        else
+            solvedAll = false;
+        lap(Stage::WRITE);
+
+        if (stats != nullptr) {
+            // The problem from its parse to its output.
+            stats->enter(Phase::PARSE);
+            PerfSample sample = stats->totalSample();
+            PhaseStats::Clock::duration time = stats->totalTime();
+            std::cerr << "problem " << index << std::fixed <<
+                    std::setprecision(6) << " time=" <<
+                    std::chrono::duration<double>(time - lastTime).count() <<
+                    's' << sample - lastSample << '\n';
+            lastSample = sample;
+            lastTime = time;
+        }
+    };
+
+    auto answer = [&](ReadResult read, const Board<Number> &current) {
+        if (read == ReadResult::BOARD) {
+            solveOne(current);
+            return;
+        }
+        lap(Stage::PARSE);
+        if (metrics != nullptr)
+            metrics->countMalformed();
+        std::cout << "error malformed problem " << ++index << '\n';
+        solvedAll = false;
+    };
+
+    // The sample has been read for tuning, so it is answered first.
+    for (const InputBoard &input : pending)
+        answer(input.first, input.second);
+    for (ReadResult read;
+            (read = readNextBoard(std::cin, problem, options.format)) !=
+                ReadResult::END;
+            enterPhase(stats, Phase::PARSE))
+        answer(read, problem);
+    printStats(stats);
+    if (options.latency)
+        std::cerr << metrics->snapshot();
+    return solvedAll ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int serve(const Options &options) {
+    ThreadPool pool(
+            options.threads != 0 ? options.threads : defaultThreadCount());
+    SolutionCache cache(options.cacheSize);
+    std::unique_ptr<Portfolio> portfolio;
+    if (options.portfolio > 0)
+        portfolio.reset(new Portfolio(
+                defaultPortfolio(options.portfolio, options.search)));
+    std::unique_ptr<Metrics> metrics;
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!startMetrics(options, metrics, exporter))
+        return EXIT_FAILURE;
+    Server server(pool, options.nodeLimit,
+            options.cacheSize > 0 ? &cache : nullptr, options.search,
+            portfolio.get(), metrics.get());
+
+    if (options.socketPath.empty()) {
+        server.serve(std::cin, std::cout);
+        return EXIT_SUCCESS;
+    }
+
+    try {
+        server.serveUnixSocket(options.socketPath);
+    } catch (const std::system_error &e) {
+        std::cerr << "sudoku: " << e.what() << '\n';
+    }
+    return EXIT_FAILURE;
+}
+
+static int generate(const Options &options) {
+    ThreadPool pool(
+            options.threads != 0 ? options.threads : defaultThreadCount());
+    std::size_t misses = generateProblems(options.seed,
+            options.generateCount, options.generator, pool,
+            [&](const Board<Number> &problem) {
+                writeBoard(std::cout, problem, options.format);
+            });
+    if (!std::cout.flush())
+        return EXIT_FAILURE;
+    if (misses != 0) {
+        std::cerr << "sudoku: " << misses << " of " << options.generateCount <<
+                " problems are not rated " <<
+                difficultyName(options.generator.difficulty) << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static int rateProblems(const Options &options) {
+    ThreadPool pool(
+            options.threads != 0 ? options.threads : defaultThreadCount());
+    std::vector<Board<Number>> problems;
+    std::vector<Rating> ratings;
+    bool solvableAll = true;
+
+    std::vector<ReadResult> reads;
+    std::size_t number = 0;
+    for (;;) {
+        problems.resize(pool.size() * 256);
+        reads.resize(problems.size());
+        std::size_t count = 0;
+        while (count < problems.size() && (reads[count] = readNextBoard(
+                        std::cin, problems[count], options.format)) !=
+                    ReadResult::END)
+            count++;
+        if (count == 0)
+            break;
+
+        ratings.resize(count);
+        pool.run(count, [&](std::size_t index) {
+            if (reads[index] == ReadResult::BOARD)
+                ratings[index] = rate(problems[index]);
+        });
+        for (std::size_t index = 0; index < count; index++) {
+            number++;
+            if (reads[index] != ReadResult::BOARD) {
+                std::cout << "error malformed problem " << number << '\n';
+                solvableAll = false;
+                continue;
+            }
+            std::cout << ratings[index] << '\n';
+            solvableAll = solvableAll && ratings[index].solvable;
+        }
+    }
+    return solvableAll ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int validateProblems(const Options &options) {
+    return validateStream(std::cin, std::cout, options.format) ?
+            EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int verifySolutions(const Options &options) {
+    return verifyStream(std::cin, std::cout, options.format) ?
+            EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int countProblems(const Options &options) {
+    ThreadPool pool(
+            options.threads != 0 ? options.threads : defaultThreadCount());
+    Board<Number> problem;
+    bool countedAll = true;
+    std::size_t number = 0;
+    for (ReadResult read;
+            (read = readNextBoard(std::cin, problem, options.format)) !=
+                ReadResult::END; ) {
+        number++;
+        if (read == ReadResult::MALFORMED) {
+            std::cout << "error malformed problem " << number << '\n';
+            countedAll = false;
+            continue;
+        }
+        CountResult result = countProblemSolutions(
+                problem, pool, options.nodeLimit, options.search);
+        if (!result.complete)
+            std::cout << "aborted\n";
+        else if (result.overflowed)
+            std::cout << "overflow\n";
+        else
+            std::cout << result.solutions << '\n';
+        countedAll = countedAll && result.complete && !result.overflowed;
+    }
+    return countedAll ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Adds up the counts of the shards of a --count run line by line. A line is
+ * "aborted" or "overflow" if it is in any shard.
+ */
+static int mergeCounts(std::vector<std::ifstream> &inputs) {
+    bool countedAll = true;
+    for (;;) {
+        std::size_t total = 0, ended = 0;
+        bool aborted = false, overflowed = false;
+        for (std::ifstream &input : inputs) {
+            std::string line;
+            if (!std::getline(input, line)) {
+                ended++;
+                continue;
+            }
+            if (line == "aborted") {
+                aborted = true;
+            } else if (line == "overflow") {
+                overflowed = true;
+            } else {
+                std::size_t count = 0, end = 0;
+                try {
+                    if (!line.empty() && line[0] >= '0' && line[0] <= '9')
+                        count = std::stoull(line, &end);
+                } catch (const std::out_of_range &) {
+                }
+                if (end == 0 || end != line.size()) {
+                    std::cerr << "sudoku: not a count: " << line << '\n';
+                    return EXIT_FAILURE;
+                }
+                overflowed = overflowed ||
+                        __builtin_add_overflow(total, count, &total);
+            }
+        }
+        if (ended == inputs.size())
+            break;
+        if (ended != 0) {
+            std::cerr << "sudoku: shards have different numbers of counts\n";
+            return EXIT_FAILURE;
+        }
+
+        if (aborted)
+            std::cout << "aborted\n";
+        else if (overflowed)
+            std::cout << "overflow\n";
+        else
+            std::cout << total << '\n';
+        countedAll = countedAll && !aborted && !overflowed;
+    }
+    return countedAll ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Combines the outputs of the shards of a run given in shard order: counts
+ * are added up and solutions are concatenated, which gives the output of the
+ * run without shards.
+ */
+static int mergeShards(const Options &options) {
+    std::vector<std::ifstream> inputs;
+    for (const std::string &file : options.files) {
+        inputs.emplace_back(file);
+        if (!inputs.back()) {
+            std::cerr << "sudoku: cannot open " << file << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    switch (options.mode) {
+    case Mode::COUNT:
+        return mergeCounts(inputs);
+    case Mode::SOLVE:
+        for (std::ifstream &input : inputs)
+            if (input.peek() != std::ifstream::traits_type::eof())
+                std::cout << input.rdbuf();
+        return std::cout.flush() ? EXIT_SUCCESS : EXIT_FAILURE;
+    default:
+        std::cerr << "sudoku: only solutions and counts can be merged\n";
+        return EXIT_FAILURE;
+    }
+}
+
+static int decodeStreams(const Options &options) {
+    bool decoded = decodeSolutions(std::cin, [](const Board<Number> &) { },
+            [&](const Board<Number> &solution) {
+                writeBoard(std::cout, solution, options.format);
+            });
+    if (!decoded) {
+        std::cerr << "sudoku: the input is not a packed stream\n";
+        return EXIT_FAILURE;
+    }
+    return std::cout.flush() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int benchmarkBackends(const Options &options) {
+    std::vector<Board<Number>> problems;
+    Board<Number> problem;
+    bool readAll = true;
+    std::size_t number = 0;
+    for (ReadResult read;
+            (read = readNextBoard(std::cin, problem, options.format)) !=
+                ReadResult::END; ) {
+        number++;
+        if (read == ReadResult::BOARD) {
+            problems.push_back(problem);
+        } else {
+            std::cerr << "sudoku: malformed problem " << number << '\n';
+            readAll = false;
+        }
+    }
+
+    for (Backend backend : { Backend::CELLS, Backend::BITBOARD }) {
+        SearchOptions search = options.search;
+        search.backend = backend;
+        std::cout << benchmark(problems, search, options.nodeLimit) << '\n';
+    }
+    return std::cout.flush() && readAll ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    try {
+        parseOptions(argc, argv, options);
+    } catch (const std::invalid_argument &e) {
+        std::cerr << "sudoku: " << e.what() << '\n';
+        printUsage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    if (options.help) {
+        printUsage(std::cout);
+        return EXIT_SUCCESS;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    if (!options.loadProfilePath.empty()) {
+        TuningProfile profile;
+        if (!loadProfile(options.loadProfilePath, profile)) {
+            std::cerr << "sudoku: " << options.loadProfilePath <<
+                    " is not a profile\n";
+            return EXIT_FAILURE;
+        }
+        profile.apply(options.search);
+    }
+
+    if (options.merge)
+        return mergeShards(options);
+
+    switch (options.mode) {
+    case Mode::SOLVE:
+        return solveProblem(options);
+    case Mode::BATCH:
+        return solveBatch(options);
+    case Mode::SERVER:
+        return serve(options);
+    case Mode::GENERATE:
+        return generate(options);
+    case Mode::RATE:
+        return rateProblems(options);
+    case Mode::BENCHMARK:
+        return benchmarkBackends(options);
+    case Mode::VALIDATE:
+        return validateProblems(options);
+    case Mode::VERIFY:
+        return verifySolutions(options);
+    case Mode::COUNT:
+        return countProblems(options);
+    case Mode::DECODE:
+        return decodeStreams(options);
+    }
+    return EXIT_FAILURE;
 }
 
 /* vim: set et sw=4 sts=4 tw=79: */
@@ -0,0 +1,89 @@
+#ifndef INCLUDED_SUDOKU_H
+#define INCLUDED_SUDOKU_H 1
+
+/*
+ * The C interface of libsudoku.
+ *
+ * A puzzle or solution is packed as SUDOKU_CELLS bytes in row-major order,
+ * one per cell: 1 to 9 for a number, or 0 for a blank.
+ *
+ * A context keeps the options and the working memory of the solver, so that
+ * solving allocates nothing once the context has solved its first puzzle. A
+ * context must not be used by more than one thread at a time; use one
+ * context per thread instead.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#if defined __GNUC__
+#define SUDOKU_API __attribute__((visibility("default")))
+#else
+#define SUDOKU_API
+#endif
+
+#define SUDOKU_CELLS 81
+
+/* The results of solving a puzzle. */
+enum sudoku_status {
+    /* The puzzle has exactly one solution. */
+    SUDOKU_UNIQUE = 0,
+    /* The puzzle has more than one solution; one of them is returned. */
+    SUDOKU_MULTIPLE = 1,
+    /* The puzzle has no solution. */
+    SUDOKU_INSOLVABLE = 2,
+    /* The node limit ran out before the result was known. */
+    SUDOKU_ABORTED = 3,
+    /* The puzzle has a byte other than 0 to 9. */
+    SUDOKU_INVALID = 4
+};
+
+typedef struct sudoku_context sudoku_context;
+
+/* Returns a new context with the default options, or NULL if out of
+ * memory. */
+SUDOKU_API sudoku_context *sudoku_context_new(void);
+
+SUDOKU_API void sudoku_context_free(sudoku_context *context);
+
+/* Selects the board representation of the search by name: "cells" (the
+ * default) or "bitboard". Returns 0, or -1 for an unknown name. */
+SUDOKU_API int sudoku_set_backend(sudoku_context *context, const char *name);
+
+/* Limits the search nodes per puzzle, or removes the limit if 0. */
+SUDOKU_API void sudoku_set_node_limit(
+        sudoku_context *context, unsigned long long node_limit);
+
+/* Solves a puzzle and, if it has a solution, writes one to "solution".
+ * Returns a sudoku_status. */
+SUDOKU_API int sudoku_solve(
+        sudoku_context *context,
+        const unsigned char *puzzle,
+        unsigned char *solution);
+
+/* Solves "count" puzzles packed one after another in "puzzles", writing the
+ * solution of each, if any, to the same offset of "solutions" and its
+ * status to "statuses" unless it is NULL. Returns the number of puzzles
+ * with a solution. */
+SUDOKU_API size_t sudoku_solve_batch(
+        sudoku_context *context,
+        const unsigned char *puzzles,
+        size_t count,
+        unsigned char *solutions,
+        int *statuses);
+
+/* Returns the name of a status, such as "unique", or "unknown". */
+SUDOKU_API const char *sudoku_status_name(int status);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef INCLUDED_SUDOKU_H */
+
+/* vim: set et sw=4 sts=4 tw=79: */